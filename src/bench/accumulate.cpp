@@ -0,0 +1,150 @@
+#include "bench.h"
+
+#include <all.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace std;
+
+// ---------------------------------------------------------------------------
+// the copying fold that accumulate used before moving the accumulator
+// through op, kept here as the "before" baseline
+
+namespace legacy
+{
+  template <typename InputIt, typename T, typename BinaryOperation>
+  inline T accumulate(InputIt first, InputIt last, T init, BinaryOperation op)
+  {
+    for (; first != last; ++first) {
+      init = op(init, *first);
+    }
+    return init;
+  }
+}
+
+// ---------------------------------------------------------------------------
+// concatenate strings: copying the accumulator makes the fold quadratic
+
+DEF_BENCHMARK(Strings, Accumulate)
+{
+  vector<string> v(bench::size() / 256);
+  acc::generate(v.begin(), v.end(),
+                [i = 0u] () mutable { return to_string(i++); });
+  auto cat = [] (string s, const string& t) { s += t; return s; };
+
+  auto base = bench::time_ms([&] {
+      bench::keep(legacy::accumulate(v.cbegin(), v.cend(), string{}, cat));
+    });
+  bench::report("copying accumulate (before)", base, base);
+  bench::report("acc::accumulate (moved through)",
+                bench::time_ms([&] {
+                    bench::keep(acc::accumulate(v.cbegin(), v.cend(),
+                                                string{}, cat));
+                  }),
+                base);
+  bench::report("acc::accumulate_inplace",
+                bench::time_ms([&] {
+                    bench::keep(acc::accumulate_inplace(
+                        v.cbegin(), v.cend(), string{},
+                        [] (string& s, const string& t) { s += t; }));
+                  }),
+                base);
+}
+
+// ---------------------------------------------------------------------------
+// count occurrences into a map
+
+DEF_BENCHMARK(Map, Accumulate)
+{
+  vector<unsigned> v(bench::size() / 1024);
+  acc::generate(v.begin(), v.end(),
+                [i = 0u] () mutable { return (i++ * 2654435761u) % 1024; });
+  using M = map<unsigned, unsigned>;
+  auto count = [] (M m, unsigned k) { ++m[k]; return m; };
+
+  auto base = bench::time_ms([&] {
+      bench::keep(legacy::accumulate(v.cbegin(), v.cend(), M{}, count));
+    });
+  bench::report("copying accumulate (before)", base, base);
+  bench::report("acc::accumulate (moved through)",
+                bench::time_ms([&] {
+                    bench::keep(acc::accumulate(v.cbegin(), v.cend(),
+                                                M{}, count));
+                  }),
+                base);
+  bench::report("acc::accumulate_inplace",
+                bench::time_ms([&] {
+                    bench::keep(acc::accumulate_inplace(
+                        v.cbegin(), v.cend(), M{},
+                        [] (M& m, unsigned k) { ++m[k]; }));
+                  }),
+                base);
+}
+
+// ---------------------------------------------------------------------------
+// values arriving in batches of 4096: re-fold everything seen so far on each
+// batch, against pushing each batch into an accumulator
+
+DEF_BENCHMARK(Batches, Accumulate)
+{
+  constexpr size_t batch = 4096;
+  vector<int> v(bench::size() / 16);
+  acc::iota(v.begin(), v.end(), 0);
+
+  auto base = bench::time_ms([&] {
+      int r = 0;
+      for (size_t i = batch; i <= v.size(); i += batch) {
+        r = acc::accumulate(v.cbegin(), v.cbegin() + static_cast<ptrdiff_t>(i),
+                            0, plus<>());
+      }
+      bench::keep(r);
+    });
+  bench::report("re-fold on every batch", base, base);
+  bench::report("acc::accumulator push",
+                bench::time_ms([&] {
+                    acc::accumulator<int> a;
+                    for (size_t i = batch; i <= v.size(); i += batch) {
+                      a.push(v.cbegin() + static_cast<ptrdiff_t>(i - batch),
+                             v.cbegin() + static_cast<ptrdiff_t>(i));
+                    }
+                    bench::keep(a.value());
+                  }),
+                base);
+}
+
+// ---------------------------------------------------------------------------
+// sum a file of ints: read it into a vector first, against mapping it (the
+// file is in the page cache for both)
+
+DEF_BENCHMARK(MappedFile, Accumulate)
+{
+  vector<unsigned> v(bench::size());
+  acc::iota(v.begin(), v.end(), 0u);
+  char path[] = "/tmp/acc_bench_XXXXXX";
+  int fd = mkstemp(path);
+  bench::keep(write(fd, v.data(), v.size() * sizeof(unsigned)));
+  close(fd);
+
+  auto base = bench::time_ms([&] {
+      vector<unsigned> w(v.size());
+      FILE* f = fopen(path, "rb");
+      bench::keep(fread(w.data(), sizeof(unsigned), w.size(), f));
+      fclose(f);
+      bench::keep(acc::accumulate(w.cbegin(), w.cend(), 0u, plus<>()));
+    });
+  bench::report("read into a vector, accumulate", base, base);
+  bench::report("acc::mapped_range, accumulate",
+                bench::time_ms([&] {
+                    acc::mapped_range<unsigned> m(path);
+                    bench::keep(acc::accumulate(m.begin(), m.end(),
+                                                0u, plus<>()));
+                  }),
+                base);
+  remove(path);
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// ---------------------------------------------------------------------------
+// A minimal benchmark harness: benchmarks register themselves like testinator
+// tests, and report the best of several timed runs against a baseline.
+
+namespace bench
+{
+  using bench_fn = void (*)();
+
+  struct benchmark
+  {
+    std::string suite;
+    std::string name;
+    bench_fn f;
+  };
+
+  inline std::vector<benchmark>& registry()
+  {
+    static std::vector<benchmark> r;
+    return r;
+  }
+
+  struct registrar
+  {
+    registrar(const char* name, const char* suite, bench_fn f)
+    {
+      registry().push_back(benchmark{ suite, name, f });
+    }
+  };
+
+  // ---------------------------------------------------------------------------
+  // problem size (--size=N) and number of timed runs (--reps=N)
+
+  inline std::size_t& size()
+  {
+    static std::size_t n = std::size_t{1} << 22;
+    return n;
+  }
+
+  inline int& reps()
+  {
+    static int r = 5;
+    return r;
+  }
+
+  // ---------------------------------------------------------------------------
+  // keep a result alive so that the optimizer can't discard its computation
+
+  template <typename T>
+  inline void keep(const T& t)
+  {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r"(&t) : "memory");
+#else
+    static const volatile T* sink;
+    sink = &t;
+#endif
+  }
+
+  // ---------------------------------------------------------------------------
+  // best-of-reps wall time in milliseconds
+
+  template <typename F>
+  inline double time_ms(F&& f)
+  {
+    using clock = std::chrono::steady_clock;
+    double best = 0;
+    for (int i = 0; i < reps(); ++i)
+    {
+      auto start = clock::now();
+      f();
+      std::chrono::duration<double, std::milli> d = clock::now() - start;
+      best = (i == 0) ? d.count() : std::min(best, d.count());
+    }
+    return best;
+  }
+
+  inline void report(const std::string& what, double ms, double baseline_ms)
+  {
+    std::printf("  %-44s %12.3f ms %8.2fx\n",
+                what.c_str(), ms, baseline_ms / ms);
+  }
+
+  // ...and the throughput, for n items processed in ms
+  inline void report(const std::string& what, double ms, double baseline_ms,
+                     std::size_t n)
+  {
+    std::printf("  %-44s %12.3f ms %8.2fx %10.1f M/s\n",
+                what.c_str(), ms, baseline_ms / ms, double(n) / ms / 1e3);
+  }
+}
+
+#define DEF_BENCHMARK(NAME, SUITE)                                      \
+  static void NAME##SUITE##_bench();                                    \
+  static bench::registrar NAME##SUITE##_registrar(                      \
+      #NAME, #SUITE, &NAME##SUITE##_bench);                             \
+  static void NAME##SUITE##_bench()
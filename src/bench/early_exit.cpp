@@ -0,0 +1,142 @@
+#include "bench.h"
+
+#include <all.h>
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <random>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+// ---------------------------------------------------------------------------
+// The exception-based early exit that find and copy_while (and hence merge)
+// used before accumulate_until, kept here as the "before" baseline
+
+namespace legacy
+{
+  template <typename InputIt, typename T>
+  inline InputIt find(InputIt first, InputIt last, const T& value)
+  {
+    try
+    {
+      return acc::accumulate_iter(
+          first, last, last,
+          [&] (const InputIt& a, const InputIt& b) {
+            if (*b == value) throw b;
+            return a;
+          });
+    }
+    catch (InputIt& i)
+    {
+      return i;
+    }
+  }
+
+  template <typename InputIt, typename OutputIt, typename UnaryPredicate>
+  inline std::pair<OutputIt, InputIt> copy_while(
+      InputIt first, InputIt last, OutputIt d_first, UnaryPredicate p)
+  {
+    using P = std::pair<OutputIt, InputIt>;
+    try
+    {
+      OutputIt o = acc::accumulate_iter(
+          first, last, d_first,
+          [&] (OutputIt d, InputIt a) {
+            if (!p(*a)) throw P{ d, a };
+            *d = *a;
+            return ++d;
+          });
+      return P{ o, last };
+    }
+    catch (P& p)
+    {
+      return p;
+    }
+  }
+
+  template <typename InputIt1, typename InputIt2,
+            typename OutputIt, typename Compare>
+  inline OutputIt merge(
+      InputIt1 first1, InputIt1 last1,
+      InputIt2 first2, InputIt2 last2,
+      OutputIt d_first, Compare comp)
+  {
+    using P = std::pair<OutputIt, InputIt2>;
+    using T = typename std::iterator_traits<InputIt2>::value_type;
+    P p = acc::accumulate_iter(
+        first1, last1, P{ d_first, first2 },
+        [&] (P a, const InputIt1& b) {
+          a = legacy::copy_while(
+              a.second, last2, a.first,
+              [&] (const T& t) { return comp(t, *b); });
+          *a.first = *b;
+          ++a.first;
+          return a;
+        });
+    return acc::copy(p.second, last2, p.first);
+  }
+}
+
+// ---------------------------------------------------------------------------
+// many short searches, half of which miss
+
+DEF_BENCHMARK(Find, EarlyExit)
+{
+  vector<unsigned> v(1024);
+  acc::iota(v.begin(), v.end(), 0u);
+  mt19937 g(0);
+  vector<unsigned> keys(bench::size() / v.size() + 1);
+  acc::generate(keys.begin(), keys.end(), [&] { return g() % (2 * v.size()); });
+
+  auto run = [&] (auto f) {
+    return bench::time_ms([&] {
+        size_t found = 0;
+        for (auto k : keys) found += f(v.cbegin(), v.cend(), k) != v.cend();
+        bench::keep(found);
+      });
+  };
+
+  auto base = run([] (auto f, auto l, auto k) { return std::find(f, l, k); });
+  bench::report("std::find", base, base);
+  bench::report("acc::find (throwing, before)",
+                run([] (auto f, auto l, auto k) { return legacy::find(f, l, k); }),
+                base);
+  bench::report("acc::find (accumulate_until)",
+                run([] (auto f, auto l, auto k) { return acc::find(f, l, k); }),
+                base);
+}
+
+// ---------------------------------------------------------------------------
+// merge two interleaved sorted ranges: copy_while exits once per element
+
+DEF_BENCHMARK(Merge, EarlyExit)
+{
+  auto n = bench::size() / 2;
+  vector<unsigned> a(n);
+  vector<unsigned> b(n);
+  mt19937 g(0);
+  acc::generate(a.begin(), a.end(), g);
+  acc::generate(b.begin(), b.end(), g);
+  std::sort(a.begin(), a.end());
+  std::sort(b.begin(), b.end());
+  vector<unsigned> out(2 * n);
+
+  auto run = [&] (auto f) {
+    return bench::time_ms([&] {
+        bench::keep(f(a.cbegin(), a.cend(), b.cbegin(), b.cend(),
+                      out.begin(), less<>{}));
+      });
+  };
+
+  auto base = run([] (auto... args) { return std::merge(args...); });
+  bench::report("std::merge", base, base);
+  bench::report("acc::merge (throwing, before)",
+                run([] (auto... args) { return legacy::merge(args...); }),
+                base);
+  bench::report("acc::merge (accumulate_until)",
+                run([] (auto... args) { return acc::merge(args...); }),
+                base);
+}
@@ -0,0 +1,34 @@
+#include "bench.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+// usage: bench_accumulate-fun [--size=N] [--reps=N] [--suite=S] [--name=N]
+int main(int argc, char* argv[])
+{
+  std::string suite;
+  std::string name;
+  for (int i = 1; i < argc; ++i)
+  {
+    std::string arg = argv[i];
+    auto value = arg.substr(arg.find('=') + 1);
+    if (arg.find("--size=") == 0)
+      bench::size() = std::strtoull(value.c_str(), nullptr, 10);
+    else if (arg.find("--reps=") == 0)
+      bench::reps() = std::atoi(value.c_str());
+    else if (arg.find("--suite=") == 0)
+      suite = value;
+    else if (arg.find("--name=") == 0)
+      name = value;
+  }
+
+  for (const auto& b : bench::registry())
+  {
+    if (!suite.empty() && suite != b.suite) continue;
+    if (!name.empty() && name != b.name) continue;
+    std::printf("%s.%s (n = %zu)\n",
+                b.suite.c_str(), b.name.c_str(), bench::size());
+    b.f();
+  }
+}
@@ -0,0 +1,67 @@
+#include "bench.h"
+
+#include <all.h>
+
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// ---------------------------------------------------------------------------
+// reduce: scaling against accumulate at 1..N threads
+
+DEF_BENCHMARK(SumDoubles, Reduce)
+{
+  vector<double> v(bench::size());
+  acc::iota(v.begin(), v.end(), 0.0);
+
+  double r = 0;
+  auto base = bench::time_ms([&] {
+      r = acc::accumulate(v.cbegin(), v.cend(), 0.0, plus<>());
+      bench::keep(r);
+    });
+  bench::report("acc::accumulate", base, base);
+
+  auto hw = thread::hardware_concurrency();
+  for (unsigned t = 1; t <= (hw == 0 ? 1 : hw); ++t)
+  {
+    auto ms = bench::time_ms([&] {
+        r = acc::reduce(acc::execution::par(t),
+                        v.cbegin(), v.cend(), 0.0, plus<>());
+        bench::keep(r);
+      });
+    bench::report("acc::reduce par, " + to_string(t) + " threads", ms, base);
+  }
+}
+
+// ---------------------------------------------------------------------------
+// unsequenced reduce: several accumulators against one dependency chain
+
+DEF_BENCHMARK(UnseqDoubles, Reduce)
+{
+  vector<double> v(bench::size());
+  acc::iota(v.begin(), v.end(), 0.0);
+
+  auto min_op = [] (double a, double b) { return b < a ? b : a; };
+  auto max_op = [] (double a, double b) { return a < b ? b : a; };
+
+  auto run = [&] (const string& name, auto op) {
+    double r = 0;
+    auto base = bench::time_ms([&] {
+        r = acc::accumulate(v.cbegin(), v.cend(), v[0], op);
+        bench::keep(r);
+      });
+    bench::report("acc::accumulate " + name, base, base);
+    auto ms = bench::time_ms([&] {
+        r = acc::reduce(acc::execution::unseq, v.cbegin(), v.cend(), v[0], op);
+        bench::keep(r);
+      });
+    bench::report("acc::reduce unseq " + name, ms, base);
+  };
+
+  run("plus", plus<>());
+  run("min", min_op);
+  run("max", max_op);
+}
@@ -0,0 +1,88 @@
+#include "bench.h"
+
+#include <all.h>
+
+#include <functional>
+#include <numeric>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// ---------------------------------------------------------------------------
+// SIMD kernels against the scalar fold, on each instruction set the host has
+
+namespace
+{
+  const char* isa_names[] = { "scalar", "sse2", "avx2", "avx512" };
+
+  template <typename T, typename Tag>
+  void run_kernels(const string& name, const vector<T>& v)
+  {
+    T r{};
+    auto base = bench::time_ms([&] {
+        r = acc::simd::identity<T>(Tag{});
+        for (auto x : v) r = acc::simd::apply(Tag{}, r, x);
+        bench::keep(r);
+      });
+    bench::report(name + " scalar loop", base, base);
+
+    for (int i = 1; i <= static_cast<int>(acc::simd::best_isa()); ++i)
+    {
+      auto k = acc::simd::kernels<T>(static_cast<acc::simd::isa>(i)).fold[Tag::index];
+      if (!k) continue;
+      auto ms = bench::time_ms([&] {
+          r = k(v.data(), v.size());
+          bench::keep(r);
+        });
+      bench::report(name + " " + isa_names[i], ms, base);
+    }
+  }
+}
+
+DEF_BENCHMARK(FoldKernels, Simd)
+{
+  vector<int> vi(bench::size());
+  acc::iota(vi.begin(), vi.end(), 0);
+  vector<float> vf(vi.cbegin(), vi.cend());
+  vector<double> vd(vi.cbegin(), vi.cend());
+
+  using namespace acc::simd;
+  run_kernels<int, op_plus>("int plus", vi);
+  run_kernels<int, op_max>("int max", vi);
+  run_kernels<int, op_bit_xor>("int xor", vi);
+  run_kernels<float, op_plus>("float plus", vf);
+  run_kernels<double, op_plus>("double plus", vd);
+  run_kernels<double, op_min>("double min", vd);
+}
+
+DEF_BENCHMARK(Dispatch, Simd)
+{
+  vector<int> vi(bench::size());
+  acc::iota(vi.begin(), vi.end(), 0);
+  vector<double> vd(vi.cbegin(), vi.cend());
+
+  int ri = 0;
+  auto base = bench::time_ms([&] {
+      ri = std::accumulate(vi.cbegin(), vi.cend(), 0, plus<>());
+      bench::keep(ri);
+    });
+  bench::report("std::accumulate int plus", base, base);
+  bench::report("acc::accumulate int plus", bench::time_ms([&] {
+        ri = acc::accumulate(vi.cbegin(), vi.cend(), 0, plus<>());
+        bench::keep(ri);
+      }), base);
+
+  double rd = 0;
+  base = bench::time_ms([&] {
+      rd = std::inner_product(vd.cbegin(), vd.cend(), vd.cbegin(), 0.0);
+      bench::keep(rd);
+    });
+  bench::report("std::inner_product double", base, base);
+  bench::report("acc::inner_product unseq double", bench::time_ms([&] {
+        rd = acc::inner_product(acc::execution::unseq,
+                                vd.cbegin(), vd.cend(), vd.cbegin(), 0.0,
+                                plus<>(), multiplies<>());
+        bench::keep(rd);
+      }), base);
+}
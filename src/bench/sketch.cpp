@@ -0,0 +1,414 @@
+#include "bench.h"
+
+#include <all.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <iterator>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+// ---------------------------------------------------------------------------
+// count distinct values: an exact set, against a hyperloglog fed one value at
+// a time and in batches
+
+DEF_BENCHMARK(HyperLogLog, Sketch)
+{
+  vector<uint64_t> v(bench::size());
+  acc::generate(v.begin(), v.end(),
+                [i = uint64_t{0}] () mutable { return i++ * 2654435761u % 1000000; });
+
+  auto base = bench::time_ms([&] {
+      unordered_set<uint64_t> s(v.cbegin(), v.cend());
+      bench::keep(s.size());
+    });
+  bench::report("unordered_set (exact)", base, base);
+  bench::report("hyperloglog<14> insert(x)",
+                bench::time_ms([&] {
+                    acc::hyperloglog<14> h;
+                    for (auto x : v) h.insert(x);
+                    bench::keep(h);
+                  }),
+                base);
+  bench::report("hyperloglog<14> insert(first, last)",
+                bench::time_ms([&] {
+                    acc::hyperloglog<14> h;
+                    h.insert(v.cbegin(), v.cend());
+                    bench::keep(h);
+                  }),
+                base);
+
+  // merging sketches is independent of the stream size
+  acc::hyperloglog<14> a, b;
+  a.insert(v.cbegin(), v.cend());
+  b.insert(v.cbegin(), v.cend());
+  bench::report("hyperloglog<14> merge (x1000)",
+                bench::time_ms([&] {
+                    for (int i = 0; i < 1000; ++i) a.merge(b);
+                    bench::keep(a);
+                  }),
+                base);
+}
+
+// ---------------------------------------------------------------------------
+// count occurrences of skewed keys: an exact map, against count-min sketches
+
+DEF_BENCHMARK(CountMinSketch, Sketch)
+{
+  vector<uint64_t> v(bench::size());
+  acc::generate(v.begin(), v.end(),
+                [i = uint64_t{0}] () mutable {
+                  auto r = (i++ * 2654435761u) % 1000000;
+                  return r * r / 1000000;
+                });
+  using cms = acc::count_min_sketch<4096, 4>;
+  using conservative = acc::conservative_count_min_sketch<4096, 4>;
+
+  auto base = bench::time_ms([&] {
+      unordered_map<uint64_t, uint64_t> m;
+      for (auto x : v) ++m[x];
+      bench::keep(m.size());
+    });
+  bench::report("unordered_map<Key, uint64_t> (exact)", base, base, v.size());
+  bench::report("count_min_sketch<4096, 4> insert(x)",
+                bench::time_ms([&] {
+                    cms s;
+                    for (auto x : v) s.insert(x);
+                    bench::keep(s);
+                  }),
+                base, v.size());
+  bench::report("count_min_sketch<4096, 4> insert(first, last)",
+                bench::time_ms([&] {
+                    cms s;
+                    s.insert(v.cbegin(), v.cend());
+                    bench::keep(s);
+                  }),
+                base, v.size());
+  bench::report("conservative insert(first, last)",
+                bench::time_ms([&] {
+                    conservative s;
+                    s.insert(v.cbegin(), v.cend());
+                    bench::keep(s);
+                  }),
+                base, v.size());
+
+  // too big for the cache: the batch path prefetches
+  using large = acc::count_min_sketch<1 << 20, 4>;
+  bench::report("count_min_sketch<1<<20, 4> insert(x)",
+                bench::time_ms([&] {
+                    large s;
+                    for (auto x : v) s.insert(x);
+                    bench::keep(s);
+                  }),
+                base, v.size());
+  bench::report("count_min_sketch<1<<20, 4> insert(first, last)",
+                bench::time_ms([&] {
+                    large s;
+                    s.insert(v.cbegin(), v.cend());
+                    bench::keep(s);
+                  }),
+                base, v.size());
+}
+
+// ---------------------------------------------------------------------------
+// membership tests against 1M values, half of them present: an exact set,
+// against a Bloom filter at 16 bits a value, probed one at a time and in
+// batches
+
+DEF_BENCHMARK(BloomFilter, Sketch)
+{
+  vector<uint64_t> keys(1 << 20);
+  acc::generate(keys.begin(), keys.end(),
+                [i = uint64_t{0}] () mutable { return i++ * 2654435761u; });
+  vector<uint64_t> v(bench::size());
+  acc::generate(v.begin(), v.end(),
+                [i = uint64_t{0}] () mutable {
+                  auto k = i++ * 0x9e3779b97f4a7c15ull >> 43;
+                  return k * 2654435761u + (k & 1);
+                });
+  unordered_set<uint64_t> s(keys.cbegin(), keys.cend());
+  acc::bloom_filter<1 << 24> f;
+  f.insert(keys.cbegin(), keys.cend());
+  vector<bool> r(v.size());
+
+  auto base = bench::time_ms([&] {
+      acc::transform(v.cbegin(), v.cend(), r.begin(),
+                     [&] (uint64_t x) { return s.count(x) != 0; });
+      bench::keep(r);
+    });
+  bench::report("unordered_set count (exact)", base, base, v.size());
+  bench::report("bloom_filter contains(x)",
+                bench::time_ms([&] {
+                    acc::transform(v.cbegin(), v.cend(), r.begin(),
+                                   [&] (uint64_t x) { return f.contains(x); });
+                    bench::keep(r);
+                  }),
+                base, v.size());
+  bench::report("bloom_filter contains(first, last, out)",
+                bench::time_ms([&] {
+                    f.contains(v.cbegin(), v.cend(), r.begin());
+                    bench::keep(r);
+                  }),
+                base, v.size());
+}
+
+// ---------------------------------------------------------------------------
+// join a large unsorted range against a small sorted one, with few matches:
+// sort it and intersect, against filtering it by the small side first
+
+DEF_BENCHMARK(JoinPrefilter, Sketch)
+{
+  vector<uint64_t> a(bench::size());
+  acc::generate(a.begin(), a.end(),
+                [i = uint64_t{0}] () mutable { return i++ * 0x9e3779b97f4a7c15ull >> 20; });
+  vector<uint64_t> b(1 << 16);
+  acc::generate(b.begin(), b.end(),
+                [i = uint64_t{0}] () mutable { return i++ * 2654435761u; });
+  for (size_t i = 0; i < b.size(); i += 16) b[i] = a[i * 8];
+  sort(b.begin(), b.end());
+
+  auto base = bench::time_ms([&] {
+      auto c = a;
+      sort(c.begin(), c.end());
+      vector<uint64_t> out;
+      acc::set_intersection(c.cbegin(), c.cend(), b.cbegin(), b.cend(),
+                            back_inserter(out), less<>());
+      bench::keep(out);
+    });
+  bench::report("sort, set_intersection", base, base);
+  bench::report("bloom_filter, copy_if, sort, set_intersection",
+                bench::time_ms([&] {
+                    acc::bloom_filter<1 << 20> f;
+                    f.insert(b.cbegin(), b.cend());
+                    vector<uint64_t> c;
+                    acc::copy_if(a.cbegin(), a.cend(), back_inserter(c),
+                                 [&] (uint64_t x) { return f.contains(x); });
+                    sort(c.begin(), c.end());
+                    vector<uint64_t> out;
+                    acc::set_intersection(c.cbegin(), c.cend(),
+                                          b.cbegin(), b.cend(),
+                                          back_inserter(out), less<>());
+                    bench::keep(out);
+                  }),
+                base);
+}
+
+// ---------------------------------------------------------------------------
+// the 100 greatest values: std::partial_sort_copy, against top_n fed one
+// value at a time and in batches
+
+DEF_BENCHMARK(TopN, Sketch)
+{
+  vector<unsigned> v(bench::size());
+  acc::generate(v.begin(), v.end(),
+                [i = 0u] () mutable { return i++ * 2654435761u; });
+  vector<unsigned> r(100);
+
+  auto base = bench::time_ms([&] {
+      partial_sort_copy(v.cbegin(), v.cend(), r.begin(), r.end(), greater<>());
+      bench::keep(r);
+    });
+  bench::report("std::partial_sort_copy", base, base, v.size());
+  bench::report("top_n<unsigned, 100> insert(x)",
+                bench::time_ms([&] {
+                    acc::top_n<unsigned, 100> t;
+                    for (auto x : v) t.insert(x);
+                    bench::keep(t);
+                  }),
+                base, v.size());
+  bench::report("top_n<unsigned, 100> insert(first, last)",
+                bench::time_ms([&] {
+                    acc::top_n<unsigned, 100> t;
+                    t.insert(v.cbegin(), v.cend());
+                    bench::keep(t);
+                  }),
+                base, v.size());
+}
+
+// ---------------------------------------------------------------------------
+// a histogram of slowly varying values, so that neighbours share a bin:
+// acc::accumulate into a vector of counts, against histogram fed one value at
+// a time and in batches
+
+DEF_BENCHMARK(Histogram, Sketch)
+{
+  vector<double> v(bench::size());
+  acc::generate(v.begin(), v.end(),
+                [i = 0u] () mutable {
+                  auto x = i++;
+                  return (x >> 6) % 100 + (x * 2654435761u >> 28) / 16.0;
+                });
+  acc::uniform_bins bins(0, 100, 100);
+
+  auto base = bench::time_ms([&] {
+      auto c = acc::accumulate(v.cbegin(), v.cend(), vector<size_t>(102),
+                               [&] (vector<size_t> c, double x) {
+                                 ++c[bins.index(x)];
+                                 return c;
+                               });
+      bench::keep(c);
+    });
+  bench::report("accumulate into vector<size_t>", base, base, v.size());
+  bench::report("histogram insert(x)",
+                bench::time_ms([&] {
+                    acc::histogram<> h(bins);
+                    for (auto x : v) h.insert(x);
+                    bench::keep(h);
+                  }),
+                base, v.size());
+  bench::report("histogram insert(first, last)",
+                bench::time_ms([&] {
+                    acc::histogram<> h(bins);
+                    h.insert(v.cbegin(), v.cend());
+                    bench::keep(h);
+                  }),
+                base, v.size());
+}
+
+// ---------------------------------------------------------------------------
+// mean and variance: two passes of acc::accumulate, against moments fed one
+// value at a time and in batches
+
+DEF_BENCHMARK(Moments, Sketch)
+{
+  vector<double> v(bench::size());
+  acc::generate(v.begin(), v.end(),
+                [i = 0u] () mutable { return 1e6 + (i++ * 2654435761u >> 16); });
+
+  auto base = bench::time_ms([&] {
+      auto mean = acc::accumulate(v.cbegin(), v.cend(), 0.0, plus<>{})
+        / static_cast<double>(v.size());
+      auto m2 = acc::accumulate(v.cbegin(), v.cend(), 0.0,
+                                [mean] (double s, double x) {
+                                  return s + (x - mean) * (x - mean);
+                                });
+      bench::keep(m2);
+    });
+  bench::report("two passes of accumulate", base, base, v.size());
+  bench::report("moments insert(x)",
+                bench::time_ms([&] {
+                    acc::moments<> m;
+                    for (auto x : v) m.insert(x);
+                    bench::keep(m);
+                  }),
+                base, v.size());
+  bench::report("moments insert(first, last)",
+                bench::time_ms([&] {
+                    acc::moments<> m;
+                    m.insert(v.cbegin(), v.cend());
+                    bench::keep(m);
+                  }),
+                base, v.size());
+}
+
+// ---------------------------------------------------------------------------
+// p50, p99 and p999 of long-tailed values: a copy and acc::nth_element,
+// against t_digests of increasing compression, with their memory and the
+// error in the rank of their p999
+
+namespace
+{
+  template <size_t Delta>
+  void report_t_digest(const vector<double>& v, const vector<double>& sorted,
+                       double base)
+  {
+    acc::t_digest<Delta> d;
+    auto ms = bench::time_ms([&] {
+        d = acc::t_digest<Delta>{};
+        d.insert(v.cbegin(), v.cend());
+        double q[] = { d.quantile(0.5), d.quantile(0.99), d.quantile(0.999) };
+        bench::keep(q);
+      });
+    bench::report("t_digest<" + to_string(Delta) + "> insert(first, last)",
+                  ms, base, v.size());
+    auto x = d.quantile(0.999);
+    auto rank = static_cast<double>(
+        lower_bound(sorted.cbegin(), sorted.cend(), x) - sorted.cbegin());
+    printf("    %zu bytes, p999 rank error %.2e\n",
+           d.size() * 2 * sizeof(double),
+           abs(rank / static_cast<double>(v.size()) - 0.999));
+  }
+}
+
+DEF_BENCHMARK(TDigest, Sketch)
+{
+  vector<double> v(bench::size());
+  acc::generate(v.begin(), v.end(),
+                [i = 0u] () mutable {
+                  auto u = static_cast<double>(i++ * 2654435761u % 1000003) / 1000003.0;
+                  return -log1p(-u) * 10.0;
+                });
+  auto sorted = v;
+  sort(sorted.begin(), sorted.end());
+
+  auto base = bench::time_ms([&] {
+      auto c = v;
+      double q[3];
+      size_t i = 0;
+      for (double p : { 0.5, 0.99, 0.999 }) {
+        auto nth = c.begin() + static_cast<ptrdiff_t>(p * static_cast<double>(c.size()));
+        acc::nth_element(c.begin(), nth, c.end(), less<>{});
+        q[i++] = *nth;
+      }
+      bench::keep(q);
+    });
+  bench::report("copy, nth_element (exact)", base, base, v.size());
+  printf("    %zu bytes\n", v.size() * sizeof(double));
+  report_t_digest<50>(v, sorted, base);
+  report_t_digest<100>(v, sorted, base);
+  report_t_digest<200>(v, sorted, base);
+  report_t_digest<500>(v, sorted, base);
+}
+
+// ---------------------------------------------------------------------------
+// a decayed average of timestamped values: acc::inner_product with an exp2
+// per value, against decayed fed one value at a time and from arrays
+
+DEF_BENCHMARK(Decayed, Sketch)
+{
+  vector<double> t(bench::size()), x(bench::size());
+  acc::generate(t.begin(), t.end(),
+                [i = 0u] () mutable {
+                  auto j = i++;
+                  // roughly increasing, with some out of order
+                  return j * 0.001 + (j * 2654435761u >> 24) * 1e-3;
+                });
+  acc::generate(x.begin(), x.end(),
+                [i = 0u] () mutable { return static_cast<double>(i++ * 2654435761u >> 20); });
+  auto now = *max_element(t.cbegin(), t.cend());
+
+  using P = pair<double, double>;
+  auto base = bench::time_ms([&] {
+      auto r = acc::inner_product(t.cbegin(), t.cend(), x.cbegin(), P{ 0, 0 },
+                                  [] (P a, P b) { return P{ a.first + b.first,
+                                                            a.second + b.second }; },
+                                  [now] (double ti, double xi) {
+                                    auto w = exp2(-(now - ti) / 60.0);
+                                    return P{ w, w * xi };
+                                  });
+      bench::keep(r);
+    });
+  bench::report("inner_product with exp2 per value", base, base, t.size());
+  bench::report("decayed insert(x)",
+                bench::time_ms([&] {
+                    acc::decayed d(60);
+                    for (size_t i = 0; i < t.size(); ++i) d.insert({ t[i], x[i] });
+                    bench::keep(d);
+                  }),
+                base, t.size());
+  bench::report("decayed insert(tfirst, tlast, vfirst)",
+                bench::time_ms([&] {
+                    acc::decayed d(60);
+                    d.insert(t.cbegin(), t.cend(), x.cbegin());
+                    bench::keep(d);
+                  }),
+                base, t.size());
+}
@@ -0,0 +1,289 @@
+#include "bench.h"
+
+#include <all.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// ---------------------------------------------------------------------------
+// sort: acc::sort against std::sort on the inputs that tell sorts apart.
+// Each run sorts a fresh copy, so the copy is in both times.
+
+namespace
+{
+  vector<unsigned int> input(const string& shape, size_t n)
+  {
+    vector<unsigned int> v(n);
+    for (size_t i = 0; i < n; ++i) {
+      auto x = static_cast<unsigned int>(i);
+      if (shape == "random") {
+        v[i] = static_cast<unsigned int>(acc::hash_mix(i));
+      } else if (shape == "sorted") {
+        v[i] = x;
+      } else if (shape == "reversed") {
+        v[i] = static_cast<unsigned int>(n - i);
+      } else if (shape == "organ pipe") {
+        v[i] = static_cast<unsigned int>(min(i, n - i));
+      } else {
+        // a few distinct values
+        v[i] = static_cast<unsigned int>(acc::hash_mix(i) >> 60);
+      }
+    }
+    return v;
+  }
+}
+
+// The comparison sorts get a lambda rather than std::less, which acc::sort
+// would hand to radix_sort; the last line of each shape is acc::sort as
+// called plainly, radix and all.
+
+DEF_BENCHMARK(Introsort, Sort)
+{
+  auto by_value = [] (unsigned int a, unsigned int b) { return a < b; };
+  for (const string shape : { "random", "sorted", "reversed", "organ pipe",
+                              "16 distinct" }) {
+    const auto v = input(shape, bench::size());
+    vector<unsigned int> w;
+    auto base = bench::time_ms([&] {
+        w = v;
+        std::sort(w.begin(), w.end(), by_value);
+        bench::keep(w);
+      });
+    bench::report("std::sort " + shape, base, base, v.size());
+    auto ms = bench::time_ms([&] {
+        w = v;
+        acc::sort(w.begin(), w.end(), by_value);
+        bench::keep(w);
+      });
+    bench::report("acc::sort " + shape, ms, base, v.size());
+    ms = bench::time_ms([&] {
+        w = v;
+        acc::sort(w.begin(), w.end());
+        bench::keep(w);
+      });
+    bench::report("acc::sort by radix " + shape, ms, base, v.size());
+  }
+}
+
+// ---------------------------------------------------------------------------
+// partition, sort and nth_element on shuffled 64-bit keys, where the
+// branches of a partition on each element mispredict half the time (hashed,
+// because a multiplicative sequence like i * 2654435761 is regular enough
+// for the branch predictor to learn)
+
+DEF_BENCHMARK(Keys64, Sort)
+{
+  vector<uint64_t> v(bench::size());
+  for (size_t i = 0; i < v.size(); ++i) v[i] = acc::hash_mix(i);
+  auto pivot = v[v.size() / 2];
+  auto below = [pivot] (uint64_t x) { return x < pivot; };
+  auto by_value = [] (uint64_t a, uint64_t b) { return a < b; };
+  vector<uint64_t> w;
+
+  auto base = bench::time_ms([&] {
+      w = v;
+      bench::keep(std::partition(w.begin(), w.end(), below));
+    });
+  bench::report("std::partition", base, base, v.size());
+  auto ms = bench::time_ms([&] {
+      w = v;
+      bench::keep(acc::partition(w.begin(), w.end(), below));
+    });
+  bench::report("acc::partition", ms, base, v.size());
+
+  base = bench::time_ms([&] {
+      w = v;
+      std::sort(w.begin(), w.end(), by_value);
+      bench::keep(w);
+    });
+  bench::report("std::sort", base, base, v.size());
+  ms = bench::time_ms([&] {
+      w = v;
+      acc::sort(w.begin(), w.end(), by_value);
+      bench::keep(w);
+    });
+  bench::report("acc::sort", ms, base, v.size());
+
+  auto mid = static_cast<ptrdiff_t>(v.size() / 2);
+  base = bench::time_ms([&] {
+      w = v;
+      std::nth_element(w.begin(), w.begin() + mid, w.end());
+      bench::keep(w);
+    });
+  bench::report("std::nth_element", base, base, v.size());
+  ms = bench::time_ms([&] {
+      w = v;
+      acc::nth_element(w.begin(), w.begin() + mid, w.end());
+      bench::keep(w);
+    });
+  bench::report("acc::nth_element", ms, base, v.size());
+}
+
+// ---------------------------------------------------------------------------
+// radix_sort against std::sort on IDs and timestamps, at each power of ten
+// from 10^3 up to --size
+
+namespace
+{
+  template <typename T, typename Make>
+  void radix_vs_sort(const string& name, Make make)
+  {
+    for (size_t n = 1000; n <= bench::size(); n *= 10) {
+      vector<T> v(n);
+      for (size_t i = 0; i < n; ++i) v[i] = make(i);
+      vector<T> w;
+      auto tag = name + " 10^" + to_string(static_cast<int>(log10(n) + 0.5));
+      auto base = bench::time_ms([&] {
+          w = v;
+          std::sort(w.begin(), w.end());
+          bench::keep(w);
+        });
+      bench::report("std::sort " + tag, base, base, n);
+      auto ms = bench::time_ms([&] {
+          w = v;
+          acc::radix_sort(w.begin(), w.end());
+          bench::keep(w);
+        });
+      bench::report("acc::radix_sort " + tag, ms, base, n);
+    }
+  }
+}
+
+DEF_BENCHMARK(Radix, Sort)
+{
+  radix_vs_sort<uint32_t>("uint32", [] (size_t i) {
+      return static_cast<uint32_t>(acc::hash_mix(i));
+    });
+  radix_vs_sort<uint64_t>("uint64", [] (size_t i) {
+      return acc::hash_mix(i);
+    });
+  // timestamps: seconds over a year, to the microsecond
+  radix_vs_sort<double>("double", [] (size_t i) {
+      return static_cast<double>(acc::hash_mix(i) % 31536000000000ull) * 1e-6;
+    });
+
+  // records by a key
+  struct event { uint64_t id; double time; };
+  vector<event> v(bench::size());
+  for (size_t i = 0; i < v.size(); ++i) {
+    v[i] = { acc::hash_mix(i), static_cast<double>(i) };
+  }
+  vector<event> w;
+  auto base = bench::time_ms([&] {
+      w = v;
+      std::sort(w.begin(), w.end(),
+                [] (const event& a, const event& b) { return a.id < b.id; });
+      bench::keep(w);
+    });
+  bench::report("std::sort records by id", base, base, v.size());
+  auto ms = bench::time_ms([&] {
+      w = v;
+      acc::radix_sort(w.begin(), w.end(), [] (const event& e) { return e.id; });
+      bench::keep(w);
+    });
+  bench::report("acc::radix_sort records by id", ms, base, v.size());
+}
+
+// ---------------------------------------------------------------------------
+// stable_sort against std::stable_sort on event records by timestamp, in the
+// orders event logs come in
+
+namespace
+{
+  struct event { double time; uint64_t id; };
+
+  vector<event> events(const string& shape, size_t n)
+  {
+    vector<event> v(n);
+    for (size_t i = 0; i < n; ++i) {
+      auto h = acc::hash_mix(i);
+      auto t = static_cast<double>(i);
+      if (shape == "random") {
+        t = static_cast<double>(h % n);
+      } else if (shape == "reversed") {
+        t = static_cast<double>(n - i);
+      } else if (shape == "nearly sorted") {
+        // one in a hundred arrives up to a second late
+        if (h % 100 == 0) t -= static_cast<double>(h % 1000);
+      } else if (shape == "8 logs") {
+        // eight sorted logs of interleaved times, one after another
+        auto log = i * 8 / n;
+        t = static_cast<double>((i - log * n / 8) * 8 + log);
+      }
+      v[i] = { t, h };
+    }
+    return v;
+  }
+}
+
+DEF_BENCHMARK(StableSort, Sort)
+{
+  auto by_time = [] (const event& a, const event& b) { return a.time < b.time; };
+  for (const string shape : { "random", "sorted", "nearly sorted", "reversed",
+                              "8 logs" }) {
+    const auto v = events(shape, bench::size());
+    vector<event> w;
+    auto base = bench::time_ms([&] {
+        w = v;
+        std::stable_sort(w.begin(), w.end(), by_time);
+        bench::keep(w);
+      });
+    bench::report("std::stable_sort " + shape, base, base, v.size());
+    auto ms = bench::time_ms([&] {
+        w = v;
+        acc::stable_sort(w.begin(), w.end(), by_time);
+        bench::keep(w);
+      });
+    bench::report("acc::stable_sort " + shape, ms, base, v.size());
+  }
+}
+
+// ---------------------------------------------------------------------------
+// partial_sort and partial_sort_copy: the k smallest of shuffled 64-bit keys,
+// against std:: and against sorting the lot
+
+DEF_BENCHMARK(PartialSort, Sort)
+{
+  vector<uint64_t> v(bench::size());
+  for (size_t i = 0; i < v.size(); ++i) v[i] = acc::hash_mix(i);
+  vector<uint64_t> w;
+
+  for (size_t k : { size_t{10}, size_t{1000}, v.size() / 2 }) {
+    auto tag = " k = " + to_string(k);
+    auto middle = static_cast<ptrdiff_t>(k);
+    auto base = bench::time_ms([&] {
+        w = v;
+        std::partial_sort(w.begin(), w.begin() + middle, w.end());
+        bench::keep(w);
+      });
+    bench::report("std::partial_sort" + tag, base, base, v.size());
+    auto ms = bench::time_ms([&] {
+        w = v;
+        acc::partial_sort(w.begin(), w.begin() + middle, w.end());
+        bench::keep(w);
+      });
+    bench::report("acc::partial_sort" + tag, ms, base, v.size());
+    ms = bench::time_ms([&] {
+        w = v;
+        acc::sort(w.begin(), w.end());
+        bench::keep(w);
+      });
+    bench::report("acc::sort of all" + tag, ms, base, v.size());
+
+    vector<uint64_t> d(k);
+    base = bench::time_ms([&] {
+        bench::keep(std::partial_sort_copy(v.cbegin(), v.cend(), d.begin(), d.end()));
+      });
+    bench::report("std::partial_sort_copy" + tag, base, base, v.size());
+    ms = bench::time_ms([&] {
+        bench::keep(acc::partial_sort_copy(v.cbegin(), v.cend(), d.begin(), d.end()));
+      });
+    bench::report("acc::partial_sort_copy" + tag, ms, base, v.size());
+  }
+}
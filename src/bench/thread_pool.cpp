@@ -0,0 +1,90 @@
+#include "bench.h"
+
+#include <all.h>
+
+#include <algorithm>
+#include <atomic>
+#include <future>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+// ---------------------------------------------------------------------------
+// the cost of spawning and syncing empty tasks, against a thread per task
+
+DEF_BENCHMARK(Spawn, ThreadPool)
+{
+  auto n = bench::size() / 256;
+  atomic<size_t> count{0};
+
+  auto base = bench::time_ms([&] {
+      vector<future<void>> fs;
+      fs.reserve(n);
+      for (size_t i = 0; i < n; ++i) {
+        fs.push_back(async(launch::async, [&] { ++count; }));
+      }
+      for (auto& f : fs) f.get();
+    });
+  bench::report("std::async", base, base);
+  bench::report("acc::task_group spawn/sync",
+                bench::time_ms([&] {
+                    acc::task_group g;
+                    for (size_t i = 0; i < n; ++i) g.spawn([&] { ++count; });
+                    g.sync();
+                  }),
+                base);
+  bench::keep(count.load());
+}
+
+// ---------------------------------------------------------------------------
+// nested fork-join: a binary tree of tasks, one per leaf range of 1024
+
+namespace
+{
+  size_t tree(size_t b, size_t e)
+  {
+    if (e - b <= 1024) return 1;
+    size_t l = 0;
+    size_t r = 0;
+    auto m = b + (e - b) / 2;
+    acc::fork_join([&] { l = tree(b, m); }, [&] { r = tree(m, e); });
+    return l + r;
+  }
+}
+
+DEF_BENCHMARK(ForkJoin, ThreadPool)
+{
+  auto ms = bench::time_ms([&] { bench::keep(tree(0, bench::size())); });
+  bench::report("fork_join tree", ms, ms);
+}
+
+// ---------------------------------------------------------------------------
+// the recursive algorithms, sequential against parallel
+
+DEF_BENCHMARK(Sort, ThreadPool)
+{
+  vector<unsigned> v(bench::size());
+  mt19937 g(0);
+  acc::generate(v.begin(), v.end(), g);
+
+  auto run = [&] (auto f) {
+    return bench::time_ms([&, w = vector<unsigned>{}] () mutable {
+        w = v;
+        f(w.begin(), w.end());
+        bench::keep(w.front());
+      });
+  };
+
+  auto base = run([] (auto f, auto l) { std::sort(f, l); });
+  bench::report("std::sort", base, base);
+  bench::report("acc::sort",
+                run([] (auto f, auto l) { acc::sort(f, l); }), base);
+  bench::report("acc::sort par",
+                run([] (auto f, auto l) { acc::sort(acc::execution::par, f, l); }),
+                base);
+  bench::report("acc::stable_sort par",
+                run([] (auto f, auto l) {
+                    acc::stable_sort(acc::execution::par, f, l); }),
+                base);
+}
@@ -1,28 +1,247 @@
 #pragma once
 
+#include "config.h"
+#include "simd.h"
+
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
 namespace acc
 {
+  namespace detail
+  {
+    template <typename InputIt, typename T, typename BinaryOperation>
+    ACC_CONSTEXPR17 T accumulate(
+        InputIt first, InputIt last, T init, BinaryOperation op,
+        std::false_type)
+    {
+      for (; first != last; ++first) {
+        init = op(std::move(init), *first);
+      }
+      return init;
+    }
+
+    // a contiguous range of integers with an operation that a SIMD kernel
+    // knows: reassociating the fold can't change the result
+    template <typename InputIt, typename T, typename BinaryOperation>
+    ACC_CONSTEXPR17 T accumulate(
+        InputIt first, InputIt last, T init, BinaryOperation op,
+        std::true_type)
+    {
+      if (ACC_IS_CONSTANT_EVALUATED()) {
+        return accumulate(first, last, std::move(init), op, std::false_type{});
+      }
+      if (first == last) return init;
+      return simd::fold(simd::to_pointer(first),
+                        static_cast<std::size_t>(last - first), init, op);
+    }
+
+    template <typename InputIt, typename T, typename BinaryOperation>
+    using simd_accumulate = std::integral_constant<
+      bool,
+      simd::is_contiguous<InputIt>::value
+      && std::is_same<typename std::iterator_traits<InputIt>::value_type, T>::value
+      && simd::exact_fold<T, BinaryOperation>::value>;
+  }
 
   // ---------------------------------------------------------------------------
   // accumulate (ordinary value form)
+  //
+  // The accumulator is moved through op, so an op that takes it by value and
+  // returns it doesn't copy it.
   template <typename InputIt, typename T, typename BinaryOperation>
-  inline auto accumulate(
+  ACC_CONSTEXPR17 auto accumulate(
+      InputIt first, InputIt last, T init, BinaryOperation op)
+  {
+    return detail::accumulate(
+        first, last, std::move(init), op,
+        detail::simd_accumulate<InputIt, T, BinaryOperation>{});
+  }
+
+  // ---------------------------------------------------------------------------
+  // accumulate (iterator form)
+  template <typename InputIt, typename T, typename BinaryOperation>
+  ACC_CONSTEXPR17 auto accumulate_iter(
       InputIt first, InputIt last, T init, BinaryOperation op)
   {
     for (; first != last; ++first) {
-      init = op(init, *first);
+      init = op(std::move(init), first);
     }
     return init;
   }
 
   // ---------------------------------------------------------------------------
-  // accumulate (iterator form)
+  // accumulate (in-place value form)
+  //
+  // op mutates the accumulator through a reference, as op(T&, *first), and
+  // returns nothing: for state that is cheaper to update than to rebuild
+
+  template <typename InputIt, typename T, typename Operation>
+  ACC_CONSTEXPR17 T accumulate_inplace(
+      InputIt first, InputIt last, T init, Operation op)
+  {
+    for (; first != last; ++first) {
+      op(init, *first);
+    }
+    return init;
+  }
+
+  // ---------------------------------------------------------------------------
+  // accumulate (in-place iterator form)
+
+  template <typename InputIt, typename T, typename Operation>
+  ACC_CONSTEXPR17 T accumulate_iter_inplace(
+      InputIt first, InputIt last, T init, Operation op)
+  {
+    for (; first != last; ++first) {
+      op(init, first);
+    }
+    return init;
+  }
+
+  // ---------------------------------------------------------------------------
+  // accumulate (continuation form)
+  //
+  // What a fold into a chain of closures computes, where each element x wraps
+  // the continuation k as [k, x] (s) { return k(op(s, x)); } and the chain is
+  // then run on init: op applied from the last element back to the first.
+  // Every closure in such a chain runs the same code and differs only in x,
+  // so the frames are kept flat and run in a loop. A bidirectional range is
+  // simply walked backwards; a forward range records its iterators, and an
+  // input range its values, in one buffer.
+
+  namespace detail
+  {
+    template <typename BidirIt, typename T, typename Operation>
+    ACC_CONSTEXPR17 T accumulate_iter_cont(
+        BidirIt first, BidirIt last, T init, Operation op,
+        std::bidirectional_iterator_tag)
+    {
+      while (last != first) {
+        init = op(std::move(init), --last);
+      }
+      return init;
+    }
+
+    template <typename ForwardIt, typename T, typename Operation>
+    inline T accumulate_iter_cont(
+        ForwardIt first, ForwardIt last, T init, Operation op,
+        std::forward_iterator_tag)
+    {
+      std::vector<ForwardIt> frames;
+      frames.reserve(static_cast<std::size_t>(std::distance(first, last)));
+      for (; first != last; ++first) {
+        frames.push_back(first);
+      }
+      for (auto i = frames.size(); i > 0; --i) {
+        init = op(std::move(init), frames[i-1]);
+      }
+      return init;
+    }
+
+    template <typename ForwardIt, typename T, typename Operation>
+    ACC_CONSTEXPR17 T accumulate_cont(
+        ForwardIt first, ForwardIt last, T init, Operation op,
+        std::forward_iterator_tag)
+    {
+      return accumulate_iter_cont(
+          first, last, std::move(init),
+          [&] (T a, const ForwardIt& i) { return op(std::move(a), *i); },
+          typename std::iterator_traits<ForwardIt>::iterator_category{});
+    }
+
+    template <typename InputIt, typename T, typename Operation>
+    inline T accumulate_cont(
+        InputIt first, InputIt last, T init, Operation op,
+        std::input_iterator_tag)
+    {
+      std::vector<typename std::iterator_traits<InputIt>::value_type> frames;
+      for (; first != last; ++first) {
+        frames.push_back(*first);
+      }
+      for (auto i = frames.size(); i > 0; --i) {
+        init = op(std::move(init), frames[i-1]);
+      }
+      return init;
+    }
+  }
+
+  template <typename InputIt, typename T, typename BinaryOperation>
+  ACC_CONSTEXPR17 T accumulate_cont(
+      InputIt first, InputIt last, T init, BinaryOperation op)
+  {
+    return detail::accumulate_cont(
+        first, last, std::move(init), op,
+        typename std::iterator_traits<InputIt>::iterator_category{});
+  }
+
+  // ---------------------------------------------------------------------------
+  // accumulate (continuation iterator form), for forward iterators
+
+  template <typename ForwardIt, typename T, typename BinaryOperation>
+  ACC_CONSTEXPR17 T accumulate_iter_cont(
+      ForwardIt first, ForwardIt last, T init, BinaryOperation op)
+  {
+    return detail::accumulate_iter_cont(
+        first, last, std::move(init), op,
+        typename std::iterator_traits<ForwardIt>::iterator_category{});
+  }
+
+  // ---------------------------------------------------------------------------
+  // step: the result of an op for the short-circuit forms below. It carries
+  // the new accumulated value and whether the fold is done.
+
+  template <typename T>
+  struct step
+  {
+    T value;
+    bool done;
+  };
+
+  template <typename T>
+  ACC_CONSTEXPR17 step<std::decay_t<T>> cont(T&& t)
+  {
+    return { std::forward<T>(t), false };
+  }
+
+  template <typename T>
+  ACC_CONSTEXPR17 step<std::decay_t<T>> done(T&& t)
+  {
+    return { std::forward<T>(t), true };
+  }
+
+  // ---------------------------------------------------------------------------
+  // accumulate (short-circuit value form)
+  //
+  // op returns acc::cont(x) to carry on with x, or acc::done(x) to stop the
+  // fold with result x: an early exit costs a branch rather than an unwind
+
+  template <typename InputIt, typename T, typename BinaryOperation>
+  ACC_CONSTEXPR17 auto accumulate_until(
+      InputIt first, InputIt last, T init, BinaryOperation op)
+  {
+    for (; first != last; ++first) {
+      auto s = op(std::move(init), *first);
+      init = std::move(s.value);
+      if (s.done) break;
+    }
+    return init;
+  }
+
+  // ---------------------------------------------------------------------------
+  // accumulate (short-circuit iterator form)
+
   template <typename InputIt, typename T, typename BinaryOperation>
-  inline auto accumulate_iter(
+  ACC_CONSTEXPR17 auto accumulate_iter_until(
       InputIt first, InputIt last, T init, BinaryOperation op)
   {
     for (; first != last; ++first) {
-      init = op(init, first);
+      auto s = op(std::move(init), first);
+      init = std::move(s.value);
+      if (s.done) break;
     }
     return init;
   }
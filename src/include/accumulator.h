@@ -0,0 +1,75 @@
+#pragma once
+
+#include "accumulate.h"
+#include "monoid.h"
+
+#include <functional>
+#include <type_traits>
+#include <utility>
+
+// ---------------------------------------------------------------------------
+// accumulator
+//
+// A fold that is fed incrementally: push values or batches as they arrive,
+// and read value() at any point. A batch goes through acc::accumulate, so it
+// gets the same SIMD kernels as a range fold, and the work per batch is
+// proportional to the batch.
+//
+// Accumulators fed separately (e.g. one per thread) combine with merge, which
+// folds the other's value in as if its pushes had come after ours: for the
+// result to be the fold of everything pushed, op must be associative.
+//
+
+namespace acc
+{
+  template <typename T, typename Op = std::plus<>>
+  class accumulator
+  {
+  public:
+    // start from op's identity, when acc::monoid knows it
+    template <typename M = monoid<Op, T>,
+              typename = std::enable_if_t<M::has_identity>>
+    accumulator()
+      : value_(M::identity()), op_()
+    {}
+
+    explicit accumulator(T init, Op op = Op{})
+      : value_(std::move(init)), op_(std::move(op))
+    {}
+
+    template <typename U>
+    void push(U&& x)
+    {
+      value_ = op_(std::move(value_), std::forward<U>(x));
+    }
+
+    template <typename InputIt>
+    void push(InputIt first, InputIt last)
+    {
+      value_ = acc::accumulate(first, last, std::move(value_), op_);
+    }
+
+    void merge(const accumulator& other)
+    {
+      value_ = op_(std::move(value_), other.value_);
+    }
+
+    void merge(accumulator&& other)
+    {
+      value_ = op_(std::move(value_), std::move(other.value_));
+    }
+
+    const T& value() const { return value_; }
+
+  private:
+    T value_;
+    Op op_;
+  };
+
+  template <typename T, typename Op>
+  inline accumulator<T, Op> make_accumulator(T init, Op op)
+  {
+    return accumulator<T, Op>(std::move(init), std::move(op));
+  }
+
+}
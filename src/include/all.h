@@ -1,6 +1,29 @@
 #pragma once
 
 #include "accumulate.h"
+#include "accumulator.h"
+#include "bloom_filter.h"
+#include "config.h"
+#include "count_min_sketch.h"
+#include "decayed.h"
+#include "execution.h"
+#include "functional.h"
+#include "hash.h"
+#include "histogram.h"
+#include "hyperloglog.h"
+#include "moments.h"
+#include "monoid.h"
+#include "reduce.h"
+#include "serialize.h"
+#include "simd.h"
+#include "t_digest.h"
+#include "thread_pool.h"
+#include "top_n.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include "distributed.h"
+#include "mapped_range.h"
+#endif
 
 #include "binsearch_ops.h"
 #include "heap_ops.h"
@@ -15,16 +38,20 @@
 //  1/ 1 accumulate itself
 //
 //  0/ 4 binary search ops
-//  3/ 6 heap ops
+//  6/ 6 heap ops
 // 10/10 min/max ops
 // 27/27 modifying sequence ops
 // 16/16 non-modifying sequence ops
 //  4/ 4 numeric ops
 //  4/ 5 partitioning ops
 //  7/ 7 set ops
-//  5/ 7 sorting ops
+//  7/ 7 sorting ops
 //
-// 77/87 total
+// 82/87 total
 
 // not included in the 87:
 // iter_swap, swap, random_shuffle
+//
+// C++17 additions:
+// reduce
+// transform_reduce
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <type_traits>
+
+// ---------------------------------------------------------------------------
+// configuration
+//
+// ACC_CONSTEXPR17 marks the folds and the algorithms built on them: constexpr
+// from C++17, which allows constexpr lambdas, and plain inline before that.
+// An algorithm that swaps, or that folds with a std::pair of state, can only
+// be evaluated at compile time under C++20: std::iter_swap and assignment of
+// std::pair are constexpr only from then. The parallel and allocating paths
+// are never constexpr.
+//
+// ACC_IS_CONSTANT_EVALUATED() is true during constant evaluation, so that a
+// fold can skip its SIMD kernels there. Without compiler support it is always
+// false, and a fold that would use a kernel isn't a constant expression.
+//
+// ACC_PREFETCH(p) hints that *p is about to be written, and
+// ACC_PREFETCH_READ(p) that it is about to be read, for sketches that touch
+// scattered memory; without compiler support they do nothing.
+//
+
+#if __cplusplus >= 201703L
+#define ACC_CONSTEXPR17 constexpr
+#else
+#define ACC_CONSTEXPR17 inline
+#endif
+
+// (before C++17 nothing is constexpr, and GCC warns that the test in an
+// inline function is always false)
+#if __cplusplus < 201703L
+#define ACC_IS_CONSTANT_EVALUATED() false
+#elif defined(__cpp_lib_is_constant_evaluated)
+#define ACC_IS_CONSTANT_EVALUATED() std::is_constant_evaluated()
+#elif defined(__has_builtin)
+#if __has_builtin(__builtin_is_constant_evaluated)
+#define ACC_IS_CONSTANT_EVALUATED() __builtin_is_constant_evaluated()
+#endif
+#elif defined(__GNUC__) && __GNUC__ >= 9
+#define ACC_IS_CONSTANT_EVALUATED() __builtin_is_constant_evaluated()
+#endif
+
+#ifndef ACC_IS_CONSTANT_EVALUATED
+#define ACC_IS_CONSTANT_EVALUATED() false
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define ACC_PREFETCH(p) __builtin_prefetch((p), 1)
+#define ACC_PREFETCH_READ(p) __builtin_prefetch((p), 0)
+#else
+#define ACC_PREFETCH(p) static_cast<void>(p)
+#define ACC_PREFETCH_READ(p) static_cast<void>(p)
+#endif
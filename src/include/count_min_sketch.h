@@ -0,0 +1,213 @@
+#pragma once
+
+#include "accumulate.h"
+#include "config.h"
+#include "functional.h"
+#include "hash.h"
+#include "monoid.h"
+#include "serialize.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+// ---------------------------------------------------------------------------
+// count_min_sketch
+//
+// An estimate of how often each value occurs in a stream, from D rows of W
+// counters. Each value is counted once in every row, at a column picked by
+// that row's hash, and its estimate is the least of its D counters: never
+// below the true count, and above it by more than e/W of the stream's total
+// with probability at most e^-D. The memory is fixed whatever the number of
+// distinct values.
+//
+// With conservative update (the third parameter, or the
+// conservative_count_min_sketch alias) an insert raises only the counters
+// that are below the new estimate, which cuts the overestimate for rare
+// values a lot on skewed streams, at the cost of a read before the writes.
+//
+// merge adds the counters element-wise, so that the merge of two sketches
+// (with the same parameters) is the sketch of both streams, with nothing lost.
+//
+// insert(first, last) on a sketch too big for the cache hashes a block of
+// values once each, works out every row's column and prefetches its counter,
+// and only then updates the block's counters, so that their misses overlap.
+//
+
+namespace acc
+{
+  template <std::size_t W, std::size_t D,
+            bool Conservative = false, typename Hash = hash64>
+  class count_min_sketch
+  {
+    static_assert(W > 0 && D > 0, "count_min_sketch needs at least one counter");
+
+  public:
+    using count_type = std::uint64_t;
+    static constexpr std::size_t width = W;
+    static constexpr std::size_t depth = D;
+
+    count_min_sketch() : counters_(W * D) {}
+    explicit count_min_sketch(Hash h) : counters_(W * D), hash_(std::move(h)) {}
+
+    template <typename U>
+    void insert(const U& x, count_type n = 1)
+    {
+      std::size_t cols[D];
+      columns(hash_(x), cols);
+      add(cols, n);
+    }
+
+    // constrained to iterators, so that insert(x, n) with a count of the
+    // key's own type is still the weighted insert
+    template <typename InputIt, typename = typename
+              std::iterator_traits<InputIt>::iterator_category>
+    void insert(InputIt first, InputIt last)
+    {
+      // while the counters fit in cache, out-of-order execution already
+      // overlaps the updates; beyond that, the counters of a whole block are
+      // prefetched before any is updated
+      if (W * D * sizeof(count_type) <= cached_bytes) {
+        for (; first != last; ++first) insert(*first);
+        return;
+      }
+      std::size_t cols[block][D];
+      while (first != last) {
+        std::size_t n = 0;
+        for (; n < block && first != last; ++first, ++n) {
+          columns(hash_(*first), cols[n]);
+          prefetch(cols[n]);
+        }
+        for (std::size_t k = 0; k < n; ++k) add(cols[k], 1);
+      }
+    }
+
+    template <typename U>
+    count_type estimate(const U& x) const
+    {
+      std::size_t cols[D];
+      columns(hash_(x), cols);
+      return min_count(cols);
+    }
+
+    void merge(const count_min_sketch& other)
+    {
+      auto c = counters_.data();
+      auto o = other.counters_.data();
+      for (std::size_t i = 0; i < W * D; ++i) c[i] += o[i];
+      total_ += other.total_;
+    }
+
+    // the number of values inserted, which bounds the error of an estimate
+    count_type total() const { return total_; }
+
+    // with probability 1 - e^-D, an estimate is within error() * total()
+    static double error() { return std::exp(1.0) / W; }
+
+    friend bool operator==(const count_min_sketch& a, const count_min_sketch& b)
+    {
+      return a.total_ == b.total_ && a.counters_ == b.counters_;
+    }
+
+    friend bool operator!=(const count_min_sketch& a, const count_min_sketch& b)
+    {
+      return !(a == b);
+    }
+
+  private:
+    friend struct serializer<count_min_sketch>;
+
+    static constexpr std::size_t block = 32;
+    static constexpr std::size_t cached_bytes = std::size_t{1} << 20;
+
+    // the counter of each row, by double hashing: row d takes column
+    // h1 + d * h2, where h2 is odd
+    static void columns(std::uint64_t h, std::size_t* cols)
+    {
+      auto h1 = static_cast<std::uint32_t>(h);
+      auto h2 = static_cast<std::uint32_t>(h >> 32) | 1u;
+      for (std::size_t d = 0; d < D; ++d) {
+        cols[d] = d * W + static_cast<std::uint32_t>(h1 + d * h2) % W;
+      }
+    }
+
+    void prefetch(const std::size_t* cols) const
+    {
+      for (std::size_t d = 0; d < D; ++d) ACC_PREFETCH(&counters_[cols[d]]);
+    }
+
+    count_type min_count(const std::size_t* cols) const
+    {
+      auto c = counters_.data();
+      return acc::accumulate(cols, cols + D, c[cols[0]],
+                             [c] (count_type m, std::size_t i) {
+                               return std::min(m, c[i]);
+                             });
+    }
+
+    void add(const std::size_t* cols, count_type n)
+    {
+      total_ += n;
+      auto c = counters_.data();
+      if (Conservative) {
+        auto e = min_count(cols) + n;
+        for (std::size_t d = 0; d < D; ++d) c[cols[d]] = std::max(c[cols[d]], e);
+      } else {
+        for (std::size_t d = 0; d < D; ++d) c[cols[d]] += n;
+      }
+    }
+
+    std::vector<count_type> counters_;
+    count_type total_ = 0;
+    Hash hash_;
+  };
+
+  template <std::size_t W, std::size_t D, typename Hash = hash64>
+  using conservative_count_min_sketch = count_min_sketch<W, D, true, Hash>;
+
+  // ---------------------------------------------------------------------------
+  // the merge monoid
+
+  template <std::size_t W, std::size_t D, bool C, typename Hash>
+  struct monoid<merge_op, count_min_sketch<W, D, C, Hash>>
+    : detail::commutative_monoid<count_min_sketch<W, D, C, Hash>>
+  {
+    static constexpr bool has_absorbing = false;
+    static count_min_sketch<W, D, C, Hash> identity() { return {}; }
+  };
+
+  // ---------------------------------------------------------------------------
+  // serialization: the total, then the counters as varints, since most of
+  // them are small
+
+  template <std::size_t W, std::size_t D, bool C, typename Hash>
+  struct serializer<count_min_sketch<W, D, C, Hash>>
+  {
+    using S = count_min_sketch<W, D, C, Hash>;
+
+    static void save(std::vector<char>& out, const S& s)
+    {
+      detail::save_varint(out, s.total_);
+      for (auto c : s.counters_) detail::save_varint(out, c);
+    }
+
+    static S load(const char*& p, const char* end)
+    {
+      S s;
+      s.total_ = detail::load_varint(p, end);
+      for (auto& c : s.counters_) {
+        c = detail::load_varint(p, end);
+        if (c > s.total_) {
+          throw std::runtime_error("acc::load: bad count_min_sketch");
+        }
+      }
+      return s;
+    }
+  };
+
+}
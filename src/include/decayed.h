@@ -0,0 +1,275 @@
+#pragma once
+
+#include "functional.h"
+#include "monoid.h"
+#include "simd.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+// ---------------------------------------------------------------------------
+// decayed
+//
+// Exponentially decayed count, sum and average of timestamped values: a
+// value x at time t counts with weight 2^-((now - t) / half_life), so recent
+// values dominate without a window to recompute. Timestamps are doubles in
+// any unit, with the half-life in the same one.
+//
+// The weights are kept as of a reference time, the latest timestamp seen, so
+// they never exceed one. Values may arrive out of order: an older value just
+// comes in with a smaller weight. merge rescales the older of the two to the
+// later reference time and adds, losing nothing, and the empty aggregate
+// with no half-life of its own takes on that of whatever it's merged with.
+// decayed is trivially copyable, so acc::serializer already sends it between
+// processes.
+//
+// insert(first, last) takes (timestamp, value) pairs, and insert(tfirst,
+// tlast, vfirst) separate arrays of timestamps and values. Both work a block
+// at a time: the block's values are weighted as of its latest timestamp by
+// an exp that vectorizes (rather than a call to std::exp per value), summed,
+// and added in with one rescale.
+//
+
+namespace acc
+{
+  namespace detail
+  {
+    // e^x for x <= 0, to within a few ulps (or 1e-13 with fast math, which
+    // undoes the split of ln2), in straight-line code that vectorizes; 0 below
+    // -708, where e^x is about to go subnormal
+    inline double exp_nonpositive(double x)
+    {
+      constexpr double log2e = 1.4426950408889634;
+      constexpr double ln2_hi = 6.93147180369123816490e-01;
+      constexpr double ln2_lo = 1.90821492927058770002e-10;
+      // without branches, or the loops calling it won't vectorize
+      auto keep = static_cast<double>(x >= -708.0);
+      x = std::max(x, -708.0);
+      // x = k ln2 + r, with |r| <= ln2 / 2, then e^x = 2^k e^r
+      auto k = static_cast<std::int32_t>(x * log2e - 0.5);
+      auto fk = static_cast<double>(k);
+      auto r = (x - fk * ln2_hi) - fk * ln2_lo;
+      // Taylor to r^13 is exact to double precision for |r| <= ln2 / 2
+      auto p = 1.0 / 6227020800.0;
+      p = p * r + 1.0 / 479001600.0;
+      p = p * r + 1.0 / 39916800.0;
+      p = p * r + 1.0 / 3628800.0;
+      p = p * r + 1.0 / 362880.0;
+      p = p * r + 1.0 / 40320.0;
+      p = p * r + 1.0 / 5040.0;
+      p = p * r + 1.0 / 720.0;
+      p = p * r + 1.0 / 120.0;
+      p = p * r + 1.0 / 24.0;
+      p = p * r + 1.0 / 6.0;
+      p = p * r + 0.5;
+      p = p * r + 1.0;
+      p = p * r + 1.0;
+      auto bits = static_cast<std::uint64_t>(k + 1023) << 52;
+      double scale;
+      std::memcpy(&scale, &bits, sizeof(scale));
+      return keep * p * scale;
+    }
+  }
+
+  class decayed
+  {
+  public:
+    // no half-life: values inserted don't decay, and while empty it takes on
+    // the half-life of whatever is merged into it
+    decayed() = default;
+
+    explicit decayed(double half_life) : rate_(std::log(2.0) / half_life)
+    {
+      if (!(half_life > 0)) {
+        throw std::invalid_argument("acc::decayed: half-life must be positive");
+      }
+    }
+
+    // a value x at time t
+    void insert(const std::pair<double, double>& e)
+    {
+      auto t = e.first;
+      if (n_ == 0 || t > time_) {
+        rescale(t);
+        count_ += 1;
+        sum_ += e.second;
+      } else {
+        auto w = std::exp(rate_ * (t - time_));
+        count_ += w;
+        sum_ += w * e.second;
+      }
+      ++n_;
+    }
+
+    // a range of (timestamp, value) pairs
+    template <typename InputIt>
+    void insert(InputIt first, InputIt last)
+    {
+      double t[block], x[block];
+      while (first != last) {
+        std::size_t n = 0;
+        for (; n < block && first != last; ++first, ++n) {
+          const auto& e = *first;
+          t[n] = static_cast<double>(e.first);
+          x[n] = static_cast<double>(e.second);
+        }
+        insert_block(t, x, n);
+      }
+    }
+
+    // timestamps from [tfirst, tlast), with values from vfirst
+    template <typename TimeIt, typename ValueIt>
+    void insert(TimeIt tfirst, TimeIt tlast, ValueIt vfirst)
+    {
+      insert_arrays(tfirst, tlast, vfirst,
+                    std::integral_constant<bool, is_double_array<TimeIt>::value
+                                           && is_double_array<ValueIt>::value>{});
+    }
+
+    void merge(const decayed& other)
+    {
+      // an empty aggregate (the identity among them) keeps its own
+      // half-life, and only takes on other's if it has none
+      if (other.n_ == 0) {
+        if (rate_ == 0) rate_ = other.rate_;
+        return;
+      }
+      if (n_ == 0) {
+        if (rate_ != 0 && rate_ != other.rate_) {
+          throw std::invalid_argument("acc::decayed: merge with a different half-life");
+        }
+        *this = other;
+        return;
+      }
+      if (rate_ != other.rate_) {
+        throw std::invalid_argument("acc::decayed: merge with a different half-life");
+      }
+      auto t = std::max(time_, other.time_);
+      rescale(t);
+      auto s = std::exp(rate_ * (other.time_ - t));
+      count_ += other.count_ * s;
+      sum_ += other.sum_ * s;
+      n_ += other.n_;
+    }
+
+    // the decayed count and sum as of time t (not before time())
+    double count(double t) const { return count_ * decay_to(t); }
+    double sum(double t) const { return sum_ * decay_to(t); }
+
+    // the decayed average, which is the same as of any time
+    double average() const { return count_ > 0 ? sum_ / count_ : 0.0; }
+
+    // the latest timestamp seen, and the number of values
+    double time() const { return time_; }
+    std::uint64_t size() const { return n_; }
+    bool empty() const { return n_ == 0; }
+
+    double half_life() const { return std::log(2.0) / rate_; }
+
+    friend bool operator==(const decayed& a, const decayed& b)
+    {
+      return a.rate_ == b.rate_ && a.time_ == b.time_ && a.count_ == b.count_
+        && a.sum_ == b.sum_ && a.n_ == b.n_;
+    }
+
+    friend bool operator!=(const decayed& a, const decayed& b)
+    {
+      return !(a == b);
+    }
+
+  private:
+    static constexpr std::size_t block = 256;
+
+    template <typename It>
+    using is_double_array = std::integral_constant<
+      bool,
+      simd::is_contiguous<It>::value
+      && std::is_same<typename std::iterator_traits<It>::value_type, double>::value>;
+
+    double decay_to(double t) const
+    {
+      return n_ == 0 ? 0.0 : std::exp(rate_ * (time_ - t));
+    }
+
+    // move the reference time forward to t
+    void rescale(double t)
+    {
+      if (n_ != 0) {
+        auto s = std::exp(rate_ * (time_ - t));
+        count_ *= s;
+        sum_ *= s;
+      }
+      time_ = t;
+    }
+
+    // weigh a block as of its latest timestamp, and add it in
+    void insert_block(const double* t, const double* x, std::size_t n)
+    {
+      if (n == 0) return;
+      auto latest = t[0];
+      for (std::size_t i = 1; i < n; ++i) latest = std::max(latest, t[i]);
+      if (n_ != 0) latest = std::max(latest, time_);
+
+      double c = 0, s = 0;
+      for (std::size_t i = 0; i < n; ++i) {
+        auto w = detail::exp_nonpositive(rate_ * (t[i] - latest));
+        c += w;
+        s += w * x[i];
+      }
+      rescale(latest);
+      count_ += c;
+      sum_ += s;
+      n_ += n;
+    }
+
+    template <typename TimeIt, typename ValueIt>
+    void insert_arrays(TimeIt tfirst, TimeIt tlast, ValueIt vfirst, std::false_type)
+    {
+      double t[block], x[block];
+      while (tfirst != tlast) {
+        std::size_t n = 0;
+        for (; n < block && tfirst != tlast; ++tfirst, ++vfirst, ++n) {
+          t[n] = static_cast<double>(*tfirst);
+          x[n] = static_cast<double>(*vfirst);
+        }
+        insert_block(t, x, n);
+      }
+    }
+
+    template <typename TimeIt, typename ValueIt>
+    void insert_arrays(TimeIt tfirst, TimeIt tlast, ValueIt vfirst, std::true_type)
+    {
+      if (tfirst == tlast) return;
+      auto t = simd::to_pointer(tfirst);
+      auto x = simd::to_pointer(vfirst);
+      auto n = static_cast<std::size_t>(tlast - tfirst);
+      for (std::size_t i = 0; i < n; i += block) {
+        insert_block(t + i, x + i, std::min(std::size_t{block}, n - i));
+      }
+    }
+
+    double rate_ = 0;
+    double time_ = 0;
+    double count_ = 0;
+    double sum_ = 0;
+    std::uint64_t n_ = 0;
+  };
+
+  // ---------------------------------------------------------------------------
+  // the merge monoid
+
+  template <>
+  struct monoid<merge_op, decayed> : detail::commutative_monoid<decayed>
+  {
+    static constexpr bool has_absorbing = false;
+    static decayed identity() { return {}; }
+  };
+
+}
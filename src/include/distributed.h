@@ -0,0 +1,231 @@
+#pragma once
+
+#include "accumulate.h"
+#include "mapped_range.h"
+#include "reduce.h"
+#include "serialize.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <iterator>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// ---------------------------------------------------------------------------
+// fork_reduce and fork_transform_reduce (POSIX only)
+//
+// Reduce a random access range in separate worker processes, one per shard.
+// Each worker folds its shard, serializes the partial result with
+// acc::serializer and writes it to a pipe; the parent reads the partials
+// back and combines them in shard order with op, which must be associative
+// (it need not be commutative).
+//
+// The workers are forked, so they see the parent's memory without copying
+// it: over an acc::mapped_range they share the file's pages. A worker that
+// fails, or whose result doesn't deserialize, makes the call throw
+// std::runtime_error.
+//
+
+namespace acc
+{
+  namespace detail
+  {
+    inline void write_all(int fd, const char* p, std::size_t n)
+    {
+      while (n > 0) {
+        auto w = ::write(fd, p, n);
+        if (w < 0) {
+          if (errno == EINTR) continue;
+          throw std::system_error(errno, std::generic_category(), "write");
+        }
+        p += w;
+        n -= static_cast<std::size_t>(w);
+      }
+    }
+
+    inline bool read_all(int fd, std::vector<char>& buf)
+    {
+      char chunk[4096];
+      for (;;) {
+        auto r = ::read(fd, chunk, sizeof chunk);
+        if (r < 0) {
+          if (errno == EINTR) continue;
+          return false;
+        }
+        if (r == 0) return true;
+        buf.insert(buf.end(), chunk, chunk + r);
+      }
+    }
+
+    // a pipe whose ends aren't inherited across exec, so that neither a later
+    // worker nor a program run by another thread holds an earlier one open;
+    // where there's no pipe2, the flag is set just after, which leaves a gap
+    inline bool open_pipe(int fds[2])
+    {
+#if defined(__linux__) || defined(__FreeBSD__) || defined(__NetBSD__) \
+  || defined(__OpenBSD__)
+      return ::pipe2(fds, O_CLOEXEC) == 0;
+#else
+      if (::pipe(fds) != 0) return false;
+      ::fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+      ::fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+      return true;
+#endif
+    }
+
+    // -------------------------------------------------------------------------
+    // run f(s) for each shard s in a child process of its own, and return the
+    // children's results in shard order
+
+    template <typename T, typename F>
+    inline std::vector<T> fork_shards(std::size_t shards, F f)
+    {
+      struct worker
+      {
+        pid_t pid;
+        int fd;
+      };
+      std::vector<worker> workers;
+      workers.reserve(shards);
+
+      bool ok = true;
+      for (std::size_t s = 0; s < shards && ok; ++s) {
+        int fds[2];
+        if (!open_pipe(fds)) {
+          ok = false;
+          break;
+        }
+        pid_t pid = ::fork();
+        if (pid < 0) {
+          ::close(fds[0]);
+          ::close(fds[1]);
+          ok = false;
+          break;
+        }
+        if (pid == 0) {
+          // the earlier workers' pipes are the parent's alone
+          for (const auto& w : workers) ::close(w.fd);
+          ::close(fds[0]);
+          int status = 0;
+          try {
+            std::vector<char> out;
+            acc::save(out, f(s));
+            write_all(fds[1], out.data(), out.size());
+          } catch (...) {
+            status = 1;
+          }
+          ::_exit(status);
+        }
+        // close our copy of the write end, so that EOF means the child is done
+        ::close(fds[1]);
+        workers.push_back(worker{ pid, fds[0] });
+      }
+
+      // reap every child we started, whatever happened
+      std::vector<std::vector<char>> results(workers.size());
+      for (std::size_t s = 0; s < workers.size(); ++s) {
+        ok = read_all(workers[s].fd, results[s]) && ok;
+        ::close(workers[s].fd);
+        int status = 0;
+        while (::waitpid(workers[s].pid, &status, 0) < 0 && errno == EINTR) {}
+        ok = ok && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+      }
+      if (!ok) throw std::runtime_error("acc::fork_reduce: a worker failed");
+
+      std::vector<T> partials;
+      partials.reserve(results.size());
+      for (const auto& r : results) {
+        const char* p = r.data();
+        const char* end = p + r.size();
+        partials.push_back(acc::load<T>(p, end));
+        if (p != end) {
+          throw std::runtime_error("acc::fork_reduce: a worker's result has trailing bytes");
+        }
+      }
+      return partials;
+    }
+  }
+
+  // ---------------------------------------------------------------------------
+  // fork_transform_reduce: processes == 0 means one per hardware thread; with
+  // one process, or one element, no process is forked
+
+  template <typename RandomIt, typename T,
+            typename BinaryOperation, typename UnaryOperation>
+  inline T fork_transform_reduce(
+      std::size_t processes,
+      RandomIt first, RandomIt last, T init,
+      BinaryOperation op, UnaryOperation f)
+  {
+    using ST = std::size_t;
+    if (processes == 0) {
+      processes = std::max(ST{1}, ST{std::thread::hardware_concurrency()});
+    }
+    auto n = static_cast<ST>(last - first);
+    auto shards = std::min(processes, n);
+    if (shards <= 1) {
+      return acc::transform_reduce(first, last, std::move(init), op, f);
+    }
+
+    auto shard_begin = [&] (ST s) {
+      return first + static_cast<std::ptrdiff_t>(n * s / shards);
+    };
+    auto partials = detail::fork_shards<T>(
+        shards,
+        [&] (ST s) {
+          auto b = shard_begin(s);
+          T p = f(*b);
+          return acc::transform_reduce(std::next(b), shard_begin(s+1),
+                                       std::move(p), op, f);
+        });
+    return acc::accumulate(std::make_move_iterator(partials.begin()),
+                           std::make_move_iterator(partials.end()),
+                           std::move(init), op);
+  }
+
+  // ---------------------------------------------------------------------------
+  // fork_reduce
+
+  template <typename RandomIt, typename T, typename BinaryOperation>
+  inline T fork_reduce(
+      std::size_t processes,
+      RandomIt first, RandomIt last, T init, BinaryOperation op)
+  {
+    using U = typename std::iterator_traits<RandomIt>::value_type;
+    return acc::fork_transform_reduce(
+        processes, first, last, std::move(init), op,
+        [] (const U& x) -> const U& { return x; });
+  }
+
+  // ---------------------------------------------------------------------------
+  // over a file of records
+
+  template <typename Record, typename T,
+            typename BinaryOperation, typename UnaryOperation>
+  inline T fork_transform_reduce(
+      std::size_t processes, const mapped_range<Record>& records, T init,
+      BinaryOperation op, UnaryOperation f)
+  {
+    return acc::fork_transform_reduce(
+        processes, records.begin(), records.end(), std::move(init), op, f);
+  }
+
+  template <typename Record, typename T, typename BinaryOperation>
+  inline T fork_reduce(
+      std::size_t processes, const mapped_range<Record>& records, T init,
+      BinaryOperation op)
+  {
+    return acc::fork_reduce(
+        processes, records.begin(), records.end(), std::move(init), op);
+  }
+
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <thread>
+
+// ---------------------------------------------------------------------------
+// execution policies
+//
+// seq
+// unseq
+// par
+// par_unseq
+//
+
+namespace acc
+{
+  namespace execution
+  {
+
+    // -------------------------------------------------------------------------
+    // sequenced: fold in order on the calling thread
+
+    struct sequenced_policy {};
+
+    // -------------------------------------------------------------------------
+    // unsequenced: fold on the calling thread, but the fold may be
+    // reassociated (e.g. into several independent accumulators)
+
+    struct unsequenced_policy {};
+
+    // -------------------------------------------------------------------------
+    // parallel: fold chunks of at least `grain` elements on up to
+    // `concurrency` threads (0 means one thread per hardware thread)
+
+    struct parallel_policy
+    {
+      std::size_t concurrency;
+      std::size_t grain;
+
+      constexpr parallel_policy(std::size_t c = 0, std::size_t g = 1u << 14)
+        : concurrency(c), grain(g)
+      {}
+
+      constexpr parallel_policy operator()(std::size_t c) const
+      {
+        return parallel_policy{ c, grain };
+      }
+
+      std::size_t threads() const
+      {
+        if (concurrency != 0) return concurrency;
+        auto n = std::thread::hardware_concurrency();
+        return n == 0 ? 1 : n;
+      }
+    };
+
+    // -------------------------------------------------------------------------
+    // parallel unsequenced: as parallel, and each chunk may additionally be
+    // reassociated
+
+    struct parallel_unsequenced_policy : parallel_policy
+    {
+      using parallel_policy::parallel_policy;
+
+      constexpr parallel_unsequenced_policy operator()(std::size_t c) const
+      {
+        return parallel_unsequenced_policy{ c, grain };
+      }
+    };
+
+    constexpr sequenced_policy seq{};
+    constexpr unsequenced_policy unseq{};
+    constexpr parallel_policy par{};
+    constexpr parallel_unsequenced_policy par_unseq{};
+
+  }
+}
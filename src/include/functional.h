@@ -0,0 +1,122 @@
+#pragma once
+
+#include <functional>
+#include <type_traits>
+#include <utility>
+
+// ---------------------------------------------------------------------------
+// function objects for operations that <functional> lacks
+//
+// minimum
+// maximum
+// map_merge
+// insert_op
+// merge_op
+//
+// and is_op, to recognize a function object
+
+namespace acc
+{
+
+  // ---------------------------------------------------------------------------
+  // minimum and maximum: like std::min and std::max, but by value, and as
+  // transparent function objects in the style of std::plus<>
+
+  template <typename T = void>
+  struct minimum
+  {
+    constexpr T operator()(const T& a, const T& b) const
+    {
+      return b < a ? b : a;
+    }
+  };
+
+  template <>
+  struct minimum<void>
+  {
+    template <typename T, typename U>
+    constexpr auto operator()(T&& a, U&& b) const
+    {
+      return b < a ? std::forward<U>(b) : std::forward<T>(a);
+    }
+  };
+
+  template <typename T = void>
+  struct maximum
+  {
+    constexpr T operator()(const T& a, const T& b) const
+    {
+      return a < b ? b : a;
+    }
+  };
+
+  template <>
+  struct maximum<void>
+  {
+    template <typename T, typename U>
+    constexpr auto operator()(T&& a, U&& b) const
+    {
+      return a < b ? std::forward<U>(b) : std::forward<T>(a);
+    }
+  };
+
+  // ---------------------------------------------------------------------------
+  // map_merge: the union of two maps, where a key in both gets the values
+  // combined with Op
+
+  template <typename Op = std::plus<>>
+  struct map_merge
+  {
+    Op op;
+
+    template <typename Map>
+    Map operator()(Map a, const Map& b) const
+    {
+      for (const auto& kv : b) {
+        auto it = a.find(kv.first);
+        if (it == a.end()) {
+          a.insert(kv);
+        } else {
+          it->second = op(std::move(it->second), kv.second);
+        }
+      }
+      return a;
+    }
+  };
+
+  // ---------------------------------------------------------------------------
+  // insert_op and merge_op: the fold and the combine of a summary type with
+  // insert(x) and merge(other) members, such as acc::hyperloglog. Folding with
+  // insert_op builds a summary of a range; reducing with merge_op combines
+  // summaries built separately.
+
+  struct insert_op
+  {
+    template <typename S, typename U>
+    S operator()(S s, const U& x) const
+    {
+      s.insert(x);
+      return s;
+    }
+  };
+
+  struct merge_op
+  {
+    template <typename S>
+    S operator()(S a, const S& b) const
+    {
+      a.merge(b);
+      return a;
+    }
+  };
+
+  // ---------------------------------------------------------------------------
+  // is_op: Op is the function object F applied to T, either as F<T> or as the
+  // transparent F<>
+
+  template <template <typename> class F, typename Op, typename T>
+  struct is_op : std::integral_constant<
+    bool, std::is_same<Op, F<void>>::value || std::is_same<Op, F<T>>::value>
+  {};
+
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <type_traits>
+
+// ---------------------------------------------------------------------------
+// hashing for sketches
+//
+// Sketches take their bits straight from a hash, so every bit of it must be
+// well mixed; std::hash of an integer is often the integer itself. hash64
+// runs std::hash through a 64-bit finalizer, and hashes an integer with the
+// finalizer alone, which is branch-free and cheap enough to vectorize.
+//
+// hash_mix
+// hash64
+//
+
+namespace acc
+{
+  // ---------------------------------------------------------------------------
+  // the MurmurHash3 64-bit finalizer: every input bit affects every output bit
+
+  constexpr std::uint64_t hash_mix(std::uint64_t x)
+  {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdull;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ull;
+    x ^= x >> 33;
+    return x;
+  }
+
+  // ---------------------------------------------------------------------------
+  // hash64: a transparent function object, like std::plus<>
+
+  struct hash64
+  {
+    template <typename T>
+    constexpr std::enable_if_t<std::is_integral<T>::value, std::uint64_t>
+    operator()(T x) const
+    {
+      return hash_mix(static_cast<std::uint64_t>(x));
+    }
+
+    template <typename T>
+    std::enable_if_t<!std::is_integral<T>::value, std::uint64_t>
+    operator()(const T& x) const
+    {
+      return hash_mix(static_cast<std::uint64_t>(std::hash<T>{}(x)));
+    }
+  };
+
+}
@@ -1,9 +1,11 @@
 #pragma once
 
 #include "accumulate.h"
+#include "config.h"
 
 #include <algorithm>
 #include <functional>
+#include <utility>
 
 // ---------------------------------------------------------------------------
 // 6 heap operations
@@ -18,70 +20,147 @@
 
 namespace acc
 {
+  namespace detail
+  {
+    // -------------------------------------------------------------------------
+    // move the element at hole up towards the root, or down towards the
+    // leaves of the heap [first, first+n), until the heap property holds
+
+    template <typename RandomIt, typename Distance, typename Compare>
+    ACC_CONSTEXPR17 void sift_up(RandomIt first, Distance hole, Compare& cmp)
+    {
+      auto v = std::move(first[hole]);
+      while (hole > 0) {
+        auto parent = (hole - 1) / 2;
+        if (!cmp(first[parent], v)) break;
+        first[hole] = std::move(first[parent]);
+        hole = parent;
+      }
+      first[hole] = std::move(v);
+    }
+
+    template <typename RandomIt, typename Distance, typename Compare>
+    ACC_CONSTEXPR17 void sift_down(
+        RandomIt first, Distance n, Distance hole, Compare& cmp)
+    {
+      auto v = std::move(first[hole]);
+      for (auto child = 2*hole + 1; child < n; child = 2*hole + 1) {
+        if (child + 1 < n && cmp(first[child], first[child + 1])) ++child;
+        if (!cmp(v, first[child])) break;
+        first[hole] = std::move(first[child]);
+        hole = child;
+      }
+      first[hole] = std::move(v);
+    }
+  }
 
   // ---------------------------------------------------------------------------
   // is_heap_until and is_heap
 
   template <typename RandomIt, typename Compare>
-  inline RandomIt is_heap_until(
+  ACC_CONSTEXPR17 RandomIt is_heap_until(
       RandomIt first, RandomIt last, Compare cmp)
   {
     auto n = std::distance(first, last);
     if (n < 2) return last;
-    try
-    {
-      return acc::accumulate_iter(
-          first, first + n/2, first+1,
-          [&] (RandomIt i, const RandomIt& a) {
-            if (cmp(*a, *i)) throw i;
-            if (++i == last) return i;
-            if (cmp(*a, *i)) throw i;
-            return ++i;
-          });
-    }
-    catch (RandomIt& r)
-    {
-      return r;
-    }
+    return acc::accumulate_iter_until(
+        first, first + n/2, first+1,
+        [&] (RandomIt i, const RandomIt& a) {
+          if (cmp(*a, *i)) return acc::done(i);
+          if (++i == last) return acc::cont(i);
+          if (cmp(*a, *i)) return acc::done(i);
+          return acc::cont(++i);
+        });
   }
 
   template <typename RandomIt>
-  inline RandomIt is_heap_until(
+  ACC_CONSTEXPR17 RandomIt is_heap_until(
       RandomIt first, RandomIt last)
   {
     return acc::is_heap_until(first, last, std::less<>{});
   }
 
   template <typename RandomIt, typename Compare>
-  inline bool is_heap(
+  ACC_CONSTEXPR17 bool is_heap(
       RandomIt first, RandomIt last, Compare cmp)
   {
     return acc::is_heap_until(first, last, cmp) == last;
   }
 
   template <typename RandomIt>
-  inline bool is_heap(
+  ACC_CONSTEXPR17 bool is_heap(
       RandomIt first, RandomIt last)
   {
     return acc::is_heap(first, last, std::less<>{});
   }
 
+  // ---------------------------------------------------------------------------
+  // make_heap: sift down each parent, from the last to the root
+
+  template <typename RandomIt, typename Compare>
+  ACC_CONSTEXPR17 void make_heap(RandomIt first, RandomIt last, Compare cmp)
+  {
+    auto n = last - first;
+    acc::accumulate_iter(
+        first, first + n/2, n/2,
+        [&] (auto parent, const RandomIt&) {
+          detail::sift_down(first, n, --parent, cmp);
+          return parent;
+        });
+  }
+
+  template <typename RandomIt>
+  ACC_CONSTEXPR17 void make_heap(RandomIt first, RandomIt last)
+  {
+    acc::make_heap(first, last, std::less<>{});
+  }
+
+  // ---------------------------------------------------------------------------
+  // push_heap and pop_heap
+
+  template <typename RandomIt, typename Compare>
+  ACC_CONSTEXPR17 void push_heap(RandomIt first, RandomIt last, Compare cmp)
+  {
+    if (last - first > 1) detail::sift_up(first, last - first - 1, cmp);
+  }
+
+  template <typename RandomIt>
+  ACC_CONSTEXPR17 void push_heap(RandomIt first, RandomIt last)
+  {
+    acc::push_heap(first, last, std::less<>{});
+  }
+
+  template <typename RandomIt, typename Compare>
+  ACC_CONSTEXPR17 void pop_heap(RandomIt first, RandomIt last, Compare cmp)
+  {
+    auto n = last - first;
+    if (n < 2) return;
+    std::iter_swap(first, --last);
+    detail::sift_down(first, n - 1, decltype(n){0}, cmp);
+  }
+
+  template <typename RandomIt>
+  ACC_CONSTEXPR17 void pop_heap(RandomIt first, RandomIt last)
+  {
+    acc::pop_heap(first, last, std::less<>{});
+  }
+
   // ---------------------------------------------------------------------------
   // sort_heap
 
   template <typename RandomIt, typename Compare>
-  inline void sort_heap(RandomIt first, RandomIt last, Compare cmp)
+  ACC_CONSTEXPR17 void sort_heap(RandomIt first, RandomIt last, Compare cmp)
   {
     acc::accumulate_iter(
         first, last, last,
         [&] (RandomIt dest, const RandomIt&) {
-          std::pop_heap(first, dest, cmp);
+          acc::pop_heap(first, dest, cmp);
           return --dest;
         });
   }
 
   template <typename RandomIt>
-  inline void sort_heap(RandomIt first, RandomIt last)
+  ACC_CONSTEXPR17 void sort_heap(RandomIt first, RandomIt last)
   {
     acc::sort_heap(first, last, std::less<>{});
   }
@@ -0,0 +1,487 @@
+#pragma once
+
+#include "accumulate.h"
+#include "functional.h"
+#include "monoid.h"
+#include "serialize.h"
+#include "simd.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// ---------------------------------------------------------------------------
+// histogram
+//
+// Counts of the values of a stream in bins, given by a binning:
+//
+//   uniform_bins(lo, hi, n): n bins of equal width over [lo, hi)
+//   edge_bins<T>(edges):     a bin [e[i], e[i+1]) between each pair of
+//                            consecutive (strictly increasing) edges
+//
+// Values below the first bin count as underflow, and values at or above the
+// last as overflow, as does NaN (but not reliably under -ffast-math).
+// uniform_bins works in double.
+//
+// merge adds the counts, so that the merge of two histograms (with the same
+// bins) is the histogram of both streams; an empty histogram takes on the
+// bins of whatever is merged into it.
+//
+// insert(first, last) works a block at a time: it computes the bins of the
+// whole block first (uniform_bins over a contiguous range of int, float or
+// double does it with AVX2 where the host has it), and then counts them
+// round-robin into four copies of the counters, which are added up at the
+// end. Consecutive values in the same bin (the common case in real data)
+// then don't wait on each other's increment to get through memory.
+//
+
+namespace acc
+{
+  namespace detail
+  {
+    // bins are indexed with 32 bits, with 0 for underflow and n + 1 for overflow
+    constexpr std::size_t max_bins = (std::size_t{1} << 31) - 2;
+
+#ifdef ACC_SIMD_X86
+    __attribute__((target("avx2"), always_inline))
+    inline __m256d uniform_load4(const double* p)
+    {
+      return _mm256_loadu_pd(p);
+    }
+
+    __attribute__((target("avx2"), always_inline))
+    inline __m256d uniform_load4(const float* p)
+    {
+      return _mm256_cvtps_pd(_mm_loadu_ps(p));
+    }
+
+    __attribute__((target("avx2"), always_inline))
+    inline __m256d uniform_load4(const int* p)
+    {
+      return _mm256_cvtepi32_pd(
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+    }
+
+    // four at a time, exactly as uniform_bins::index does one
+    template <typename T>
+    __attribute__((target("avx2")))
+    inline std::size_t uniform_index_avx2(
+        const T* x, std::size_t n, double lo, double hi, double scale,
+        double last, double over, std::uint32_t* out)
+    {
+      const auto vlo = _mm256_set1_pd(lo);
+      const auto vhi = _mm256_set1_pd(hi);
+      const auto vscale = _mm256_set1_pd(scale);
+      const auto vlast = _mm256_set1_pd(last);
+      const auto vunder = _mm256_set1_pd(-1.0);
+      const auto vover = _mm256_set1_pd(over);
+      const auto one = _mm_set1_epi32(1);
+      const auto top = _mm_set1_epi32(static_cast<int>(over) + 1);
+      std::size_t i = 0;
+      for (; i + 4 <= n; i += 4) {
+        auto v = uniform_load4(x + i);
+        auto f = _mm256_min_pd(_mm256_mul_pd(_mm256_sub_pd(v, vlo), vscale), vlast);
+        f = _mm256_blendv_pd(f, vunder, _mm256_cmp_pd(v, vlo, _CMP_LT_OQ));
+        f = _mm256_blendv_pd(f, vover, _mm256_cmp_pd(v, vhi, _CMP_NLT_UQ));
+        auto k = _mm_add_epi32(_mm256_cvttpd_epi32(f), one);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i),
+                         _mm_min_epu32(k, top));
+      }
+      return i;
+    }
+#endif
+  }
+
+  // ---------------------------------------------------------------------------
+  // uniform_bins: n bins of width (hi - lo) / n
+
+  class uniform_bins
+  {
+  public:
+    // no bins: everything is underflow or overflow
+    uniform_bins() = default;
+
+    uniform_bins(double lo, double hi, std::size_t n)
+      : lo_(lo), hi_(hi), n_(n)
+    {
+      if (!(lo < hi) || n == 0 || n > detail::max_bins) {
+        throw std::invalid_argument("acc::uniform_bins: bad bins");
+      }
+      scale_ = static_cast<double>(n) / (hi - lo);
+    }
+
+    std::size_t size() const { return n_; }
+
+    // the lower edge of bin i, or the upper edge of the last bin for i == n
+    double edge(std::size_t i) const
+    {
+      return i == n_ ? hi_ : lo_ + static_cast<double>(i) * (hi_ - lo_) / n_;
+    }
+
+    // a value's bin, plus one: 0 for underflow, n + 1 for overflow
+    std::uint32_t index(double x) const
+    {
+      // a value just below hi can round up to n, so it's clamped to the last bin
+      auto f = std::min((x - lo_) * scale_, last());
+      f = x < lo_ ? -1.0 : f;
+      f = x < hi_ ? f : static_cast<double>(n_);
+      // and with fast math, NaN may get this far: it at least stays in range
+      auto i = static_cast<std::uint32_t>(static_cast<std::int32_t>(f) + 1);
+      return std::min(i, static_cast<std::uint32_t>(n_ + 1));
+    }
+
+    template <typename T>
+    void index(const T* x, std::size_t n, std::uint32_t* out) const
+    {
+      std::size_t i = 0;
+#ifdef ACC_SIMD_X86
+      index_avx2(x, n, out, i, has_avx2_kernel<T>{});
+#endif
+      for (; i < n; ++i) out[i] = index(static_cast<double>(x[i]));
+    }
+
+    friend bool operator==(const uniform_bins& a, const uniform_bins& b)
+    {
+      return a.lo_ == b.lo_ && a.hi_ == b.hi_ && a.n_ == b.n_;
+    }
+
+    friend bool operator!=(const uniform_bins& a, const uniform_bins& b)
+    {
+      return !(a == b);
+    }
+
+  private:
+    friend struct serializer<uniform_bins>;
+
+    double last() const { return static_cast<double>(n_) - 1.0; }
+
+#ifdef ACC_SIMD_X86
+    // the kernel types, but unsigned, which doesn't convert in AVX2
+    template <typename T>
+    using has_avx2_kernel = std::integral_constant<
+      bool, simd::is_kernel_type<T>::value && !std::is_unsigned<T>::value>;
+
+    template <typename T>
+    void index_avx2(const T* x, std::size_t n, std::uint32_t* out,
+                    std::size_t& i, std::true_type) const
+    {
+      if (simd::best_isa() < simd::isa::avx2) return;
+      i = detail::uniform_index_avx2(x, n, lo_, hi_, scale_, last(),
+                                     static_cast<double>(n_), out);
+    }
+
+    template <typename T>
+    void index_avx2(const T*, std::size_t, std::uint32_t*,
+                    std::size_t&, std::false_type) const
+    {}
+#endif
+
+    double lo_ = 0;
+    double hi_ = 0;
+    std::size_t n_ = 0;
+    double scale_ = 0;
+  };
+
+  // ---------------------------------------------------------------------------
+  // edge_bins: bins between strictly increasing edges, found by a branchless
+  // binary search
+
+  template <typename T, typename Compare = std::less<>>
+  class edge_bins
+  {
+  public:
+    // no bins: everything is underflow
+    edge_bins() = default;
+
+    explicit edge_bins(std::vector<T> edges, Compare cmp = Compare{})
+      : edges_(std::move(edges)), cmp_(std::move(cmp))
+    {
+      if (!valid()) throw std::invalid_argument("acc::edge_bins: bad edges");
+    }
+
+    std::size_t size() const { return edges_.empty() ? 0 : edges_.size() - 1; }
+
+    const T& edge(std::size_t i) const { return edges_[i]; }
+    const std::vector<T>& edges() const { return edges_; }
+
+    // a value's bin, plus one: 0 for underflow, n + 1 for overflow
+    std::uint32_t index(const T& x) const
+    {
+      auto n = edges_.size();
+      if (n == 0) return 0;
+      auto e = edges_.data();
+      auto b = e;
+      while (n > 1) {
+        auto h = n / 2;
+        b = cmp_(x, b[h]) ? b : b + h;
+        n -= h;
+      }
+      return static_cast<std::uint32_t>(b - e) + !cmp_(x, *b);
+    }
+
+    template <typename U>
+    void index(const U* x, std::size_t n, std::uint32_t* out) const
+    {
+      for (std::size_t i = 0; i < n; ++i) out[i] = index(x[i]);
+    }
+
+    friend bool operator==(const edge_bins& a, const edge_bins& b)
+    {
+      return a.edges_ == b.edges_;
+    }
+
+    friend bool operator!=(const edge_bins& a, const edge_bins& b)
+    {
+      return !(a == b);
+    }
+
+  private:
+    friend struct serializer<edge_bins>;
+
+    bool valid() const
+    {
+      if (edges_.size() == 1 || size() > detail::max_bins) return false;
+      return std::adjacent_find(edges_.cbegin(), edges_.cend(),
+                                [this] (const T& a, const T& b) {
+                                  return !cmp_(a, b);
+                                }) == edges_.cend();
+    }
+
+    std::vector<T> edges_;
+    Compare cmp_;
+  };
+
+  // ---------------------------------------------------------------------------
+  // histogram
+
+  template <typename Bins = uniform_bins>
+  class histogram
+  {
+  public:
+    using count_type = std::uint64_t;
+
+    histogram() : counts_(2) {}
+    explicit histogram(Bins bins)
+      : bins_(std::move(bins)), counts_(bins_.size() + 2)
+    {}
+
+    template <typename U>
+    void insert(const U& x)
+    {
+      ++counts_[bins_.index(x)];
+    }
+
+    template <typename InputIt>
+    void insert(InputIt first, InputIt last)
+    {
+      insert_range(first, last, simd::is_contiguous<InputIt>{});
+    }
+
+    void merge(const histogram& other)
+    {
+      if (other.total() == 0) return;
+      if (total() == 0) {
+        *this = other;
+        return;
+      }
+      if (bins_ != other.bins_) {
+        throw std::invalid_argument("acc::histogram: merge with different bins");
+      }
+      auto c = counts_.data();
+      auto o = other.counts_.data();
+      for (std::size_t i = 0; i < counts_.size(); ++i) c[i] += o[i];
+    }
+
+    // the number of bins, and the count in bin i
+    std::size_t size() const { return bins_.size(); }
+    count_type operator[](std::size_t i) const { return counts_[i + 1]; }
+
+    count_type underflow() const { return counts_.front(); }
+    count_type overflow() const { return counts_.back(); }
+
+    // the number of values inserted, underflow and overflow included
+    count_type total() const
+    {
+      return acc::accumulate(counts_.cbegin(), counts_.cend(), count_type{0},
+                             std::plus<>{});
+    }
+
+    const Bins& bins() const { return bins_; }
+
+    friend bool operator==(const histogram& a, const histogram& b)
+    {
+      return a.bins_ == b.bins_ && a.counts_ == b.counts_;
+    }
+
+    friend bool operator!=(const histogram& a, const histogram& b)
+    {
+      return !(a == b);
+    }
+
+  private:
+    friend struct serializer<histogram>;
+
+    static constexpr std::size_t block = 256;
+    static constexpr std::size_t copies = 4;
+    // with more counters than this, consecutive values seldom share a bin,
+    // and the copies would only crowd the cache
+    static constexpr std::size_t max_copied = 4096;
+
+    // the counters of insert(first, last): the histogram's own, and the extra
+    // copies once a full block comes along
+    struct counter
+    {
+      explicit counter(histogram& h) : h_(h) {}
+
+      void count(const std::uint32_t* idx, std::size_t n)
+      {
+        auto m = h_.counts_.size();
+        if (n == block && m <= max_copied && extra_.empty()) {
+          extra_.resize((copies - 1) * m);
+        }
+        auto c0 = h_.counts_.data();
+        std::size_t k = 0;
+        if (!extra_.empty()) {
+          auto c1 = extra_.data();
+          auto c2 = c1 + m;
+          auto c3 = c2 + m;
+          for (; k + copies <= n; k += copies) {
+            ++c0[idx[k]];
+            ++c1[idx[k+1]];
+            ++c2[idx[k+2]];
+            ++c3[idx[k+3]];
+          }
+        }
+        for (; k < n; ++k) ++c0[idx[k]];
+      }
+
+      ~counter()
+      {
+        auto m = h_.counts_.size();
+        auto c = h_.counts_.data();
+        for (std::size_t j = 0; j < extra_.size(); ++j) c[j % m] += extra_[j];
+      }
+
+      histogram& h_;
+      std::vector<count_type> extra_;
+    };
+
+    template <typename InputIt>
+    void insert_range(InputIt first, InputIt last, std::false_type)
+    {
+      std::uint32_t idx[block];
+      counter c(*this);
+      while (first != last) {
+        std::size_t n = 0;
+        for (; n < block && first != last; ++first) idx[n++] = bins_.index(*first);
+        c.count(idx, n);
+      }
+    }
+
+    template <typename ContiguousIt>
+    void insert_range(ContiguousIt first, ContiguousIt last, std::true_type)
+    {
+      if (first == last) return;
+      auto p = simd::to_pointer(first);
+      auto n = static_cast<std::size_t>(last - first);
+      std::uint32_t idx[block];
+      counter c(*this);
+      for (std::size_t i = 0; i < n; i += block) {
+        auto m = std::min(std::size_t{block}, n - i);
+        bins_.index(p + i, m, idx);
+        c.count(idx, m);
+      }
+    }
+
+    Bins bins_;
+    std::vector<count_type> counts_;
+  };
+
+  // ---------------------------------------------------------------------------
+  // the merge monoid
+
+  template <typename Bins>
+  struct monoid<merge_op, histogram<Bins>>
+    : detail::commutative_monoid<histogram<Bins>>
+  {
+    static constexpr bool has_absorbing = false;
+    static histogram<Bins> identity() { return {}; }
+  };
+
+  // ---------------------------------------------------------------------------
+  // serialization: the bins, then the counts as varints
+
+  template <>
+  struct serializer<uniform_bins>
+  {
+    static void save(std::vector<char>& out, const uniform_bins& b)
+    {
+      acc::save(out, b.lo_);
+      acc::save(out, b.hi_);
+      detail::save_varint(out, b.n_);
+    }
+
+    static uniform_bins load(const char*& p, const char* end)
+    {
+      auto lo = acc::load<double>(p, end);
+      auto hi = acc::load<double>(p, end);
+      auto n = detail::load_varint(p, end);
+      if (n == 0 && lo == 0 && hi == 0) return {};
+      if (!(lo < hi) || n == 0 || n > detail::max_bins) {
+        throw std::runtime_error("acc::load: bad uniform_bins");
+      }
+      return { lo, hi, static_cast<std::size_t>(n) };
+    }
+  };
+
+  template <typename T, typename Compare>
+  struct serializer<edge_bins<T, Compare>>
+  {
+    using S = edge_bins<T, Compare>;
+
+    static void save(std::vector<char>& out, const S& b)
+    {
+      acc::save(out, b.edges_);
+    }
+
+    static S load(const char*& p, const char* end)
+    {
+      S b;
+      b.edges_ = acc::load<std::vector<T>>(p, end);
+      if (!b.valid()) throw std::runtime_error("acc::load: bad edge_bins");
+      return b;
+    }
+  };
+
+  template <typename Bins>
+  struct serializer<histogram<Bins>>
+  {
+    using S = histogram<Bins>;
+
+    static void save(std::vector<char>& out, const S& s)
+    {
+      acc::save(out, s.bins_);
+      for (auto c : s.counts_) detail::save_varint(out, c);
+    }
+
+    static S load(const char*& p, const char* end)
+    {
+      auto bins = acc::load<Bins>(p, end);
+      // a varint is at least a byte, so there must be a byte for each count
+      // before they're allocated
+      if (static_cast<std::size_t>(end - p) < bins.size() + 2) {
+        throw std::runtime_error("acc::load: bad histogram");
+      }
+      S s(std::move(bins));
+      for (auto& c : s.counts_) c = detail::load_varint(p, end);
+      return s;
+    }
+  };
+
+}
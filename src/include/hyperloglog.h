@@ -0,0 +1,351 @@
+#pragma once
+
+#include "accumulate.h"
+#include "functional.h"
+#include "hash.h"
+#include "monoid.h"
+#include "serialize.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+// ---------------------------------------------------------------------------
+// hyperloglog
+//
+// An estimate of the number of distinct values in a stream, from 2^P one-byte
+// registers: the standard error is about 1.04 / sqrt(2^P), so P = 14 gives
+// under 1% in 16KiB, however long the stream. Each value is hashed to 64
+// bits; the top P bits pick a register, which keeps the highest rank (one
+// more than the number of leading zeros in the rest) seen.
+//
+// merge takes the register-wise max, so that the merge of two sketches is
+// exactly the sketch of the union of their streams.
+//
+// A new sketch is sparse: a sorted list of its nonzero registers, which is
+// promoted to the dense array once it would take half the space. The
+// estimate doesn't depend on the representation.
+//
+// insert(first, last) hashes a block of values in a loop of its own before
+// updating the registers, so that hashing a contiguous range of integers
+// vectorizes; the dense merge is a plain byte-wise max loop, which does too.
+//
+// acc::serializer writes a sparse sketch as delta-coded varints, and a dense
+// one as 6-bit registers.
+//
+
+namespace acc
+{
+  template <unsigned P, typename Hash = hash64>
+  class hyperloglog
+  {
+    static_assert(P >= 4 && P <= 18, "hyperloglog precision must be in [4, 18]");
+
+  public:
+    static constexpr std::size_t registers = std::size_t{1} << P;
+    static constexpr unsigned max_rank = 64 - P + 1;
+
+    hyperloglog() = default;
+    explicit hyperloglog(Hash h) : hash_(std::move(h)) {}
+
+    template <typename U>
+    void insert(const U& x)
+    {
+      insert_entry(entry_of(hash_(x)));
+    }
+
+    template <typename InputIt>
+    void insert(InputIt first, InputIt last)
+    {
+      insert_range(first, last,
+                   typename std::iterator_traits<InputIt>::iterator_category{});
+    }
+
+    void merge(const hyperloglog& other)
+    {
+      if (other.is_sparse()) {
+        if (is_sparse()) {
+          sparse_.insert(sparse_.end(), other.sparse_.cbegin(), other.sparse_.cend());
+          compact();
+        } else {
+          for (auto e : other.sparse_) update(dense_.data(), e);
+        }
+        return;
+      }
+      if (is_sparse()) densify();
+      auto r = dense_.data();
+      auto o = other.dense_.data();
+      for (std::size_t i = 0; i < registers; ++i) r[i] = std::max(r[i], o[i]);
+    }
+
+    double estimate() const
+    {
+      // the sum of 2^-rank over the registers, and the number of them at zero
+      using S = std::pair<double, std::size_t>;
+      auto add = [] (S s, std::uint8_t r) {
+        s.first += std::ldexp(1.0, -static_cast<int>(r));
+        s.second += r == 0;
+        return s;
+      };
+      S s;
+      if (is_sparse()) {
+        auto zeros = registers - sparse_.size();
+        s = acc::accumulate(sparse_.cbegin(), sparse_.cend(),
+                            S{ static_cast<double>(zeros), zeros },
+                            [&] (S t, std::uint32_t e) { return add(t, rank_of(e)); });
+      } else {
+        s = acc::accumulate(dense_.cbegin(), dense_.cend(), S{ 0.0, 0 }, add);
+      }
+
+      constexpr double m = registers;
+      double e = alpha() * m * m / s.first;
+      // while registers are still empty, linear counting is more accurate
+      if (e <= 2.5 * m && s.second != 0) {
+        return m * std::log(m / static_cast<double>(s.second));
+      }
+      return e;
+    }
+
+    bool is_sparse() const { return dense_.empty(); }
+    bool empty() const { return is_sparse() && sparse_.empty(); }
+
+    friend bool operator==(const hyperloglog& a, const hyperloglog& b)
+    {
+      if (a.is_sparse() && b.is_sparse()) return a.sparse_ == b.sparse_;
+      return a.dense_registers() == b.dense_registers();
+    }
+
+    friend bool operator!=(const hyperloglog& a, const hyperloglog& b)
+    {
+      return !(a == b);
+    }
+
+  private:
+    friend struct serializer<hyperloglog>;
+
+    // a sparse entry is a register's index above its rank, so that entries
+    // sort by index
+    static constexpr unsigned rank_bits = 6;
+    static constexpr std::size_t sparse_limit = registers / 8;
+    static constexpr std::size_t block = 256;
+
+    static constexpr std::uint32_t make_entry(std::size_t i, unsigned r)
+    {
+      return static_cast<std::uint32_t>(i << rank_bits | r);
+    }
+    static constexpr std::size_t index_of(std::uint32_t e) { return e >> rank_bits; }
+    static constexpr std::uint8_t rank_of(std::uint32_t e)
+    {
+      return static_cast<std::uint8_t>(e & ((1u << rank_bits) - 1));
+    }
+
+    static unsigned leading_zeros(std::uint64_t w)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+      return static_cast<unsigned>(__builtin_clzll(w));
+#else
+      unsigned n = 0;
+      for (auto b = std::uint64_t{1} << 63; !(w & b); b >>= 1) ++n;
+      return n;
+#endif
+    }
+
+    static std::uint32_t entry_of(std::uint64_t h)
+    {
+      // the guard bit below the shifted-out index bounds the rank by max_rank
+      auto w = h << P | std::uint64_t{1} << (P - 1);
+      return make_entry(static_cast<std::size_t>(h >> (64 - P)),
+                        leading_zeros(w) + 1);
+    }
+
+    static constexpr double alpha()
+    {
+      return registers == 16 ? 0.673
+        : registers == 32 ? 0.697
+        : registers == 64 ? 0.709
+        : 0.7213 / (1.0 + 1.079 / registers);
+    }
+
+    static void update(std::uint8_t* r, std::uint32_t e)
+    {
+      auto i = index_of(e);
+      r[i] = std::max(r[i], rank_of(e));
+    }
+
+    void insert_entry(std::uint32_t e)
+    {
+      if (!is_sparse()) return update(dense_.data(), e);
+      auto it = std::lower_bound(sparse_.begin(), sparse_.end(),
+                                 make_entry(index_of(e), 0));
+      if (it != sparse_.end() && index_of(*it) == index_of(e)) {
+        *it = std::max(*it, e);
+      } else {
+        sparse_.insert(it, e);
+        if (sparse_.size() > sparse_limit) densify();
+      }
+    }
+
+    void insert_entries(const std::uint32_t* e, std::size_t n)
+    {
+      if (!is_sparse()) {
+        auto r = dense_.data();
+        for (std::size_t k = 0; k < n; ++k) update(r, e[k]);
+        return;
+      }
+      sparse_.insert(sparse_.end(), e, e + n);
+      compact();
+    }
+
+    template <typename RandomIt>
+    void insert_range(RandomIt first, RandomIt last,
+                      std::random_access_iterator_tag)
+    {
+      std::uint32_t e[block];
+      while (first != last) {
+        auto n = std::min(std::size_t{block},
+                          static_cast<std::size_t>(last - first));
+        for (std::size_t k = 0; k < n; ++k) {
+          e[k] = entry_of(hash_(first[static_cast<std::ptrdiff_t>(k)]));
+        }
+        insert_entries(e, n);
+        first += static_cast<std::ptrdiff_t>(n);
+      }
+    }
+
+    template <typename InputIt>
+    void insert_range(InputIt first, InputIt last, std::input_iterator_tag)
+    {
+      std::uint32_t e[block];
+      while (first != last) {
+        std::size_t n = 0;
+        for (; n < block && first != last; ++first) e[n++] = entry_of(hash_(*first));
+        insert_entries(e, n);
+      }
+    }
+
+    // sort the sparse list, keep the highest rank for each index, and promote
+    // it if it has grown too big
+    void compact()
+    {
+      std::sort(sparse_.begin(), sparse_.end());
+      auto out = sparse_.begin();
+      for (auto it = sparse_.begin(); it != sparse_.end(); ++it) {
+        auto next = std::next(it);
+        if (next == sparse_.end() || index_of(*next) != index_of(*it)) *out++ = *it;
+      }
+      sparse_.erase(out, sparse_.end());
+      if (sparse_.size() > sparse_limit) densify();
+    }
+
+    void densify()
+    {
+      dense_ = dense_registers();
+      sparse_.clear();
+      sparse_.shrink_to_fit();
+    }
+
+    std::vector<std::uint8_t> dense_registers() const
+    {
+      if (!is_sparse()) return dense_;
+      std::vector<std::uint8_t> r(registers);
+      for (auto e : sparse_) r[index_of(e)] = rank_of(e);
+      return r;
+    }
+
+    std::vector<std::uint32_t> sparse_;
+    std::vector<std::uint8_t> dense_;
+    Hash hash_;
+  };
+
+  // ---------------------------------------------------------------------------
+  // the merge monoid
+
+  template <unsigned P, typename Hash>
+  struct monoid<merge_op, hyperloglog<P, Hash>>
+    : detail::commutative_monoid<hyperloglog<P, Hash>>
+  {
+    static constexpr bool has_absorbing = false;
+    static hyperloglog<P, Hash> identity() { return {}; }
+  };
+
+  // ---------------------------------------------------------------------------
+  // serialization: a tag byte, then either the sparse list as a count and the
+  // gaps between entries, or the registers packed four to three bytes
+
+  template <unsigned P, typename Hash>
+  struct serializer<hyperloglog<P, Hash>>
+  {
+    using S = hyperloglog<P, Hash>;
+
+    static void save(std::vector<char>& out, const S& s)
+    {
+      if (s.is_sparse()) {
+        out.push_back(0);
+        detail::save_varint(out, s.sparse_.size());
+        std::uint32_t prev = 0;
+        for (auto e : s.sparse_) {
+          detail::save_varint(out, e - prev);
+          prev = e;
+        }
+        return;
+      }
+      out.push_back(1);
+      auto r = s.dense_.data();
+      for (std::size_t i = 0; i < S::registers; i += 4) {
+        std::uint32_t w = r[i] | r[i+1] << 6 | r[i+2] << 12 | r[i+3] << 18;
+        out.push_back(static_cast<char>(w));
+        out.push_back(static_cast<char>(w >> 8));
+        out.push_back(static_cast<char>(w >> 16));
+      }
+    }
+
+    static S load(const char*& p, const char* end)
+    {
+      auto tag = acc::load<char>(p, end);
+      S s;
+      if (tag == 0) {
+        auto n = detail::load_varint(p, end);
+        if (n > S::sparse_limit) bad();
+        constexpr auto limit = std::uint64_t{S::registers} << S::rank_bits;
+        std::uint64_t e = 0;
+        for (std::uint64_t k = 0; k < n; ++k) {
+          auto gap = detail::load_varint(p, end);
+          if (gap >= limit - e) bad();
+          e += gap;
+          auto x = static_cast<std::uint32_t>(e);
+          if (S::rank_of(x) == 0 || S::rank_of(x) > S::max_rank) bad();
+          if (!s.sparse_.empty()
+              && S::index_of(x) <= S::index_of(s.sparse_.back())) bad();
+          s.sparse_.push_back(x);
+        }
+        return s;
+      }
+      if (tag != 1) bad();
+      if (static_cast<std::size_t>(end - p) < S::registers / 4 * 3) {
+        throw std::runtime_error("acc::load: truncated input");
+      }
+      s.dense_.resize(S::registers);
+      auto r = s.dense_.data();
+      for (std::size_t i = 0; i < S::registers; i += 4, p += 3) {
+        auto b = reinterpret_cast<const unsigned char*>(p);
+        std::uint32_t w = b[0] | b[1] << 8 | std::uint32_t{b[2]} << 16;
+        for (std::size_t j = 0; j < 4; ++j) {
+          r[i+j] = static_cast<std::uint8_t>(w >> (6*j) & 0x3f);
+          if (r[i+j] > S::max_rank) bad();
+        }
+      }
+      return s;
+    }
+
+    [[noreturn]] static void bad()
+    {
+      throw std::runtime_error("acc::load: bad hyperloglog");
+    }
+  };
+
+}
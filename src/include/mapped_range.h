@@ -0,0 +1,135 @@
+#pragma once
+
+#include <cerrno>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// ---------------------------------------------------------------------------
+// mapped_range (POSIX only)
+//
+// A read-only view of a file of fixed-size binary records, mapped into
+// memory. Its iterators are plain pointers, so it works with every acc
+// algorithm: folds over it get the SIMD kernels, parallel policies chunk it
+// like any random access range, and fork_reduce workers share its pages.
+// Nothing is read until it is touched, and nothing is copied to the heap.
+//
+// The advice is passed to madvise: sequential (the default) asks for
+// aggressive read-ahead, random turns it off. Where the kernel supports it,
+// transparent huge pages are also requested.
+//
+
+namespace acc
+{
+  enum class advice { normal, sequential, random };
+
+  template <typename Record>
+  class mapped_range
+  {
+    static_assert(std::is_trivially_copyable<Record>::value,
+                  "mapped_range records must be trivially copyable");
+
+  public:
+    using value_type = Record;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using const_reference = const Record&;
+    using reference = const_reference;
+    using const_iterator = const Record*;
+    using iterator = const_iterator;
+
+    explicit mapped_range(const std::string& path,
+                          advice a = advice::sequential)
+    {
+      int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+      if (fd < 0) fail(errno, "open");
+
+      struct stat st;
+      if (::fstat(fd, &st) != 0) {
+        int e = errno;
+        ::close(fd);
+        fail(e, "fstat");
+      }
+      auto bytes = static_cast<std::size_t>(st.st_size);
+      if (bytes % sizeof(Record) != 0) {
+        ::close(fd);
+        throw std::runtime_error(
+            "acc::mapped_range: " + path + " is not a whole number of records");
+      }
+      if (bytes == 0) {
+        ::close(fd);
+        return;
+      }
+
+      void* p = ::mmap(nullptr, bytes, PROT_READ, MAP_SHARED, fd, 0);
+      int e = errno;
+      ::close(fd);
+      if (p == MAP_FAILED) fail(e, "mmap");
+      base_ = p;
+      bytes_ = bytes;
+      advise(a);
+    }
+
+    ~mapped_range()
+    {
+      if (base_) ::munmap(base_, bytes_);
+    }
+
+    mapped_range(mapped_range&& other) noexcept
+      : base_(std::exchange(other.base_, nullptr)),
+        bytes_(std::exchange(other.bytes_, 0))
+    {}
+
+    mapped_range& operator=(mapped_range&& other) noexcept
+    {
+      std::swap(base_, other.base_);
+      std::swap(bytes_, other.bytes_);
+      return *this;
+    }
+
+    mapped_range(const mapped_range&) = delete;
+    mapped_range& operator=(const mapped_range&) = delete;
+
+    // change the access pattern hint, e.g. before a random access pass
+    void advise(advice a) const
+    {
+      if (!base_) return;
+      int m = a == advice::sequential ? MADV_SEQUENTIAL
+            : a == advice::random ? MADV_RANDOM
+            : MADV_NORMAL;
+      ::madvise(base_, bytes_, m);
+#ifdef MADV_HUGEPAGE
+      ::madvise(base_, bytes_, MADV_HUGEPAGE);
+#endif
+    }
+
+    const Record* data() const { return static_cast<const Record*>(base_); }
+    size_type size() const { return bytes_ / sizeof(Record); }
+    bool empty() const { return bytes_ == 0; }
+
+    const_iterator begin() const { return data(); }
+    const_iterator end() const { return data() + size(); }
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const { return end(); }
+
+    const Record& operator[](size_type i) const { return data()[i]; }
+
+  private:
+    [[noreturn]] static void fail(int e, const char* what)
+    {
+      throw std::system_error(e, std::generic_category(), what);
+    }
+
+    void* base_ = nullptr;
+    std::size_t bytes_ = 0;
+  };
+
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "accumulate.h"
+#include "config.h"
 #include "modifying_seq_ops.h"
 #include "non_modifying_seq_ops.h"
 
@@ -35,7 +36,7 @@ namespace acc
   // min_element
 
   template <typename ForwardIt, typename Compare>
-  inline ForwardIt min_element(
+  ACC_CONSTEXPR17 ForwardIt min_element(
       ForwardIt first, ForwardIt last, Compare cmp)
   {
     return acc::accumulate_iter(
@@ -49,7 +50,7 @@ namespace acc
   // max_element
 
   template <typename ForwardIt, typename Compare>
-  inline ForwardIt max_element(
+  ACC_CONSTEXPR17 ForwardIt max_element(
       ForwardIt first, ForwardIt last, Compare cmp)
   {
     return acc::accumulate_iter(
@@ -63,7 +64,7 @@ namespace acc
   // minmax_element
 
   template <typename ForwardIt, typename Compare>
-  inline std::pair<ForwardIt, ForwardIt> minmax_element(
+  ACC_CONSTEXPR17 std::pair<ForwardIt, ForwardIt> minmax_element(
       ForwardIt first, ForwardIt last, Compare cmp)
   {
     using P = std::pair<ForwardIt, ForwardIt>;
@@ -80,19 +81,19 @@ namespace acc
   // min, max, minmax (initializer_list forms)
 
   template <typename T, typename Compare>
-  inline T min(std::initializer_list<T> ilist, Compare cmp)
+  ACC_CONSTEXPR17 T min(std::initializer_list<T> ilist, Compare cmp)
   {
     return *acc::min_element(ilist.begin(), ilist.end(), cmp);
   }
 
   template <typename T, typename Compare>
-  inline T max(std::initializer_list<T> ilist, Compare cmp)
+  ACC_CONSTEXPR17 T max(std::initializer_list<T> ilist, Compare cmp)
   {
     return *acc::max_element(ilist.begin(), ilist.end(), cmp);
   }
 
   template <typename T, typename Compare>
-  inline std::pair<T, T> minmax(
+  ACC_CONSTEXPR17 std::pair<T, T> minmax(
       std::initializer_list<T> ilist, Compare cmp)
   {
     auto p = acc::minmax_element(ilist.begin(), ilist.end(), cmp);
@@ -105,7 +106,7 @@ namespace acc
   // min_element (safe value form)
 
   template <typename InputIt, typename Compare>
-  inline std::experimental::optional<
+  ACC_CONSTEXPR17 std::experimental::optional<
     typename std::iterator_traits<InputIt>::value_type>
   min_element_safe(InputIt first, InputIt last, Compare cmp)
   {
@@ -124,7 +125,7 @@ namespace acc
   // max_element (safe value form)
 
   template <typename InputIt, typename Compare>
-  inline std::experimental::optional<
+  ACC_CONSTEXPR17 std::experimental::optional<
     typename std::iterator_traits<InputIt>::value_type>
   max_element_safe(InputIt first, InputIt last, Compare cmp)
   {
@@ -143,7 +144,7 @@ namespace acc
   // minmax_element (safe value form)
 
   template <typename InputIt, typename Compare>
-  inline std::experimental::optional<
+  ACC_CONSTEXPR17 std::experimental::optional<
     std::pair<typename std::iterator_traits<InputIt>::value_type,
               typename std::iterator_traits<InputIt>::value_type>>
   minmax_element_safe(InputIt first, InputIt last, Compare cmp)
@@ -168,35 +169,30 @@ namespace acc
   // lexicographical_compare
 
   template <typename InputIt1, typename InputIt2, typename Compare>
-  inline bool lexicographical_compare(
+  ACC_CONSTEXPR17 bool lexicographical_compare(
       InputIt1 first1, InputIt1 last1,
       InputIt2 first2, InputIt2 last2,
       Compare cmp)
   {
     using T = typename std::iterator_traits<InputIt1>::value_type;
     using P = std::pair<bool, InputIt2>;
-    try
-    {
-     return acc::accumulate(
-         first1, last1, P{ false, first2 },
-         [&] (P a, const T& b) {
-           if (a.second == last2 || cmp(*a.second, b)) throw false;
-           if (cmp(b, *a.second)) throw true;
-            auto next = ++a.second;
-            return P{ next != last2, next };
-         }).first;
-    }
-    catch (bool b)
-    {
-      return b;
-    }
+    return acc::accumulate_until(
+        first1, last1, P{ first2 != last2, first2 },
+        [&] (P a, const T& b) {
+          if (a.second == last2 || cmp(*a.second, b))
+            return acc::done(P{ false, a.second });
+          if (cmp(b, *a.second))
+            return acc::done(P{ true, a.second });
+          auto next = ++a.second;
+          return acc::cont(P{ next != last2, next });
+        }).first;
   }
 
   // ---------------------------------------------------------------------------
   // is_permutation
 
   template <typename ForwardIt1, typename ForwardIt2>
-  inline bool is_permutation(ForwardIt1 first, ForwardIt1 last,
+  ACC_CONSTEXPR17 bool is_permutation(ForwardIt1 first, ForwardIt1 last,
                              ForwardIt2 d_first)
   {
     std::tie(first, d_first) = acc::mismatch(first, last, d_first, std::equal_to<>{});
@@ -219,7 +215,7 @@ namespace acc
   // next_permutation (note weakened iterator category)
 
   template <typename ForwardIt, typename Compare>
-  inline bool next_permutation(ForwardIt first, ForwardIt last, Compare cmp)
+  ACC_CONSTEXPR17 bool next_permutation(ForwardIt first, ForwardIt last, Compare cmp)
   {
     using T = typename std::iterator_traits<ForwardIt>::value_type;
     std::reverse_iterator<ForwardIt> rfirst(last);
@@ -246,7 +242,7 @@ namespace acc
   }
 
   template <typename ForwardIt>
-  inline bool next_permutation(ForwardIt first, ForwardIt last)
+  ACC_CONSTEXPR17 bool next_permutation(ForwardIt first, ForwardIt last)
   {
     return acc::next_permutation(first, last, std::less<>{});
   }
@@ -255,7 +251,7 @@ namespace acc
   // prev_permutation (note weakened iterator category)
 
   template <typename ForwardIt, typename Compare>
-  inline bool prev_permutation(ForwardIt first, ForwardIt last, Compare cmp)
+  ACC_CONSTEXPR17 bool prev_permutation(ForwardIt first, ForwardIt last, Compare cmp)
   {
     using T = typename std::iterator_traits<ForwardIt>::value_type;
     std::reverse_iterator<ForwardIt> rfirst(last);
@@ -282,7 +278,7 @@ namespace acc
   }
 
   template <typename ForwardIt>
-  inline bool prev_permutation(ForwardIt first, ForwardIt last)
+  ACC_CONSTEXPR17 bool prev_permutation(ForwardIt first, ForwardIt last)
   {
     return acc::prev_permutation(first, last, std::less<>{});
   }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "accumulate.h"
+#include "config.h"
 
 #include <iterator>
 #include <functional>
@@ -47,7 +48,7 @@ namespace acc
   // copy, copy_if and copy_n
 
   template <typename InputIt, typename OutputIt>
-  inline OutputIt copy(
+  ACC_CONSTEXPR17 OutputIt copy(
       InputIt first, InputIt last,
       OutputIt d_first)
   {
@@ -61,7 +62,7 @@ namespace acc
   }
 
   template <typename InputIt, typename OutputIt, typename UnaryPredicate>
-  inline OutputIt copy_if(
+  ACC_CONSTEXPR17 OutputIt copy_if(
       InputIt first, InputIt last,
       OutputIt d_first, UnaryPredicate p)
   {
@@ -78,7 +79,7 @@ namespace acc
   }
 
   template <typename InputIt, typename Size, typename OutputIt>
-  inline OutputIt copy_n(
+  ACC_CONSTEXPR17 OutputIt copy_n(
       InputIt first, Size count, OutputIt result)
   {
     if (count <= Size{0}) return result;
@@ -95,53 +96,43 @@ namespace acc
   // copy_while - a useful extra algorithm (and a helper for merge)
 
   template <typename InputIt, typename OutputIt, typename UnaryPredicate>
-  inline std::pair<OutputIt, InputIt> copy_while(
+  ACC_CONSTEXPR17 std::pair<OutputIt, InputIt> copy_while(
       InputIt first, InputIt last,
       OutputIt d_first,
       UnaryPredicate p)
   {
     using P = std::pair<OutputIt, InputIt>;
-    try
-    {
-      OutputIt o = acc::accumulate_iter(
-          first, last, d_first,
-          [&] (OutputIt d, InputIt a) {
-            if (!p(*a)) throw P{ d, a };
-            *d = *a;
-            return ++d;
-          });
-      return P{ o, last };
-    }
-    catch (P& p)
-    {
-      return p;
-    }
+    return acc::accumulate_iter_until(
+        first, last, P{ d_first, last },
+        [&] (P d, const InputIt& a) {
+          if (!p(*a)) return acc::done(P{ d.first, a });
+          *d.first = *a;
+          return acc::cont(P{ ++d.first, d.second });
+        });
   }
 
   // ---------------------------------------------------------------------------
   // copy_backward
 
   template <typename InputIt, typename BidirIt>
-  inline BidirIt copy_backward(
+  ACC_CONSTEXPR17 BidirIt copy_backward(
       InputIt first, InputIt last,
       BidirIt d_last)
   {
-    using T = typename std::iterator_traits<InputIt>::reference;
-    using F = std::function<BidirIt(BidirIt)>;
-    return acc::accumulate<InputIt, F, std::function<F(F, T)>>(
-        first, last, [] (BidirIt d) { return d; },
-        [] (F a, const T b) {
-          return [a = std::move(a), &b] (BidirIt d) {
-            *(--d) = b;
-            return a(d); };
-        })(d_last);
+    using T = typename std::iterator_traits<InputIt>::value_type;
+    return acc::accumulate_cont(
+        first, last, d_last,
+        [] (BidirIt d, const T& b) {
+          *(--d) = b;
+          return d;
+        });
   }
 
   // ---------------------------------------------------------------------------
   // move and move_backward
 
   template <typename InputIt, typename OutputIt>
-  inline OutputIt move(
+  ACC_CONSTEXPR17 OutputIt move(
       InputIt first, InputIt last,
       OutputIt d_first)
   {
@@ -155,26 +146,24 @@ namespace acc
   }
 
   template <typename InputIt, typename BidirIt>
-  inline BidirIt move_backward(
+  ACC_CONSTEXPR17 BidirIt move_backward(
       InputIt first, InputIt last,
       BidirIt d_last)
   {
-    using T = typename std::iterator_traits<InputIt>::reference;
-    using F = std::function<BidirIt(BidirIt)>;
-    return acc::accumulate<InputIt, F, std::function<F(F, T)>>(
-        first, last, [] (BidirIt d) { return d; },
-        [] (F a, T& b) {
-          return [a = std::move(a), &b] (BidirIt d) {
-            *(--d) = std::move(b);
-            return a(d); };
-        })(d_last);
+    using T = typename std::iterator_traits<InputIt>::value_type;
+    return acc::accumulate_cont(
+        first, last, d_last,
+        [] (BidirIt d, T& b) {
+          *(--d) = std::move(b);
+          return d;
+        });
   }
 
   // ---------------------------------------------------------------------------
   // fill and fill_n
 
   template <typename ForwardIt, typename T>
-  inline void fill(
+  ACC_CONSTEXPR17 void fill(
       ForwardIt first, ForwardIt last,
       const T& value)
   {
@@ -187,7 +176,7 @@ namespace acc
   }
 
   template <typename OutputIt, typename Size, typename T>
-  inline OutputIt fill_n(
+  ACC_CONSTEXPR17 OutputIt fill_n(
       OutputIt first, Size count, const T& value)
   {
     if (count <= Size{0}) return first;
@@ -204,33 +193,34 @@ namespace acc
   // transform
 
   template <typename InputIt, typename OutputIt, typename UnaryOperation>
-  inline OutputIt transform(
+  ACC_CONSTEXPR17 OutputIt transform(
       InputIt first1, InputIt last1, OutputIt d_first,
       UnaryOperation unary_op)
   {
     using T = typename std::iterator_traits<InputIt>::value_type;
-    return acc::accumulate(
+    return acc::accumulate_inplace(
         first1, last1, d_first,
-        [&] (OutputIt d, const T& a) {
+        [&] (OutputIt& d, const T& a) {
           *d = unary_op(a);
-          return ++d;
+          ++d;
         });
   }
 
   template <typename InputIt1, typename InputIt2,
             typename OutputIt, typename BinaryOperation>
-  inline OutputIt transform(
+  ACC_CONSTEXPR17 OutputIt transform(
       InputIt1 first1, InputIt1 last1, InputIt2 first2,
       OutputIt d_first,
       BinaryOperation binary_op)
   {
     using T = typename std::iterator_traits<InputIt1>::value_type;
     using P = std::pair<InputIt2, OutputIt>;
-    return acc::accumulate(
+    return acc::accumulate_inplace(
         first1, last1, P{ first2, d_first },
-        [&] (P d, const T& a) {
+        [&] (P& d, const T& a) {
           *d.second = binary_op(a, *d.first);
-          return P{ ++d.first, ++d.second };
+          ++d.first;
+          ++d.second;
         }).second;
   }
 
@@ -238,7 +228,7 @@ namespace acc
   // generate and generate_n
 
   template <typename ForwardIt, typename Generator>
-  inline void generate(
+  ACC_CONSTEXPR17 void generate(
       ForwardIt first, ForwardIt last, Generator g)
   {
     acc::accumulate_iter(
@@ -250,7 +240,7 @@ namespace acc
   }
 
   template <typename OutputIt, typename Size, typename Generator>
-  inline OutputIt generate_n(
+  ACC_CONSTEXPR17 OutputIt generate_n(
       OutputIt first, Size count, Generator g)
   {
     if (count < Size{0}) return first;
@@ -267,7 +257,7 @@ namespace acc
   // remove_copy and remove_copy_if
 
   template <typename InputIt, typename OutputIt, typename T>
-  inline OutputIt remove_copy(
+  ACC_CONSTEXPR17 OutputIt remove_copy(
       InputIt first, InputIt last,
       OutputIt d_first, const T& value)
   {
@@ -282,7 +272,7 @@ namespace acc
   }
 
   template <typename InputIt, typename OutputIt, typename UnaryPredicate>
-  inline InputIt remove_copy_if(
+  ACC_CONSTEXPR17 InputIt remove_copy_if(
       InputIt first, InputIt last,
       OutputIt d_first, UnaryPredicate p)
   {
@@ -300,7 +290,7 @@ namespace acc
   // remove and remove_if
 
   template <typename ForwardIt, typename T>
-  inline ForwardIt remove(
+  ACC_CONSTEXPR17 ForwardIt remove(
       ForwardIt first, ForwardIt last,
       const T& value)
   {
@@ -308,7 +298,7 @@ namespace acc
   }
 
   template <typename ForwardIt, typename UnaryPredicate>
-  inline ForwardIt remove_if(
+  ACC_CONSTEXPR17 ForwardIt remove_if(
       ForwardIt first, ForwardIt last,
       UnaryPredicate p)
   {
@@ -319,7 +309,7 @@ namespace acc
   // replace_copy and replace_copy_if
 
   template <typename InputIt, typename OutputIt, typename T>
-  inline OutputIt replace_copy(
+  ACC_CONSTEXPR17 OutputIt replace_copy(
       InputIt first, InputIt last,
       OutputIt d_first,
       const T& old_value, const T& new_value)
@@ -335,7 +325,7 @@ namespace acc
 
   template <typename InputIt, typename OutputIt,
             typename UnaryPredicate, typename T>
-  inline InputIt replace_copy_if(
+  ACC_CONSTEXPR17 InputIt replace_copy_if(
       InputIt first, InputIt last,
       OutputIt d_first, UnaryPredicate p,
       const T& new_value)
@@ -353,7 +343,7 @@ namespace acc
   // replace and replace_if
 
   template <typename ForwardIt, typename T>
-  inline void replace(
+  ACC_CONSTEXPR17 void replace(
       ForwardIt first, ForwardIt last,
       const T& old_value, const T& new_value)
   {
@@ -361,7 +351,7 @@ namespace acc
   }
 
   template <typename ForwardIt, typename UnaryPredicate, typename T>
-  inline void replace_if(
+  ACC_CONSTEXPR17 void replace_if(
       ForwardIt first, ForwardIt last,
       UnaryPredicate p, const T& old_value)
   {
@@ -372,7 +362,7 @@ namespace acc
   // swap_ranges
 
   template <typename ForwardIt1, typename ForwardIt2>
-  inline ForwardIt2 swap_ranges(
+  ACC_CONSTEXPR17 ForwardIt2 swap_ranges(
       ForwardIt1 first1, ForwardIt1 last1,
       ForwardIt2 first2)
   {
@@ -388,47 +378,43 @@ namespace acc
   // reverse (note weakened iterator category)
 
   template <typename ForwardIt>
-  inline void reverse(ForwardIt first, ForwardIt last)
+  ACC_CONSTEXPR17 void reverse(ForwardIt first, ForwardIt last)
   {
     using diff_t = typename std::iterator_traits<ForwardIt>::difference_type;
     diff_t d = std::distance(first, last);
     ForwardIt mid = first;
     std::advance(mid, d/2);
 
-    using F = std::function<ForwardIt(ForwardIt)>;
-    auto f = acc::accumulate_iter<ForwardIt, F, std::function<F(F, ForwardIt)>>(
-        first, mid, [] (ForwardIt i) { return i; },
-        [&] (F a, ForwardIt b) {
-          return [a = std::move(a), b] (ForwardIt i) {
-            std::iter_swap(i, b);
-            return a(++i); };
+    ForwardIt back = mid;
+    if (d&1) ++back;
+    acc::accumulate_iter_cont(
+        first, mid, back,
+        [] (ForwardIt i, ForwardIt b) {
+          std::iter_swap(i, b);
+          return ++i;
         });
-    if (d&1) ++mid;
-    f(mid);
   }
   
   // ---------------------------------------------------------------------------
   // reverse_copy (note weakened iterator category)
 
   template <typename InputIt, typename OutputIt>
-  inline OutputIt reverse_copy(InputIt first, InputIt last, OutputIt d_first)
+  ACC_CONSTEXPR17 OutputIt reverse_copy(InputIt first, InputIt last, OutputIt d_first)
   {
-    using T = typename std::iterator_traits<InputIt>::reference;
-    using F = std::function<OutputIt(OutputIt)>;
-    return acc::accumulate<InputIt, F, std::function<F(F, T)>>(
-        first, last, [] (OutputIt d) { return d; },
-        [] (F a, const T b) {
-          return [a = std::move(a), &b] (OutputIt d) {
-            *d = b;
-            return a(++d); };
-        })(d_first);
+    using T = typename std::iterator_traits<InputIt>::value_type;
+    return acc::accumulate_cont(
+        first, last, d_first,
+        [] (OutputIt d, const T& b) {
+          *d = b;
+          return ++d;
+        });
   }
 
   // ---------------------------------------------------------------------------
   // rotate
 
   template <typename ForwardIt>
-  inline ForwardIt rotate(ForwardIt first, ForwardIt n_first, ForwardIt last)
+  ACC_CONSTEXPR17 ForwardIt rotate(ForwardIt first, ForwardIt n_first, ForwardIt last)
   {
     if (n_first == last) return first;
     ForwardIt ret = first;
@@ -451,7 +437,7 @@ namespace acc
   // rotate_copy
 
   template <typename ForwardIt, typename OutputIt>
-  inline OutputIt rotate_copy(
+  ACC_CONSTEXPR17 OutputIt rotate_copy(
       ForwardIt first, ForwardIt n_first,
       ForwardIt last, OutputIt d_first)
   {
@@ -485,7 +471,7 @@ namespace acc
   // unique and unique_copy
 
   template <typename InputIt, typename OutputIt, typename BinaryPredicate>
-  inline OutputIt unique_copy(
+  ACC_CONSTEXPR17 OutputIt unique_copy(
       InputIt first, InputIt last,
       OutputIt d_first, BinaryPredicate p)
   {
@@ -494,16 +480,16 @@ namespace acc
     if (first == last) return d_first;
     U init = *first;
     *d_first = init;
-    return acc::accumulate(
+    return acc::accumulate_inplace(
         ++first, last, P{ ++d_first, std::move(init) },
-        [&] (P a, const U& b) {
+        [&] (P& a, const U& b) {
           if (!p(a.second, b)) *a.first++ = b;
-          return P{ a.first, b };
+          a.second = b;
         }).first;
   }
 
   template <typename ForwardIt, typename BinaryPredicate>
-  inline ForwardIt unique(
+  ACC_CONSTEXPR17 ForwardIt unique(
       ForwardIt first, ForwardIt last, BinaryPredicate p)
   {
     return acc::unique_copy(first, last, first, p);
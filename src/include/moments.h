@@ -0,0 +1,266 @@
+#pragma once
+
+#include "functional.h"
+#include "monoid.h"
+#include "simd.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <type_traits>
+
+// ---------------------------------------------------------------------------
+// moments
+//
+// The count, mean, variance and skewness of a stream, in one pass, kept as
+// the count, the mean, and the sums of the squared and cubed deviations from
+// it. insert(x) is Welford's update; merge combines the moments of two
+// streams with the pairwise formulas of Chan et al. (extended to the third
+// moment by Pebay), which never subtract the large sums that make the naive
+// sum-of-squares formula lose its precision.
+//
+// So a stream can be split across threads or processes, and the partial
+// moments merged, with the same answer (up to rounding) as one
+// acc::accumulate with acc::insert_op. moments is trivially copyable, so
+// acc::serializer already sends it between processes.
+//
+// insert(first, last) works a block at a time: one SIMD loop (AVX2 where the
+// host has it) sums the powers of the block's deviations from its first
+// value, which is close enough to the block's mean for the block's moments
+// to follow from them accurately, and then one merge adds in the block.
+//
+
+namespace acc
+{
+  namespace detail
+  {
+    // the sums of d, d^2 and d^3 for d = x[i] - k
+    struct power_sums
+    {
+      double s1 = 0;
+      double s2 = 0;
+      double s3 = 0;
+    };
+
+    inline power_sums power_sums_scalar(const double* x, std::size_t n,
+                                            double k)
+    {
+      // four of each sum, to hide the latency of the adds
+      double s1[4] = {}, s2[4] = {}, s3[4] = {};
+      std::size_t i = 0;
+      for (; i + 4 <= n; i += 4) {
+        for (std::size_t j = 0; j < 4; ++j) {
+          auto d = x[i + j] - k;
+          auto d2 = d * d;
+          s1[j] += d;
+          s2[j] += d2;
+          s3[j] += d2 * d;
+        }
+      }
+      power_sums s;
+      for (; i < n; ++i) {
+        auto d = x[i] - k;
+        s.s1 += d;
+        s.s2 += d * d;
+        s.s3 += d * d * d;
+      }
+      s.s1 += (s1[0] + s1[1]) + (s1[2] + s1[3]);
+      s.s2 += (s2[0] + s2[1]) + (s2[2] + s2[3]);
+      s.s3 += (s3[0] + s3[1]) + (s3[2] + s3[3]);
+      return s;
+    }
+
+#ifdef ACC_SIMD_X86
+    __attribute__((target("avx2")))
+    inline double hsum_avx2(__m256d a)
+    {
+      double lanes[4];
+      _mm256_storeu_pd(lanes, a);
+      return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    }
+
+    __attribute__((target("avx2")))
+    inline power_sums power_sums_avx2(const double* x, std::size_t n,
+                                          double k)
+    {
+      const auto m = _mm256_set1_pd(k);
+      auto s1 = _mm256_setzero_pd(), s2 = s1, s3 = s1;
+      auto t1 = s1, t2 = s1, t3 = s1;
+      std::size_t i = 0;
+      for (; i + 8 <= n; i += 8) {
+        auto d = _mm256_sub_pd(_mm256_loadu_pd(x + i), m);
+        auto e = _mm256_sub_pd(_mm256_loadu_pd(x + i + 4), m);
+        auto d2 = _mm256_mul_pd(d, d);
+        auto e2 = _mm256_mul_pd(e, e);
+        s1 = _mm256_add_pd(s1, d);
+        t1 = _mm256_add_pd(t1, e);
+        s2 = _mm256_add_pd(s2, d2);
+        t2 = _mm256_add_pd(t2, e2);
+        s3 = _mm256_add_pd(s3, _mm256_mul_pd(d2, d));
+        t3 = _mm256_add_pd(t3, _mm256_mul_pd(e2, e));
+      }
+      auto s = power_sums_scalar(x + i, n - i, k);
+      s.s1 += hsum_avx2(_mm256_add_pd(s1, t1));
+      s.s2 += hsum_avx2(_mm256_add_pd(s2, t2));
+      s.s3 += hsum_avx2(_mm256_add_pd(s3, t3));
+      return s;
+    }
+#endif
+
+    inline power_sums power_sums_of(const double* x, std::size_t n,
+                                        double k)
+    {
+#ifdef ACC_SIMD_X86
+      if (simd::best_isa() >= simd::isa::avx2) {
+        return power_sums_avx2(x, n, k);
+      }
+#endif
+      return power_sums_scalar(x, n, k);
+    }
+  }
+
+  template <typename T = double>
+  class moments
+  {
+    static_assert(std::is_floating_point<T>::value,
+                  "moments are kept in floating point");
+
+  public:
+    using value_type = T;
+
+    moments() = default;
+
+    template <typename U>
+    void insert(const U& u)
+    {
+      auto x = static_cast<T>(u);
+      auto n = static_cast<T>(n_);
+      auto d = x - mean_;
+      auto dn = d / (n + 1);
+      auto t = d * dn * n;
+      mean_ += dn;
+      m3_ += t * dn * (n - 1) - 3 * dn * m2_;
+      m2_ += t;
+      ++n_;
+    }
+
+    template <typename InputIt>
+    void insert(InputIt first, InputIt last)
+    {
+      insert_range(first, last, is_double_range<InputIt>{});
+    }
+
+    void merge(const moments& other)
+    {
+      if (other.n_ == 0) return;
+      if (n_ == 0) {
+        *this = other;
+        return;
+      }
+      auto na = static_cast<T>(n_);
+      auto nb = static_cast<T>(other.n_);
+      auto n = na + nb;
+      auto d = other.mean_ - mean_;
+      auto dn = d / n;
+      auto t = d * dn * na * nb;
+      mean_ += dn * nb;
+      m3_ += other.m3_ + t * dn * (na - nb) + 3 * dn * (na * other.m2_ - nb * m2_);
+      m2_ += other.m2_ + t;
+      n_ += other.n_;
+    }
+
+    std::uint64_t count() const { return n_; }
+    T mean() const { return mean_; }
+
+    // the population variance, and the sample (n - 1) variance: 0 with too
+    // few values
+    T variance() const { return n_ > 0 ? m2_ / static_cast<T>(n_) : T{0}; }
+    T sample_variance() const
+    {
+      return n_ > 1 ? m2_ / static_cast<T>(n_ - 1) : T{0};
+    }
+
+    // the population skewness: 0 if there's no variance
+    T skewness() const
+    {
+      if (!(m2_ > 0)) return T{0};
+      return std::sqrt(static_cast<T>(n_)) * m3_ / std::pow(m2_, T{1.5});
+    }
+
+    friend bool operator==(const moments& a, const moments& b)
+    {
+      return a.n_ == b.n_ && a.mean_ == b.mean_
+        && a.m2_ == b.m2_ && a.m3_ == b.m3_;
+    }
+
+    friend bool operator!=(const moments& a, const moments& b)
+    {
+      return !(a == b);
+    }
+
+  private:
+    static constexpr std::size_t block = 256;
+
+    template <typename It>
+    using is_double_range = std::integral_constant<
+      bool,
+      simd::is_contiguous<It>::value
+      && std::is_same<typename std::iterator_traits<It>::value_type, double>::value>;
+
+    // the moments of a block, from the sums of the powers of its deviations
+    // from its first value, merged in
+    void insert_block(const double* x, std::size_t n)
+    {
+      auto k = x[0];
+      auto s = detail::power_sums_of(x, n, k);
+      auto c = s.s1 / static_cast<double>(n);
+      moments b;
+      b.n_ = n;
+      b.mean_ = static_cast<T>(k + c);
+      b.m2_ = static_cast<T>(s.s2 - s.s1 * c);
+      b.m3_ = static_cast<T>(s.s3 - 3 * c * s.s2 + 2 * s.s1 * c * c);
+      merge(b);
+    }
+
+    template <typename InputIt>
+    void insert_range(InputIt first, InputIt last, std::false_type)
+    {
+      double x[block];
+      while (first != last) {
+        std::size_t n = 0;
+        for (; n < block && first != last; ++first) x[n++] = static_cast<double>(*first);
+        insert_block(x, n);
+      }
+    }
+
+    template <typename ContiguousIt>
+    void insert_range(ContiguousIt first, ContiguousIt last, std::true_type)
+    {
+      if (first == last) return;
+      auto p = simd::to_pointer(first);
+      auto n = static_cast<std::size_t>(last - first);
+      for (std::size_t i = 0; i < n; i += block) {
+        insert_block(p + i, std::min(std::size_t{block}, n - i));
+      }
+    }
+
+    std::uint64_t n_ = 0;
+    T mean_ = 0;
+    T m2_ = 0;
+    T m3_ = 0;
+  };
+
+  // ---------------------------------------------------------------------------
+  // the merge monoid
+
+  template <typename T>
+  struct monoid<merge_op, moments<T>>
+    : detail::commutative_monoid<moments<T>>
+  {
+    static constexpr bool has_absorbing = false;
+    static moments<T> identity() { return {}; }
+  };
+
+}
@@ -0,0 +1,250 @@
+#pragma once
+
+#include "functional.h"
+
+#include <functional>
+#include <limits>
+#include <map>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+
+// ---------------------------------------------------------------------------
+// monoid
+//
+// What a fold may assume about an operation over a type: whether it is
+// associative (so the range may be split and reordered), commutative (so
+// partials may be combined in any order), its identity, and its absorbing
+// element, if any (once the accumulator holds it, the rest of the range
+// cannot change the result).
+//
+// The primary template assumes nothing. Specialize acc::monoid<Op, T> to
+// register an operation; the members are
+//
+//   static constexpr bool is_associative, is_commutative,
+//                         has_identity, has_absorbing;
+//   static T identity();   // when has_identity
+//   static T absorbing();  // when has_absorbing
+//
+// Built in: plus and multiplies over integers, minimum and maximum over
+// arithmetic types, logical_and and logical_or over bool, bit_and, bit_or
+// and bit_xor over integers, plus over strings (concatenation), and
+// map_merge over std::map and std::unordered_map.
+//
+// Floating-point plus and multiplies are deliberately not registered: they
+// are not associative, so a fold only reorders them when asked to, with an
+// unsequenced policy.
+//
+
+namespace acc
+{
+  template <typename Op, typename T, typename = void>
+  struct monoid
+  {
+    static constexpr bool is_associative = false;
+    static constexpr bool is_commutative = false;
+    static constexpr bool has_identity = false;
+    static constexpr bool has_absorbing = false;
+  };
+
+  namespace detail
+  {
+    template <typename T>
+    using is_integer = std::integral_constant<
+      bool, std::is_integral<T>::value && !std::is_same<T, bool>::value>;
+
+    // the commutative monoids with an identity, differing only in absorbing
+    template <typename T>
+    struct commutative_monoid
+    {
+      static constexpr bool is_associative = true;
+      static constexpr bool is_commutative = true;
+      static constexpr bool has_identity = true;
+    };
+  }
+
+  // ---------------------------------------------------------------------------
+  // plus and multiplies over integers: exact (unsigned arithmetic wraps), so
+  // free to reorder
+
+  template <typename Op, typename T>
+  struct monoid<Op, T, std::enable_if_t<
+                         detail::is_integer<T>::value
+                         && is_op<std::plus, Op, T>::value>>
+    : detail::commutative_monoid<T>
+  {
+    static constexpr bool has_absorbing = false;
+    static constexpr T identity() { return T{0}; }
+  };
+
+  template <typename Op, typename T>
+  struct monoid<Op, T, std::enable_if_t<
+                         detail::is_integer<T>::value
+                         && is_op<std::multiplies, Op, T>::value>>
+    : detail::commutative_monoid<T>
+  {
+    static constexpr bool has_absorbing = true;
+    static constexpr T identity() { return T{1}; }
+    static constexpr T absorbing() { return T{0}; }
+  };
+
+  // ---------------------------------------------------------------------------
+  // minimum and maximum over arithmetic types: the identity is the extreme at
+  // the other end, and the extreme at this end absorbs
+
+  template <typename Op, typename T>
+  struct monoid<Op, T, std::enable_if_t<
+                         std::is_arithmetic<T>::value
+                         && is_op<acc::minimum, Op, T>::value>>
+    : detail::commutative_monoid<T>
+  {
+    using L = std::numeric_limits<T>;
+    static constexpr bool has_absorbing = true;
+    static constexpr T identity()
+    {
+      return L::has_infinity ? L::infinity() : L::max();
+    }
+    static constexpr T absorbing()
+    {
+      return L::has_infinity ? -L::infinity() : L::lowest();
+    }
+  };
+
+  template <typename Op, typename T>
+  struct monoid<Op, T, std::enable_if_t<
+                         std::is_arithmetic<T>::value
+                         && is_op<acc::maximum, Op, T>::value>>
+    : detail::commutative_monoid<T>
+  {
+    using L = std::numeric_limits<T>;
+    static constexpr bool has_absorbing = true;
+    static constexpr T identity()
+    {
+      return L::has_infinity ? -L::infinity() : L::lowest();
+    }
+    static constexpr T absorbing()
+    {
+      return L::has_infinity ? L::infinity() : L::max();
+    }
+  };
+
+  // ---------------------------------------------------------------------------
+  // logical_and and logical_or over bool
+
+  template <typename Op>
+  struct monoid<Op, bool, std::enable_if_t<
+                            is_op<std::logical_and, Op, bool>::value>>
+    : detail::commutative_monoid<bool>
+  {
+    static constexpr bool has_absorbing = true;
+    static constexpr bool identity() { return true; }
+    static constexpr bool absorbing() { return false; }
+  };
+
+  template <typename Op>
+  struct monoid<Op, bool, std::enable_if_t<
+                            is_op<std::logical_or, Op, bool>::value>>
+    : detail::commutative_monoid<bool>
+  {
+    static constexpr bool has_absorbing = true;
+    static constexpr bool identity() { return false; }
+    static constexpr bool absorbing() { return true; }
+  };
+
+  // ---------------------------------------------------------------------------
+  // bit_and, bit_or and bit_xor over integers
+
+  template <typename Op, typename T>
+  struct monoid<Op, T, std::enable_if_t<
+                         detail::is_integer<T>::value
+                         && is_op<std::bit_and, Op, T>::value>>
+    : detail::commutative_monoid<T>
+  {
+    static constexpr bool has_absorbing = true;
+    static constexpr T identity() { return static_cast<T>(~T{0}); }
+    static constexpr T absorbing() { return T{0}; }
+  };
+
+  template <typename Op, typename T>
+  struct monoid<Op, T, std::enable_if_t<
+                         detail::is_integer<T>::value
+                         && is_op<std::bit_or, Op, T>::value>>
+    : detail::commutative_monoid<T>
+  {
+    static constexpr bool has_absorbing = true;
+    static constexpr T identity() { return T{0}; }
+    static constexpr T absorbing() { return static_cast<T>(~T{0}); }
+  };
+
+  template <typename Op, typename T>
+  struct monoid<Op, T, std::enable_if_t<
+                         detail::is_integer<T>::value
+                         && is_op<std::bit_xor, Op, T>::value>>
+    : detail::commutative_monoid<T>
+  {
+    static constexpr bool has_absorbing = false;
+    static constexpr T identity() { return T{0}; }
+  };
+
+  // ---------------------------------------------------------------------------
+  // string concatenation: associative, but order matters
+
+  template <typename Op, typename C, typename Tr, typename A>
+  struct monoid<Op, std::basic_string<C, Tr, A>, std::enable_if_t<
+                  is_op<std::plus, Op, std::basic_string<C, Tr, A>>::value>>
+  {
+    static constexpr bool is_associative = true;
+    static constexpr bool is_commutative = false;
+    static constexpr bool has_identity = true;
+    static constexpr bool has_absorbing = false;
+    static std::basic_string<C, Tr, A> identity() { return {}; }
+  };
+
+  // ---------------------------------------------------------------------------
+  // map_merge: a monoid when the operation on the values is one
+
+  namespace detail
+  {
+    template <typename Op, typename Map>
+    struct map_monoid
+    {
+      using V = monoid<Op, typename Map::mapped_type>;
+      static constexpr bool is_associative = V::is_associative;
+      static constexpr bool is_commutative = V::is_commutative;
+      static constexpr bool has_identity = true;
+      static constexpr bool has_absorbing = false;
+      static Map identity() { return {}; }
+    };
+  }
+
+  template <typename Op, typename K, typename V, typename C, typename A>
+  struct monoid<map_merge<Op>, std::map<K, V, C, A>>
+    : detail::map_monoid<Op, std::map<K, V, C, A>>
+  {};
+
+  template <typename Op, typename K, typename V, typename H, typename E,
+            typename A>
+  struct monoid<map_merge<Op>, std::unordered_map<K, V, H, E, A>>
+    : detail::map_monoid<Op, std::unordered_map<K, V, H, E, A>>
+  {};
+
+  // ---------------------------------------------------------------------------
+  // queries, for dispatch
+
+  template <typename Op, typename T>
+  using is_associative = std::integral_constant<
+    bool, monoid<Op, std::decay_t<T>>::is_associative>;
+
+  template <typename Op, typename T>
+  using is_commutative = std::integral_constant<
+    bool, monoid<Op, std::decay_t<T>>::is_commutative>;
+
+  template <typename Op, typename T>
+  using has_identity = std::integral_constant<
+    bool, monoid<Op, std::decay_t<T>>::has_identity>;
+
+  template <typename Op, typename T>
+  using has_absorbing = std::integral_constant<
+    bool, monoid<Op, std::decay_t<T>>::has_absorbing>;
+
+}
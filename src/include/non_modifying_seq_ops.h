@@ -1,6 +1,7 @@
 #pragma once
 
 #include "accumulate.h"
+#include "config.h"
 
 #include <iterator>
 #include <utility>
@@ -32,78 +33,54 @@ namespace acc
   // find, find_if, find_if_not and derivatives
 
   template <typename InputIt, typename T>
-  inline InputIt find(
+  ACC_CONSTEXPR17 InputIt find(
       InputIt first, InputIt last, const T& value)
   {
-    try
-    {
-      return acc::accumulate_iter(
-          first, last, last,
-          [&] (const InputIt& a, const InputIt& b) {
-            if (*b == value) throw b;
-            return a;
-          });
-    }
-    catch (InputIt& i)
-    {
-      return i;
-    }
+    return acc::accumulate_iter_until(
+        first, last, last,
+        [&] (const InputIt& a, const InputIt& b) {
+          return *b == value ? acc::done(b) : acc::cont(a);
+        });
   }
 
   template <typename InputIt, typename UnaryPredicate>
-  inline InputIt find_if(
+  ACC_CONSTEXPR17 InputIt find_if(
       InputIt first, InputIt last, UnaryPredicate p)
   {
-    try
-    {
-      return acc::accumulate_iter(
-          first, last, last,
-          [&] (const InputIt& a, const InputIt& b) {
-            if (p(*b)) throw b;
-            return a;
-          });
-    }
-    catch (InputIt& i)
-    {
-      return i;
-    }
+    return acc::accumulate_iter_until(
+        first, last, last,
+        [&] (const InputIt& a, const InputIt& b) {
+          return p(*b) ? acc::done(b) : acc::cont(a);
+        });
   }
 
   template <typename InputIt, typename UnaryPredicate>
-  inline InputIt find_if_not(
+  ACC_CONSTEXPR17 InputIt find_if_not(
       InputIt first, InputIt last, UnaryPredicate p)
   {
-    try
-    {
-      return acc::accumulate_iter(
-          first, last, last,
-          [&] (const InputIt& a, const InputIt& b) {
-            if (!p(*b)) throw b;
-            return a;
-          });
-    }
-    catch (InputIt& i)
-    {
-      return i;
-    }
+    return acc::accumulate_iter_until(
+        first, last, last,
+        [&] (const InputIt& a, const InputIt& b) {
+          return !p(*b) ? acc::done(b) : acc::cont(a);
+        });
   }
 
   template <class InputIt, class UnaryPredicate>
-  inline bool all_of(
+  ACC_CONSTEXPR17 bool all_of(
       InputIt first, InputIt last, UnaryPredicate p)
   {
     return acc::find_if_not(first, last, p) == last;
   }
 
   template <class InputIt, class UnaryPredicate>
-  inline bool any_of(
+  ACC_CONSTEXPR17 bool any_of(
       InputIt first, InputIt last, UnaryPredicate p)
   {
     return acc::find_if(first, last, p) != last;
   }
 
   template <class InputIt, class UnaryPredicate>
-  inline bool none_of(
+  ACC_CONSTEXPR17 bool none_of(
       InputIt first, InputIt last, UnaryPredicate p)
   {
     return acc::find_if(first, last, p) == last;
@@ -113,7 +90,7 @@ namespace acc
   // for_each
 
   template <typename InputIt, typename UnaryFunction>
-  inline UnaryFunction for_each(
+  ACC_CONSTEXPR17 UnaryFunction for_each(
       InputIt first, InputIt last, UnaryFunction f)
   {
     using T = typename std::iterator_traits<InputIt>::value_type;
@@ -128,7 +105,7 @@ namespace acc
   // count and count_if
 
   template <typename InputIt, typename T>
-  inline typename std::iterator_traits<InputIt>::difference_type
+  ACC_CONSTEXPR17 typename std::iterator_traits<InputIt>::difference_type
   count(InputIt first, InputIt last, const T& value)
   {
     using DT = typename std::iterator_traits<InputIt>::difference_type;
@@ -141,7 +118,7 @@ namespace acc
   }
 
   template <typename InputIt, typename UnaryPredicate>
-  inline typename std::iterator_traits<InputIt>::difference_type
+  ACC_CONSTEXPR17 typename std::iterator_traits<InputIt>::difference_type
   count_if(InputIt first, InputIt last, UnaryPredicate p)
   {
     using DT = typename std::iterator_traits<InputIt>::difference_type;
@@ -159,50 +136,37 @@ namespace acc
 
   template <typename InputIt1, typename InputIt2,
             typename BinaryPredicate>
-  inline std::pair<InputIt1, InputIt2>
+  ACC_CONSTEXPR17 std::pair<InputIt1, InputIt2>
   mismatch(InputIt1 first1, InputIt1 last1,
            InputIt2 first2,
            BinaryPredicate p)
   {
     if (first1 == last1) return { first1, first2 };
     using P = std::pair<InputIt1, InputIt2>;
-    try
-    {
-     return acc::accumulate_iter(
-         first1, last1, P{ last1, first2 },
-         [&] (P a, const InputIt1& b) {
-           if (!p(*b, *a.second)) throw P{ b, a.second };
-           return P{ a.first, ++a.second };
-         });
-    }
-    catch (P& r)
-    {
-      return r;
-    }
+    return acc::accumulate_iter_until(
+        first1, last1, P{ last1, first2 },
+        [&] (P a, const InputIt1& b) {
+          if (!p(*b, *a.second)) return acc::done(P{ b, a.second });
+          return acc::cont(P{ a.first, ++a.second });
+        });
   }
 
   template <typename InputIt1, typename InputIt2,
             typename BinaryPredicate>
-  inline std::pair<InputIt1, InputIt2>
+  ACC_CONSTEXPR17 std::pair<InputIt1, InputIt2>
   mismatch(InputIt1 first1, InputIt1 last1,
            InputIt2 first2, InputIt2 last2,
            BinaryPredicate p)
   {
     if (first1 == last1 || first2 == last2) return { first1, first2 };
     using P = std::pair<InputIt1, InputIt2>;
-    try
-    {
-     return acc::accumulate_iter(
-         first1, last1, P{ last1, first2 },
-         [&] (P a, const InputIt1& b) {
-           if (a.second == last2 || !p(*b, *a.second)) throw P{ b, a.second };
-           return P{ a.first, ++a.second };
-         });
-    }
-    catch (P& r)
-    {
-      return r;
-    }
+    return acc::accumulate_iter_until(
+        first1, last1, P{ last1, first2 },
+        [&] (P a, const InputIt1& b) {
+          if (a.second == last2 || !p(*b, *a.second))
+            return acc::done(P{ b, a.second });
+          return acc::cont(P{ a.first, ++a.second });
+        });
   }
 
   // ---------------------------------------------------------------------------
@@ -210,57 +174,44 @@ namespace acc
 
   template <typename InputIt1, typename InputIt2,
             typename BinaryPredicate>
-  inline bool equal(
+  ACC_CONSTEXPR17 bool equal(
       InputIt1 first1, InputIt1 last1,
       InputIt2 first2,
       BinaryPredicate p)
   {
-    try
-    {
-      using P = std::pair<bool, InputIt2>;
-      using T = typename std::iterator_traits<InputIt1>::value_type;
-      return acc::accumulate(
-          first1, last1, P{ true, first2 },
-          [&] (P a, const T& b) {
-            if (!p(b, *a.second)) throw false;
-            return P{ true, ++a.second };
-          }).first;
-    }
-    catch (...)
-    {
-      return false;
-    }
+    using P = std::pair<bool, InputIt2>;
+    using T = typename std::iterator_traits<InputIt1>::value_type;
+    return acc::accumulate_until(
+        first1, last1, P{ true, first2 },
+        [&] (P a, const T& b) {
+          if (!p(b, *a.second)) return acc::done(P{ false, a.second });
+          return acc::cont(P{ true, ++a.second });
+        }).first;
   }
 
   template <typename InputIt1, typename InputIt2,
             typename BinaryPredicate>
-  inline bool equal(
+  ACC_CONSTEXPR17 bool equal(
       InputIt1 first1, InputIt1 last1,
       InputIt2 first2, InputIt2 last2,
       BinaryPredicate p)
   {
-    try
-    {
-      using P = std::pair<bool, InputIt2>;
-      return acc::accumulate_iter(
-          first1, last1, P{ true, first2 },
-          [&] (P a, const InputIt1& b) {
-            if (a.second == last2 || !p(*b, *a.second)) throw false;
-            auto next = ++a.second;
-            return P{ next == last2, next };
-          }).first;
-    }
-    catch (...)
-    {
-      return false;
-    }
+    using P = std::pair<bool, InputIt2>;
+    return acc::accumulate_iter_until(
+        first1, last1, P{ first2 == last2, first2 },
+        [&] (P a, const InputIt1& b) {
+          if (a.second == last2 || !p(*b, *a.second))
+            return acc::done(P{ false, a.second });
+          auto next = ++a.second;
+          return acc::cont(P{ next == last2, next });
+        }).first;
   }
 
   // ---------------------------------------------------------------------------
   // find_end
 
   template <typename ForwardIt1, typename ForwardIt2, typename BinaryPredicate>
-  inline ForwardIt1 find_end(
+  ACC_CONSTEXPR17 ForwardIt1 find_end(
       ForwardIt1 first, ForwardIt1 last,
       ForwardIt2 s_first, ForwardIt2 s_last,
       BinaryPredicate p)
@@ -278,75 +229,58 @@ namespace acc
   // find_first_of
 
   template <typename InputIt, typename ForwardIt, typename BinaryPredicate>
-  inline InputIt find_first_of(
+  ACC_CONSTEXPR17 InputIt find_first_of(
       InputIt first, InputIt last,
       ForwardIt s_first, ForwardIt s_last,
       BinaryPredicate p)
   {
-    try
-    {
-      using FT = typename std::iterator_traits<ForwardIt>::value_type;
-      return acc::accumulate_iter(
-          first, last, last,
-          [&] (const InputIt& l, const InputIt& i) {
-            if (acc::any_of(s_first, s_last,
-                            [&] (const FT& s) { return p(*i, s); })) throw i;
-            return l;
-          });
-    }
-    catch (InputIt& i)
-    {
-      return i;
-    }
+    using FT = typename std::iterator_traits<ForwardIt>::value_type;
+    return acc::accumulate_iter_until(
+        first, last, last,
+        [&] (const InputIt& l, const InputIt& i) {
+          if (acc::any_of(s_first, s_last,
+                          [&] (const FT& s) { return p(*i, s); }))
+            return acc::done(i);
+          return acc::cont(l);
+        });
   }
 
   // ---------------------------------------------------------------------------
   // adjacent_find
 
   template <typename ForwardIt, typename BinaryPredicate>
-  inline ForwardIt adjacent_find(
+  ACC_CONSTEXPR17 ForwardIt adjacent_find(
       ForwardIt first, ForwardIt last,
       BinaryPredicate p)
   {
     if (first == last) return last;
     ForwardIt prev = first;
-    try
-    {
-      return ++acc::accumulate_iter(
-          ++first, last, prev,
-          [&] (const ForwardIt& i, ForwardIt a) {
-            if (p(*i, *a)) throw i;
-            return a;
-          });
-    }
-    catch (ForwardIt& i)
-    {
-      return i;
-    }
+    // a match is always followed by another element, so if the fold ends on
+    // the last element, nothing was found
+    ForwardIt i = acc::accumulate_iter_until(
+        ++first, last, prev,
+        [&] (const ForwardIt& i, const ForwardIt& a) {
+          return p(*i, *a) ? acc::done(i) : acc::cont(a);
+        });
+    return std::next(i) == last ? last : i;
   }
 
   // ---------------------------------------------------------------------------
   // search
 
   template <typename ForwardIt1, typename ForwardIt2, typename BinaryPredicate>
-  inline ForwardIt1 search(
+  ACC_CONSTEXPR17 ForwardIt1 search(
       ForwardIt1 first, ForwardIt1 last,
       ForwardIt2 s_first, ForwardIt2 s_last,
       BinaryPredicate p)
   {
-    try
-    {
-      return acc::accumulate_iter(
-          first, last, first,
-          [&] (ForwardIt1 i, ForwardIt1) {
-            if (acc::mismatch(i, last, s_first, s_last, p).second == s_last) throw i;
-            return ++i;
-          });
-    }
-    catch (ForwardIt1& i)
-    {
-      return i;
-    }
+    return acc::accumulate_iter_until(
+        first, last, first,
+        [&] (ForwardIt1 i, ForwardIt1) {
+          if (acc::mismatch(i, last, s_first, s_last, p).second == s_last)
+            return acc::done(i);
+          return acc::cont(++i);
+        });
   }
 
   // ---------------------------------------------------------------------------
@@ -354,7 +288,7 @@ namespace acc
 
   template <typename ForwardIt, typename Size,
             typename T, typename BinaryPredicate>
-  inline ForwardIt search_n(
+  ACC_CONSTEXPR17 ForwardIt search_n(
       ForwardIt first, ForwardIt last,
       Size count, const T& val, BinaryPredicate p)
   {
@@ -371,7 +305,7 @@ namespace acc
   // ---------------------------------------------------------------------------
   // As seen above, many of the find-type algorithms work on input iterators,
   // which means that accumulate is really just working as a glorified for loop
-  // and the return has to be handled with an exception. This is unsatisfying.
+  // with an early exit (accumulate_until). This is unsatisfying.
   //
   // But: if we relax the iterator category to a forward iterator, we can write
   // _all versions of the same algorithms which find all the positions in the
@@ -385,7 +319,7 @@ namespace acc
   // find all positions in the sequence that satisfy the predicate
 
   template <typename ForwardIt, typename OutputIt, typename UnaryPredicate>
-  inline OutputIt find_if_all(
+  ACC_CONSTEXPR17 OutputIt find_if_all(
       ForwardIt first, ForwardIt last,
       OutputIt dest, UnaryPredicate p)
   {
@@ -404,7 +338,7 @@ namespace acc
   // applied to adjacent values
 
   template <typename ForwardIt, typename OutputIt, typename BinaryPredicate>
-  inline OutputIt adjacent_find_all(
+  ACC_CONSTEXPR17 OutputIt adjacent_find_all(
       ForwardIt first, ForwardIt last,
       OutputIt dest, BinaryPredicate p)
   {
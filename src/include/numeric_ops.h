@@ -1,8 +1,13 @@
 #pragma once
 
 #include "accumulate.h"
+#include "config.h"
+#include "execution.h"
+#include "simd.h"
 
+#include <cstddef>
 #include <iterator>
+#include <type_traits>
 #include <utility>
 
 // ---------------------------------------------------------------------------
@@ -21,7 +26,7 @@ namespace acc
   // iota
 
   template <typename ForwardIt, typename T>
-  inline void iota(ForwardIt first, ForwardIt last, T value)
+  ACC_CONSTEXPR17 void iota(ForwardIt first, ForwardIt last, T value)
   {
     acc::accumulate_iter(
         first, last, value,
@@ -33,27 +38,96 @@ namespace acc
   // ---------------------------------------------------------------------------
   // inner_product
 
+  namespace detail
+  {
+    template <typename InputIt1, typename InputIt2,
+              typename T,
+              typename BinaryOp1, typename BinaryOp2>
+    ACC_CONSTEXPR17 T inner_product(
+        InputIt1 first1, InputIt1 last1,
+        InputIt2 first2, T value,
+        BinaryOp1 op1, BinaryOp2 op2,
+        std::false_type)
+    {
+      using U = typename std::iterator_traits<InputIt1>::value_type;
+      return acc::accumulate(
+          first1, last1, value,
+          [&] (const T& v, const U& a) {
+            return op1(v, op2(a, *first2++));
+          });
+    }
+
+    // contiguous ranges of T with plus and multiplies: a SIMD dot product
+    template <typename InputIt1, typename InputIt2,
+              typename T,
+              typename BinaryOp1, typename BinaryOp2>
+    ACC_CONSTEXPR17 T inner_product(
+        InputIt1 first1, InputIt1 last1,
+        InputIt2 first2, T value,
+        BinaryOp1 op1, BinaryOp2 op2,
+        std::true_type)
+    {
+      if (ACC_IS_CONSTANT_EVALUATED()) {
+        return inner_product(first1, last1, first2, value, op1, op2,
+                             std::false_type{});
+      }
+      if (first1 == last1) return value;
+      return simd::dot(simd::to_pointer(first1), simd::to_pointer(first2),
+                       static_cast<std::size_t>(last1 - first1), value);
+    }
+
+    template <typename InputIt1, typename InputIt2, typename T,
+              typename BinaryOp1, typename BinaryOp2>
+    using simd_dot = std::integral_constant<
+      bool,
+      simd::is_kernel_type<T>::value
+      && simd::is_contiguous<InputIt1>::value
+      && simd::is_contiguous<InputIt2>::value
+      && std::is_same<typename std::iterator_traits<InputIt1>::value_type, T>::value
+      && std::is_same<typename std::iterator_traits<InputIt2>::value_type, T>::value
+      && std::is_same<simd::op_tag_t<BinaryOp1, T>, simd::op_plus>::value
+      && std::is_same<simd::op_tag_t<BinaryOp2, T>, simd::op_multiplies>::value>;
+  }
+
   template <typename InputIt1, typename InputIt2,
             typename T,
             typename BinaryOp1, typename BinaryOp2>
-  inline T inner_product(
+  ACC_CONSTEXPR17 T inner_product(
       InputIt1 first1, InputIt1 last1,
       InputIt2 first2, T value,
       BinaryOp1 op1, BinaryOp2 op2)
   {
-    using U = typename std::iterator_traits<InputIt1>::value_type;
-    return acc::accumulate(
-        first1, last1, value,
-        [&] (const T& v, const U& a) {
-          return op1(v, op2(a, *first2++));
-        });
+    // reassociation is only invisible for integers
+    using simd_dot = detail::simd_dot<InputIt1, InputIt2, T, BinaryOp1, BinaryOp2>;
+    return detail::inner_product(
+        first1, last1, first2, value, op1, op2,
+        std::integral_constant<
+          bool, simd_dot::value && std::is_integral<T>::value>{});
+  }
+
+  // ---------------------------------------------------------------------------
+  // inner_product (unsequenced): may reassociate, so floating-point ranges
+  // get the SIMD dot product too
+
+  template <typename InputIt1, typename InputIt2,
+            typename T,
+            typename BinaryOp1, typename BinaryOp2>
+  ACC_CONSTEXPR17 T inner_product(
+      const execution::unsequenced_policy&,
+      InputIt1 first1, InputIt1 last1,
+      InputIt2 first2, T value,
+      BinaryOp1 op1, BinaryOp2 op2)
+  {
+    return detail::inner_product(
+        first1, last1, first2, value, op1, op2,
+        detail::simd_dot<InputIt1, InputIt2, T, BinaryOp1, BinaryOp2>{});
   }
 
   // ---------------------------------------------------------------------------
   // adjacent_difference
 
   template <typename InputIt, typename OutputIt, typename BinaryOperation>
-  inline OutputIt adjacent_difference(
+  ACC_CONSTEXPR17 OutputIt adjacent_difference(
       InputIt first, InputIt last,
       OutputIt d_first, BinaryOperation op)
   {
@@ -62,11 +136,12 @@ namespace acc
     using P = std::pair<OutputIt, T>;
     T acc = *first;
     *d_first = acc;
-    return acc::accumulate(
+    return acc::accumulate_inplace(
         ++first, last, P{ ++d_first, std::move(acc) },
         [&] (P& p, const T& a) {
           *p.first = op(a, std::move(p.second));
-          return P{ ++p.first, a };
+          ++p.first;
+          p.second = a;
         }).first;
   }
 
@@ -74,7 +149,7 @@ namespace acc
   // partial_sum
 
   template <typename InputIt, typename OutputIt, typename BinaryOperation>
-  inline OutputIt partial_sum(
+  ACC_CONSTEXPR17 OutputIt partial_sum(
       InputIt first, InputIt last,
       OutputIt d_first, BinaryOperation op)
   {
@@ -83,12 +158,12 @@ namespace acc
     using P = std::pair<OutputIt, T>;
     T acc = *first;
     *d_first = acc;
-    return acc::accumulate(
+    return acc::accumulate_inplace(
         ++first, last, P{ ++d_first, std::move(acc) },
         [&] (P& p, const T& a) {
-          T acc = op(std::move(p.second), a);
-          *p.first = acc;
-          return P{ ++p.first, std::move(acc) };
+          p.second = op(std::move(p.second), a);
+          *p.first = p.second;
+          ++p.first;
         }).first;
   }
 
@@ -1,11 +1,18 @@
 #pragma once
 
 #include "accumulate.h"
+#include "config.h"
+#include "execution.h"
+#include "thread_pool.h"
 
 #include "modifying_seq_ops.h"
 #include "non_modifying_seq_ops.h"
 
+#include <algorithm>
+#include <cstddef>
 #include <iterator>
+#include <utility>
+#include <vector>
 
 // ---------------------------------------------------------------------------
 // 5 partitioning operations
@@ -16,6 +23,8 @@
 // stable_partition
 // partition_point
 //
+// partition and stable_partition also take a parallel policy.
+//
 
 namespace acc
 {
@@ -24,7 +33,7 @@ namespace acc
   // is_partitioned
 
   template <typename InputIt, typename UnaryPredicate>
-  inline bool is_partitioned(
+  ACC_CONSTEXPR17 bool is_partitioned(
       InputIt first, InputIt last, UnaryPredicate p)
   {
     using T = typename std::iterator_traits<InputIt>::value_type;
@@ -36,27 +45,177 @@ namespace acc
 
   // ---------------------------------------------------------------------------
   // partition and partition_copy
+  //
+  // Over random access iterators, partition works a block at a time, after
+  // Edelkamp and Weiss's BlockQuicksort: the offsets of the elements out of
+  // place in a block from each end are gathered without branches, and then
+  // swapped in pairs, so that the only branches that depend on the data are
+  // per block rather than per element. Over forward iterators (and what's
+  // left between the blocks), each element out of place is swapped as it's
+  // found.
+
+  namespace detail
+  {
+    constexpr std::ptrdiff_t partition_block = 64;
+
+    template <typename ForwardIt, typename UnaryPredicate>
+    ACC_CONSTEXPR17 ForwardIt partition(
+        ForwardIt first, ForwardIt last, UnaryPredicate& p,
+        std::forward_iterator_tag)
+    {
+      first = acc::find_if_not(first, last, p);
+      if (first == last) return first;
+      return acc::accumulate_iter(
+          std::next(first), last, first,
+          [&] (ForwardIt i, ForwardIt f) {
+            if (p(*f)) {
+              std::iter_swap(i, f);
+              return ++i;
+            }
+            return i;
+          });
+    }
+
+    template <typename RandomIt, typename UnaryPredicate>
+    ACC_CONSTEXPR17 RandomIt partition_blocks(
+        RandomIt first, RandomIt last, UnaryPredicate& p)
+    {
+      constexpr auto B = partition_block;
+      unsigned char offsets_l[B] = {};
+      unsigned char offsets_r[B] = {};
+      std::ptrdiff_t num_l = 0, num_r = 0, start_l = 0, start_r = 0;
+      while (last - first > 2*B) {
+        // the falses in the block from first, and the trues in the block
+        // back from last
+        if (num_l == 0) {
+          start_l = 0;
+          for (std::ptrdiff_t i = 0; i < B; ++i) {
+            offsets_l[num_l] = static_cast<unsigned char>(i);
+            num_l += !p(first[i]);
+          }
+        }
+        if (num_r == 0) {
+          start_r = 0;
+          for (std::ptrdiff_t i = 0; i < B; ++i) {
+            offsets_r[num_r] = static_cast<unsigned char>(i);
+            num_r += static_cast<bool>(p(last[-1 - i]));
+          }
+        }
+        // swap the pairs as one cycle, with two moves a pair rather than
+        // three
+        auto num = std::min(num_l, num_r);
+        if (num > 0) {
+          auto l = first + offsets_l[start_l];
+          auto r = last - 1 - offsets_r[start_r];
+          auto tmp = std::move(*l);
+          *l = std::move(*r);
+          for (std::ptrdiff_t k = 1; k < num; ++k) {
+            l = first + offsets_l[start_l + k];
+            *r = std::move(*l);
+            r = last - 1 - offsets_r[start_r + k];
+            *l = std::move(*r);
+          }
+          *r = std::move(tmp);
+        }
+        num_l -= num;
+        num_r -= num;
+        start_l += num;
+        start_r += num;
+        if (num_l == 0) first += B;
+        if (num_r == 0) last -= B;
+      }
+      // everything before first is true and everything from last on is
+      // false, whatever is left in a block half done
+      return detail::partition(first, last, p, std::forward_iterator_tag{});
+    }
+
+    template <typename RandomIt, typename UnaryPredicate>
+    ACC_CONSTEXPR17 RandomIt partition(
+        RandomIt first, RandomIt last, UnaryPredicate& p,
+        std::random_access_iterator_tag)
+    {
+      if (ACC_IS_CONSTANT_EVALUATED() || last - first <= 2*partition_block) {
+        return detail::partition(first, last, p, std::forward_iterator_tag{});
+      }
+      return detail::partition_blocks(first, last, p);
+    }
+  }
 
   template <typename ForwardIt, typename UnaryPredicate>
-  inline ForwardIt partition(
+  ACC_CONSTEXPR17 ForwardIt partition(
       ForwardIt first, ForwardIt last, UnaryPredicate p)
   {
-    first = acc::find_if_not(first, last, p);
-    if (first == last) return first;
-    return acc::accumulate_iter(
-        std::next(first), last, first,
-        [&] (ForwardIt i, ForwardIt f) {
-          if (p(*f)) {
-            std::iter_swap(i, f);
-            return ++i;
-          }
-          return i;
-        });
+    return detail::partition(
+        first, last, p,
+        typename std::iterator_traits<ForwardIt>::iterator_category{});
+  }
+
+  namespace detail
+  {
+    // -------------------------------------------------------------------------
+    // parallel partition: the chunks are partitioned as concurrent tasks,
+    // then the falses left of the final split point are swapped with the
+    // trues right of it
+
+    template <typename RandomIt, typename UnaryPredicate>
+    inline RandomIt partition_par(
+        const execution::parallel_policy& policy,
+        RandomIt first, RandomIt last, UnaryPredicate p)
+    {
+      using ST = std::size_t;
+      auto n = static_cast<ST>(last - first);
+      auto grain = policy.grain == 0 ? ST{1} : policy.grain;
+      auto chunks = std::min(policy.threads(), n / grain);
+      if (chunks <= 1) return acc::partition(first, last, p);
+
+      std::vector<RandomIt> bounds(chunks + 1);
+      std::vector<RandomIt> mids(chunks);
+      for (ST c = 0; c <= chunks; ++c) {
+        bounds[c] = first + static_cast<std::ptrdiff_t>(n * c / chunks);
+      }
+      task_group g;
+      for (ST c = 1; c < chunks; ++c) {
+        g.spawn([&, c] { mids[c] = acc::partition(bounds[c], bounds[c+1], p); });
+      }
+      mids[0] = acc::partition(bounds[0], bounds[1], p);
+      g.sync();
+
+      RandomIt split = first;
+      for (ST c = 0; c < chunks; ++c) split += mids[c] - bounds[c];
+
+      // each chunk is now [trues, falses)
+      using R = std::pair<RandomIt, RandomIt>;
+      std::vector<R> falses;
+      std::vector<R> trues;
+      for (ST c = 0; c < chunks; ++c) {
+        R f{ mids[c], std::min(bounds[c+1], split) };
+        if (f.first < f.second) falses.push_back(f);
+        R t{ std::max(bounds[c], split), mids[c] };
+        if (t.first < t.second) trues.push_back(t);
+      }
+      auto t = trues.begin();
+      RandomIt i = t == trues.end() ? split : t->first;
+      for (const auto& f : falses) {
+        for (RandomIt j = f.first; j != f.second; ++j, ++i) {
+          if (i == t->second) i = (++t)->first;
+          std::iter_swap(j, i);
+        }
+      }
+      return split;
+    }
+  }
+
+  template <typename RandomIt, typename UnaryPredicate>
+  inline RandomIt partition(
+      const execution::parallel_policy& policy,
+      RandomIt first, RandomIt last, UnaryPredicate p)
+  {
+    return detail::partition_par(policy, first, last, p);
   }
 
   template <typename InputIt, typename OutputIt1,
             typename OutputIt2, typename UnaryPredicate>
-  inline std::pair<OutputIt1, OutputIt2> partition_copy(
+  ACC_CONSTEXPR17 std::pair<OutputIt1, OutputIt2> partition_copy(
       InputIt first, InputIt last,
       OutputIt1 d_first_true, OutputIt2 d_first_false,
       UnaryPredicate p)
@@ -64,15 +223,14 @@ namespace acc
     using T = typename std::iterator_traits<InputIt>::value_type;
     using P = std::pair<OutputIt1, OutputIt2>;
 
-    return acc::accumulate(
+    return acc::accumulate_inplace(
         first, last, P{ d_first_true, d_first_false },
-        [&] (P r, const T& a) {
+        [&] (P& r, const T& a) {
           if (p(a)) {
             *r.first++ = a;
           } else {
             *r.second++ = a;
           }
-          return r;
         });
   }
 
@@ -80,7 +238,7 @@ namespace acc
   // stable_partition
 
   template <typename ForwardIt, typename UnaryPredicate>
-  inline ForwardIt stable_partition(
+  ACC_CONSTEXPR17 ForwardIt stable_partition(
       ForwardIt first, ForwardIt last, UnaryPredicate p)
   {
     auto n = std::distance(first, last);
@@ -95,4 +253,25 @@ namespace acc
         acc::stable_partition(m, last, p));
   }
 
+  // the two halves are partitioned as separate tasks, down to the policy's
+  // grain
+  template <typename RandomIt, typename UnaryPredicate>
+  inline RandomIt stable_partition(
+      const execution::parallel_policy& policy,
+      RandomIt first, RandomIt last, UnaryPredicate p)
+  {
+    auto n = last - first;
+    if (static_cast<std::size_t>(n) <= std::max(policy.grain, std::size_t{1})) {
+      return acc::stable_partition(first, last, p);
+    }
+    auto m = first + n/2;
+
+    RandomIt a = first;
+    RandomIt b = m;
+    acc::fork_join(
+        [&] { a = acc::stable_partition(policy, first, m, p); },
+        [&] { b = acc::stable_partition(policy, m, last, p); });
+    return acc::rotate(a, m, b);
+  }
+
 }
@@ -0,0 +1,379 @@
+#pragma once
+
+#include "accumulate.h"
+#include "config.h"
+#include "execution.h"
+#include "monoid.h"
+#include "simd.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <initializer_list>
+#include <memory>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// ---------------------------------------------------------------------------
+// reduce
+//
+// The same as accumulate, except that op is assumed to be associative, so a
+// random access range may be split into chunks that are folded independently
+// and the partial results combined in a balanced tree. Partials are always
+// combined in order, so op need not be commutative.
+//
+// What acc::monoid knows about op picks the strategy: a fold stops early once
+// it reaches op's absorbing element, and reduce without a policy reorders
+// only operations registered as associative.
+//
+// transform_reduce folds the results of a unary operation on each element.
+//
+
+namespace acc
+{
+  namespace detail
+  {
+    // -------------------------------------------------------------------------
+    // the number of independent accumulators used by unsequenced folds: enough
+    // to cover the latency of a floating-point add on current hardware
+
+    constexpr std::size_t unseq_lanes = 8;
+
+    // -------------------------------------------------------------------------
+    // combine partials pairwise: the combining tree has depth log2(n)
+
+    template <typename Partials, typename BinaryOperation>
+    ACC_CONSTEXPR17 auto tree_combine(
+        Partials& partials, BinaryOperation& op)
+    {
+      auto n = partials.size();
+      for (std::size_t stride = 1; stride < n; stride *= 2) {
+        for (std::size_t i = 0; i + stride < n; i += 2*stride) {
+          partials[i] = op(std::move(partials[i]),
+                           std::move(partials[i+stride]));
+        }
+      }
+      return std::move(partials[0]);
+    }
+
+    // -------------------------------------------------------------------------
+    // fold a non-empty range, seeded with its first element
+
+    template <typename T, typename InputIt, typename BinaryOperation>
+    ACC_CONSTEXPR17 T reduce_chunk(
+        InputIt first, InputIt last, BinaryOperation op,
+        execution::sequenced_policy)
+    {
+      T init = *first;
+      return acc::accumulate(++first, last, std::move(init), op);
+    }
+
+    // -------------------------------------------------------------------------
+    // fold a non-empty random access range with K accumulators, each over a
+    // contiguous lane of the range, stepped together so that the K dependency
+    // chains overlap. The tail joins the last lane, so the lanes still
+    // combine in order.
+
+    template <typename T, typename RandomIt, typename BinaryOperation,
+              std::size_t... Is>
+    ACC_CONSTEXPR17 T reduce_lanes(
+        RandomIt first, RandomIt last, BinaryOperation& op,
+        std::index_sequence<Is...>)
+    {
+      using DT = std::ptrdiff_t;
+      constexpr auto K = sizeof...(Is);
+      auto m = (last - first) / static_cast<DT>(K);
+
+      std::array<T, K> lanes = {{ T(first[static_cast<DT>(Is)*m])... }};
+      for (DT i = 1; i < m; ++i) {
+        (void)std::initializer_list<int>{
+          (lanes[Is] = op(std::move(lanes[Is]),
+                          first[static_cast<DT>(Is)*m + i]), 0)... };
+      }
+      lanes[K-1] = acc::accumulate(first + static_cast<DT>(K)*m, last,
+                                   std::move(lanes[K-1]), op);
+      return detail::tree_combine(lanes, op);
+    }
+
+    template <typename T, typename RandomIt, typename BinaryOperation>
+    ACC_CONSTEXPR17 T reduce_chunk(
+        RandomIt first, RandomIt last, BinaryOperation op,
+        std::false_type)
+    {
+      if (last - first < static_cast<std::ptrdiff_t>(2*unseq_lanes)) {
+        return reduce_chunk<T>(first, last, op, execution::seq);
+      }
+      return reduce_lanes<T>(first, last, op,
+                             std::make_index_sequence<unseq_lanes>{});
+    }
+
+    // a contiguous range with an operation that a SIMD kernel knows
+    template <typename T, typename RandomIt, typename BinaryOperation>
+    ACC_CONSTEXPR17 T reduce_chunk(
+        RandomIt first, RandomIt last, BinaryOperation op,
+        std::true_type)
+    {
+      if (ACC_IS_CONSTANT_EVALUATED()) {
+        return reduce_chunk<T>(first, last, op, std::false_type{});
+      }
+      auto p = simd::to_pointer(first);
+      return simd::fold(p + 1, static_cast<std::size_t>(last - first) - 1,
+                        *p, op);
+    }
+
+    template <typename RandomIt, typename T, typename BinaryOperation>
+    using simd_reduce = std::integral_constant<
+      bool,
+      simd::is_contiguous<RandomIt>::value
+      && std::is_same<typename std::iterator_traits<RandomIt>::value_type, T>::value
+      && simd::can_fold<T, BinaryOperation>::value>;
+
+    template <typename T, typename RandomIt, typename BinaryOperation>
+    ACC_CONSTEXPR17 T reduce_chunk(
+        RandomIt first, RandomIt last, BinaryOperation op,
+        execution::unsequenced_policy)
+    {
+      return reduce_chunk<T>(first, last, op,
+                             simd_reduce<RandomIt, T, BinaryOperation>{});
+    }
+
+    // -------------------------------------------------------------------------
+    // unsequenced reduce over a random access range
+
+    template <typename RandomIt, typename T, typename BinaryOperation>
+    ACC_CONSTEXPR17 T reduce_unseq(
+        RandomIt first, RandomIt last, T init, BinaryOperation op,
+        std::random_access_iterator_tag)
+    {
+      if (first == last) return init;
+      return op(std::move(init),
+                reduce_chunk<T>(first, last, op, execution::unseq));
+    }
+
+    template <typename InputIt, typename T, typename BinaryOperation>
+    ACC_CONSTEXPR17 T reduce_unseq(
+        InputIt first, InputIt last, T init, BinaryOperation op,
+        std::input_iterator_tag)
+    {
+      return acc::accumulate(first, last, init, op);
+    }
+
+    // -------------------------------------------------------------------------
+    // chunked parallel reduce over a random access range; ChunkPolicy says
+    // how each chunk is folded
+
+    template <typename ChunkPolicy,
+              typename RandomIt, typename T, typename BinaryOperation>
+    inline T reduce_par(
+        const execution::parallel_policy& policy,
+        RandomIt first, RandomIt last, T init, BinaryOperation op,
+        std::random_access_iterator_tag)
+    {
+      using ST = std::size_t;
+      auto n = static_cast<ST>(last - first);
+      auto grain = policy.grain == 0 ? ST{1} : policy.grain;
+      auto chunks = std::min(policy.threads(), (n + grain - 1) / grain);
+      if (n == 0) return init;
+      if (chunks <= 1) {
+        return op(std::move(init),
+                  detail::reduce_chunk<T>(first, last, op, ChunkPolicy{}));
+      }
+
+      // the calling thread folds the first chunk itself
+      std::vector<std::unique_ptr<T>> results(chunks);
+      auto chunk_begin = [&] (ST c) {
+        return first + static_cast<std::ptrdiff_t>(n * c / chunks);
+      };
+      task_group g;
+      for (ST c = 1; c < chunks; ++c) {
+        g.spawn([&results, c, op, b = chunk_begin(c), e = chunk_begin(c+1)] {
+            results[c] = std::make_unique<T>(
+                detail::reduce_chunk<T>(b, e, op, ChunkPolicy{}));
+          });
+      }
+      T r0 = detail::reduce_chunk<T>(first, chunk_begin(1), op, ChunkPolicy{});
+      g.sync();
+
+      std::vector<T> partials;
+      partials.reserve(chunks);
+      partials.push_back(std::move(r0));
+      for (ST c = 1; c < chunks; ++c) partials.push_back(std::move(*results[c]));
+      return op(std::move(init), detail::tree_combine(partials, op));
+    }
+
+    template <typename ChunkPolicy,
+              typename InputIt, typename T, typename BinaryOperation>
+    inline T reduce_par(
+        const execution::parallel_policy&,
+        InputIt first, InputIt last, T init, BinaryOperation op,
+        std::input_iterator_tag)
+    {
+      return acc::accumulate(first, last, init, op);
+    }
+
+    // -------------------------------------------------------------------------
+    // sequenced transform_reduce, which short-circuits when op has an
+    // absorbing element
+
+    template <typename InputIt, typename T,
+              typename BinaryOperation, typename UnaryOperation>
+    ACC_CONSTEXPR17 T transform_reduce_seq(
+        InputIt first, InputIt last, T init,
+        BinaryOperation op, UnaryOperation f, std::false_type)
+    {
+      using U = typename std::iterator_traits<InputIt>::value_type;
+      return acc::accumulate(
+          first, last, init,
+          [&] (T a, const U& x) { return op(std::move(a), f(x)); });
+    }
+
+    template <typename InputIt, typename T,
+              typename BinaryOperation, typename UnaryOperation>
+    ACC_CONSTEXPR17 T transform_reduce_seq(
+        InputIt first, InputIt last, T init,
+        BinaryOperation op, UnaryOperation f, std::true_type)
+    {
+      using U = typename std::iterator_traits<InputIt>::value_type;
+      const T z = monoid<BinaryOperation, T>::absorbing();
+      if (init == z) return init;
+      return acc::accumulate_until(
+          first, last, init,
+          [&] (T a, const U& x) {
+            T r = op(std::move(a), f(x));
+            return r == z ? acc::done(std::move(r)) : acc::cont(std::move(r));
+          });
+    }
+
+    template <typename InputIt, typename T, typename BinaryOperation>
+    ACC_CONSTEXPR17 T reduce_seq(
+        InputIt first, InputIt last, T init, BinaryOperation op,
+        std::false_type)
+    {
+      return acc::accumulate(first, last, init, op);
+    }
+
+    template <typename InputIt, typename T, typename BinaryOperation>
+    ACC_CONSTEXPR17 T reduce_seq(
+        InputIt first, InputIt last, T init, BinaryOperation op,
+        std::true_type)
+    {
+      using U = typename std::iterator_traits<InputIt>::value_type;
+      return transform_reduce_seq(
+          first, last, init, op, [] (const U& x) -> const U& { return x; },
+          std::true_type{});
+    }
+
+    // -------------------------------------------------------------------------
+    // reduce without a policy: a SIMD kernel if there is one, else stop early
+    // at an absorbing element, else reorder with several accumulators if op
+    // is associative, else fold in order
+
+    template <typename InputIt, typename T, typename BinaryOperation>
+    using reduce_strategy = std::conditional_t<
+      simd_reduce<InputIt, T, BinaryOperation>::value
+      || (is_associative<BinaryOperation, T>::value
+          && !has_absorbing<BinaryOperation, T>::value),
+      execution::unsequenced_policy,
+      execution::sequenced_policy>;
+  }
+
+  // ---------------------------------------------------------------------------
+  // reduce (sequenced): stops at op's absorbing element, if it has one and
+  // there is no SIMD kernel for it
+
+  template <typename InputIt, typename T, typename BinaryOperation>
+  ACC_CONSTEXPR17 T reduce(
+      const execution::sequenced_policy&,
+      InputIt first, InputIt last, T init, BinaryOperation op)
+  {
+    return detail::reduce_seq(
+        first, last, init, op,
+        std::integral_constant<
+          bool, has_absorbing<BinaryOperation, T>::value
+                && !detail::simd_reduce<InputIt, T, BinaryOperation>::value>{});
+  }
+
+  // ---------------------------------------------------------------------------
+  // reduce (unsequenced): a random access range is folded with several
+  // independent accumulators, to break the dependency on a single one; a
+  // contiguous range of int, unsigned, float or double with a known
+  // operation is folded by a SIMD kernel
+
+  template <typename InputIt, typename T, typename BinaryOperation>
+  ACC_CONSTEXPR17 T reduce(
+      const execution::unsequenced_policy&,
+      InputIt first, InputIt last, T init, BinaryOperation op)
+  {
+    return detail::reduce_unseq(
+        first, last, init, op,
+        typename std::iterator_traits<InputIt>::iterator_category{});
+  }
+
+  // ---------------------------------------------------------------------------
+  // reduce (parallel): chunks are folded concurrently, as tasks on the shared
+  // thread_pool; ranges that are not random access, or are smaller than the
+  // policy's grain, fold sequentially
+
+  template <typename InputIt, typename T, typename BinaryOperation>
+  inline T reduce(
+      const execution::parallel_policy& policy,
+      InputIt first, InputIt last, T init, BinaryOperation op)
+  {
+    return detail::reduce_par<execution::sequenced_policy>(
+        policy, first, last, init, op,
+        typename std::iterator_traits<InputIt>::iterator_category{});
+  }
+
+  // ---------------------------------------------------------------------------
+  // reduce (parallel unsequenced): as parallel, with each chunk folded as
+  // unsequenced
+
+  template <typename InputIt, typename T, typename BinaryOperation>
+  inline T reduce(
+      const execution::parallel_unsequenced_policy& policy,
+      InputIt first, InputIt last, T init, BinaryOperation op)
+  {
+    return detail::reduce_par<execution::unsequenced_policy>(
+        policy, first, last, init, op,
+        typename std::iterator_traits<InputIt>::iterator_category{});
+  }
+
+  // ---------------------------------------------------------------------------
+  // reduce (no policy)
+
+  template <typename InputIt, typename T, typename BinaryOperation>
+  ACC_CONSTEXPR17 T reduce(
+      InputIt first, InputIt last, T init, BinaryOperation op)
+  {
+    using S = detail::reduce_strategy<InputIt, T, BinaryOperation>;
+    return acc::reduce(S{}, first, last, init, op);
+  }
+
+  // ---------------------------------------------------------------------------
+  // transform_reduce (sequenced and no policy): op folds f of each element in
+  // order, stopping at op's absorbing element, if it has one
+
+  template <typename InputIt, typename T,
+            typename BinaryOperation, typename UnaryOperation>
+  ACC_CONSTEXPR17 T transform_reduce(
+      const execution::sequenced_policy&,
+      InputIt first, InputIt last, T init,
+      BinaryOperation op, UnaryOperation f)
+  {
+    return detail::transform_reduce_seq(
+        first, last, init, op, f, has_absorbing<BinaryOperation, T>{});
+  }
+
+  template <typename InputIt, typename T,
+            typename BinaryOperation, typename UnaryOperation>
+  ACC_CONSTEXPR17 T transform_reduce(
+      InputIt first, InputIt last, T init,
+      BinaryOperation op, UnaryOperation f)
+  {
+    return acc::transform_reduce(execution::seq, first, last, init, op, f);
+  }
+
+}
@@ -0,0 +1,216 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// ---------------------------------------------------------------------------
+// serialization of accumulator state
+//
+// acc::serializer<T> turns a T into bytes and back, so that partial results
+// can travel between processes. A specialization provides
+//
+//   static void save(std::vector<char>& out, const T& t);  // appends
+//   static T load(const char*& p, const char* end);        // consumes
+//
+// load throws std::runtime_error if the input runs out.
+//
+// Built in: trivially copyable types (as their bytes, so only between
+// processes of the same build), and std::basic_string, std::vector,
+// std::pair, std::map and std::unordered_map of serializable types.
+//
+
+namespace acc
+{
+  template <typename T, typename = void>
+  struct serializer;
+
+  template <typename T>
+  inline void save(std::vector<char>& out, const T& t)
+  {
+    serializer<T>::save(out, t);
+  }
+
+  template <typename T>
+  inline T load(const char*& p, const char* end)
+  {
+    return serializer<T>::load(p, end);
+  }
+
+  namespace detail
+  {
+    inline void save_bytes(std::vector<char>& out, const void* b, std::size_t n)
+    {
+      auto c = static_cast<const char*>(b);
+      out.insert(out.end(), c, c + n);
+    }
+
+    inline void load_bytes(const char*& p, const char* end, void* b, std::size_t n)
+    {
+      if (static_cast<std::size_t>(end - p) < n) {
+        throw std::runtime_error("acc::load: truncated input");
+      }
+      std::memcpy(b, p, n);
+      p += n;
+    }
+
+    // an unsigned integer in base 128, low digits first: small values, such
+    // as the gaps in a sorted list, take a byte or two
+    inline void save_varint(std::vector<char>& out, std::uint64_t x)
+    {
+      for (; x >= 0x80; x >>= 7) {
+        out.push_back(static_cast<char>((x & 0x7f) | 0x80));
+      }
+      out.push_back(static_cast<char>(x));
+    }
+
+    inline std::uint64_t load_varint(const char*& p, const char* end)
+    {
+      std::uint64_t x = 0;
+      for (unsigned shift = 0; shift < 64; shift += 7) {
+        if (p == end) throw std::runtime_error("acc::load: truncated input");
+        auto b = static_cast<unsigned char>(*p++);
+        x |= std::uint64_t{b & 0x7fu} << shift;
+        if (!(b & 0x80)) return x;
+      }
+      throw std::runtime_error("acc::load: bad varint");
+    }
+
+    // a container as its size, then its elements
+    template <typename C>
+    inline void save_elements(std::vector<char>& out, const C& c)
+    {
+      acc::save(out, static_cast<std::size_t>(c.size()));
+      for (const auto& x : c) acc::save(out, x);
+    }
+  }
+
+  // ---------------------------------------------------------------------------
+  // trivially copyable types
+
+  template <typename T>
+  struct serializer<T, std::enable_if_t<std::is_trivially_copyable<T>::value>>
+  {
+    static void save(std::vector<char>& out, const T& t)
+    {
+      detail::save_bytes(out, &t, sizeof(T));
+    }
+
+    static T load(const char*& p, const char* end)
+    {
+      T t;
+      detail::load_bytes(p, end, &t, sizeof(T));
+      return t;
+    }
+  };
+
+  // ---------------------------------------------------------------------------
+  // strings
+
+  template <typename C, typename Tr, typename A>
+  struct serializer<std::basic_string<C, Tr, A>>
+  {
+    using S = std::basic_string<C, Tr, A>;
+
+    static void save(std::vector<char>& out, const S& s)
+    {
+      acc::save(out, static_cast<std::size_t>(s.size()));
+      detail::save_bytes(out, s.data(), s.size() * sizeof(C));
+    }
+
+    static S load(const char*& p, const char* end)
+    {
+      auto n = acc::load<std::size_t>(p, end);
+      if (static_cast<std::size_t>(end - p) / sizeof(C) < n) {
+        throw std::runtime_error("acc::load: truncated input");
+      }
+      S s(n, C{});
+      detail::load_bytes(p, end, &s[0], n * sizeof(C));
+      return s;
+    }
+  };
+
+  // ---------------------------------------------------------------------------
+  // pairs, vectors and maps, element by element
+
+  template <typename T1, typename T2>
+  struct serializer<std::pair<T1, T2>,
+                    std::enable_if_t<!std::is_trivially_copyable<
+                                       std::pair<T1, T2>>::value>>
+  {
+    static void save(std::vector<char>& out, const std::pair<T1, T2>& t)
+    {
+      acc::save(out, t.first);
+      acc::save(out, t.second);
+    }
+
+    static std::pair<T1, T2> load(const char*& p, const char* end)
+    {
+      auto a = acc::load<std::remove_const_t<T1>>(p, end);
+      auto b = acc::load<T2>(p, end);
+      return { std::move(a), std::move(b) };
+    }
+  };
+
+  template <typename T, typename A>
+  struct serializer<std::vector<T, A>>
+  {
+    static void save(std::vector<char>& out, const std::vector<T, A>& v)
+    {
+      detail::save_elements(out, v);
+    }
+
+    static std::vector<T, A> load(const char*& p, const char* end)
+    {
+      auto n = acc::load<std::size_t>(p, end);
+      std::vector<T, A> v;
+      for (std::size_t i = 0; i < n; ++i) v.push_back(acc::load<T>(p, end));
+      return v;
+    }
+  };
+
+  namespace detail
+  {
+    template <typename Map>
+    struct map_serializer
+    {
+      using K = typename Map::key_type;
+      using V = typename Map::mapped_type;
+
+      static void save(std::vector<char>& out, const Map& m)
+      {
+        detail::save_elements(out, m);
+      }
+
+      static Map load(const char*& p, const char* end)
+      {
+        auto n = acc::load<std::size_t>(p, end);
+        Map m;
+        for (std::size_t i = 0; i < n; ++i) {
+          auto k = acc::load<K>(p, end);
+          auto v = acc::load<V>(p, end);
+          m.emplace(std::move(k), std::move(v));
+        }
+        return m;
+      }
+    };
+  }
+
+  template <typename K, typename V, typename C, typename A>
+  struct serializer<std::map<K, V, C, A>>
+    : detail::map_serializer<std::map<K, V, C, A>>
+  {};
+
+  template <typename K, typename V, typename H, typename E, typename A>
+  struct serializer<std::unordered_map<K, V, H, E, A>>
+    : detail::map_serializer<std::unordered_map<K, V, H, E, A>>
+  {};
+
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "accumulate.h"
+#include "config.h"
 
 #include "modifying_seq_ops.h"
 #include "non_modifying_seq_ops.h"
@@ -30,22 +31,21 @@ namespace acc
 
   template <typename InputIt1, typename InputIt2,
             typename OutputIt, typename Compare>
-  inline OutputIt merge(
+  ACC_CONSTEXPR17 OutputIt merge(
       InputIt1 first1, InputIt1 last1,
       InputIt2 first2, InputIt2 last2,
       OutputIt d_first, Compare comp)
   {
     using P = std::pair<OutputIt, InputIt2>;
     using T = typename std::iterator_traits<InputIt2>::value_type;
-    P p = acc::accumulate_iter(
+    P p = acc::accumulate_iter_inplace(
         first1, last1, P{ d_first, first2 },
-        [&] (P a, const InputIt1& b) {
+        [&] (P& a, const InputIt1& b) {
           a = acc::copy_while(
               a.second, last2, a.first,
               [&] (const T& t) { return comp(t, *b); });
           *a.first = *b;
           ++a.first;
-          return a;
         });
     return acc::copy(p.second, last2, p.first);
   }
@@ -53,7 +53,7 @@ namespace acc
   // ---------------------------------------------------------------------------
   // inplace_merge
   template <typename BidirIt, typename Compare>
-  inline void inplace_merge(
+  ACC_CONSTEXPR17 void inplace_merge(
       BidirIt first, BidirIt middle, BidirIt last, Compare comp)
   {
     using T = typename std::iterator_traits<BidirIt>::value_type;
@@ -83,29 +83,23 @@ namespace acc
   // includes
 
   template <typename InputIt1, typename InputIt2, typename Compare>
-  inline bool includes(
+  ACC_CONSTEXPR17 bool includes(
       InputIt1 first1, InputIt1 last1,
       InputIt2 first2, InputIt2 last2,
       Compare cmp)
   {
     using T = typename std::iterator_traits<InputIt1>::value_type;
     if (first2 == last2) return true;
-    try
-    {
-      acc::accumulate(
-          first1, last1, first2,
-          [&] (InputIt2 i, const T& t) {
-            if (cmp(*i, t)) throw false;
-            if (!cmp(t, *i)) ++i;
-            if (i == last2) throw true;
-            return i;
-          });
-      return false;
-    }
-    catch (bool b)
-    {
-      return b;
-    }
+    // the fold stops early on reaching the end of the second range (all of
+    // it is included), or on an element of it that the first range lacks
+    return acc::accumulate_until(
+        first1, last1, first2,
+        [&] (InputIt2 i, const T& t) {
+          if (cmp(*i, t)) return acc::done(i);
+          if (!cmp(t, *i)) ++i;
+          if (i == last2) return acc::done(i);
+          return acc::cont(i);
+        }) == last2;
   }
 
   // ---------------------------------------------------------------------------
@@ -113,7 +107,7 @@ namespace acc
 
   template <typename InputIt1, typename InputIt2,
             typename OutputIt, typename Compare>
-  inline OutputIt set_difference(
+  ACC_CONSTEXPR17 OutputIt set_difference(
       InputIt1 first1, InputIt1 last1,
       InputIt2 first2, InputIt2 last2,
       OutputIt d_first, Compare cmp)
@@ -142,7 +136,7 @@ namespace acc
 
   template <typename InputIt1, typename InputIt2,
             typename OutputIt, typename Compare>
-  inline OutputIt set_intersection(
+  ACC_CONSTEXPR17 OutputIt set_intersection(
       InputIt1 first1, InputIt1 last1,
       InputIt2 first2, InputIt2 last2,
       OutputIt d_first, Compare comp)
@@ -168,7 +162,7 @@ namespace acc
 
   template <typename InputIt1, typename InputIt2,
             typename OutputIt, typename Compare>
-  inline OutputIt set_symmetric_difference(
+  ACC_CONSTEXPR17 OutputIt set_symmetric_difference(
       InputIt1 first1, InputIt1 last1,
       InputIt2 first2, InputIt2 last2,
       OutputIt d_first, Compare cmp)
@@ -178,9 +172,9 @@ namespace acc
     if (first1 == last1) return acc::copy(first2, last2, d_first);
 
     using P = std::pair<OutputIt, InputIt2>;
-    P p = acc::accumulate(
+    P p = acc::accumulate_inplace(
         first1, last1, P{ d_first, first2 },
-          [&] (P p, const T& t) {
+          [&] (P& p, const T& t) {
             p = acc::copy_while(
                 p.second, last2, p.first,
                 [&] (const U& u) { return cmp(u, t); });
@@ -200,7 +194,7 @@ namespace acc
 
   template <typename InputIt1, typename InputIt2,
             typename OutputIt, typename Compare>
-  inline OutputIt set_union(
+  ACC_CONSTEXPR17 OutputIt set_union(
       InputIt1 first1, InputIt1 last1,
       InputIt2 first2, InputIt2 last2,
       OutputIt d_first, Compare cmp)
@@ -210,9 +204,9 @@ namespace acc
     if (first1 == last1) return acc::copy(first2, last2, d_first);
 
     using P = std::pair<OutputIt, InputIt2>;
-    P p = acc::accumulate(
+    P p = acc::accumulate_inplace(
         first1, last1, P{ d_first, first2 },
-          [&] (P p, const T& t) {
+          [&] (P& p, const T& t) {
             p = acc::copy_while(
                 p.second, last2, p.first,
                 [&] (const U& u) { return cmp(u, t); });
@@ -222,7 +216,6 @@ namespace acc
             else if (p.second != last2) {
               *p.first++ = *p.second++;
             }
-            return p;
           });
     return acc::copy(p.second, last2, p.first);
   }
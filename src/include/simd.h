@@ -0,0 +1,692 @@
+#pragma once
+
+#include "functional.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if (defined(__x86_64__) || defined(__i386__)) \
+  && (defined(__GNUC__) || defined(__clang__))
+#define ACC_SIMD_X86
+#include <immintrin.h>
+#endif
+
+// ---------------------------------------------------------------------------
+// SIMD kernels for folds over contiguous ranges of int, unsigned, float and
+// double with a known operation (plus, multiplies, minimum, maximum, bit_and,
+// bit_or, bit_xor), and for the plus/multiplies inner product.
+//
+// The kernels reassociate, so they are exact for integers but not for
+// floating point. The instruction set (SSE2, AVX2 or AVX-512) is picked at
+// runtime; where a kernel is missing (other platforms or compilers, or an
+// operation the instruction set lacks) the scalar fallback is used.
+//
+// fold
+// dot
+//
+
+namespace acc
+{
+  namespace simd
+  {
+    template <typename...>
+    struct make_void { using type = void; };
+
+    template <typename... Ts>
+    using void_t = typename make_void<Ts...>::type;
+
+    // -------------------------------------------------------------------------
+    // instruction sets, in increasing order of preference
+
+    enum class isa : int { scalar, sse2, avx2, avx512 };
+
+    constexpr int isa_count = 4;
+
+    inline isa detect_isa()
+    {
+#ifdef ACC_SIMD_X86
+      __builtin_cpu_init();
+      if (__builtin_cpu_supports("avx512f")) return isa::avx512;
+      if (__builtin_cpu_supports("avx2")) return isa::avx2;
+      if (__builtin_cpu_supports("sse2")) return isa::sse2;
+#endif
+      return isa::scalar;
+    }
+
+    inline isa best_isa()
+    {
+      static const isa i = detect_isa();
+      return i;
+    }
+
+    // -------------------------------------------------------------------------
+    // the operations that kernels exist for, and their scalar meanings
+
+    struct op_plus { static constexpr int index = 0; };
+    struct op_multiplies { static constexpr int index = 1; };
+    struct op_min { static constexpr int index = 2; };
+    struct op_max { static constexpr int index = 3; };
+    struct op_bit_and { static constexpr int index = 4; };
+    struct op_bit_or { static constexpr int index = 5; };
+    struct op_bit_xor { static constexpr int index = 6; };
+
+    constexpr int op_count = 7;
+
+    // integer plus and multiplies wrap, as the vector instructions do
+    template <typename T, bool = std::is_integral<T>::value>
+    struct arith { using type = T; };
+
+    template <typename T>
+    struct arith<T, true> { using type = std::make_unsigned_t<T>; };
+
+    template <typename T>
+    using arith_t = typename arith<T>::type;
+
+    template <typename T>
+    inline T apply(op_plus, T a, T b)
+    {
+      return static_cast<T>(static_cast<arith_t<T>>(a) + static_cast<arith_t<T>>(b));
+    }
+
+    template <typename T>
+    inline T apply(op_multiplies, T a, T b)
+    {
+      return static_cast<T>(static_cast<arith_t<T>>(a) * static_cast<arith_t<T>>(b));
+    }
+
+    template <typename T>
+    inline T apply(op_min, T a, T b) { return b < a ? b : a; }
+
+    template <typename T>
+    inline T apply(op_max, T a, T b) { return a < b ? b : a; }
+
+    template <typename T>
+    inline T apply(op_bit_and, T a, T b) { return a & b; }
+
+    template <typename T>
+    inline T apply(op_bit_or, T a, T b) { return a | b; }
+
+    template <typename T>
+    inline T apply(op_bit_xor, T a, T b) { return a ^ b; }
+
+    template <typename T>
+    constexpr T identity(op_plus) { return T{0}; }
+
+    template <typename T>
+    constexpr T identity(op_multiplies) { return T{1}; }
+
+    template <typename T>
+    constexpr T identity(op_min)
+    {
+      return std::numeric_limits<T>::has_infinity
+        ? std::numeric_limits<T>::infinity() : std::numeric_limits<T>::max();
+    }
+
+    template <typename T>
+    constexpr T identity(op_max)
+    {
+      return std::numeric_limits<T>::has_infinity
+        ? -std::numeric_limits<T>::infinity() : std::numeric_limits<T>::lowest();
+    }
+
+    template <typename T>
+    constexpr T identity(op_bit_and) { return static_cast<T>(~T{0}); }
+
+    template <typename T>
+    constexpr T identity(op_bit_or) { return T{0}; }
+
+    template <typename T>
+    constexpr T identity(op_bit_xor) { return T{0}; }
+
+    // -------------------------------------------------------------------------
+    // element types with kernels, and the operation tag of a function object
+    // applied to T (void if the kernels don't know it)
+
+    template <typename T>
+    struct is_kernel_type : std::integral_constant<
+      bool,
+      std::is_same<T, int>::value || std::is_same<T, unsigned int>::value
+      || std::is_same<T, float>::value || std::is_same<T, double>::value>
+    {};
+
+    template <typename Op, typename T>
+    struct op_tag
+    {
+      static constexpr bool integral = std::is_integral<T>::value;
+      using type =
+        std::conditional_t<is_op<std::plus, Op, T>::value, op_plus,
+        std::conditional_t<is_op<std::multiplies, Op, T>::value, op_multiplies,
+        std::conditional_t<is_op<acc::minimum, Op, T>::value, op_min,
+        std::conditional_t<is_op<acc::maximum, Op, T>::value, op_max,
+        std::conditional_t<integral && is_op<std::bit_and, Op, T>::value, op_bit_and,
+        std::conditional_t<integral && is_op<std::bit_or, Op, T>::value, op_bit_or,
+        std::conditional_t<integral && is_op<std::bit_xor, Op, T>::value, op_bit_xor,
+                           void>>>>>>>;
+    };
+
+    template <typename Op, typename T>
+    using op_tag_t = typename op_tag<Op, T>::type;
+
+    // -------------------------------------------------------------------------
+    // can_fold: a kernel can fold T with Op (reassociating)
+    // exact_fold: ... and reassociation doesn't change the result
+
+    template <typename T, typename Op>
+    struct can_fold : std::integral_constant<
+      bool, is_kernel_type<T>::value && !std::is_void<op_tag_t<Op, T>>::value>
+    {};
+
+    template <typename T, typename Op>
+    struct exact_fold : std::integral_constant<
+      bool, can_fold<T, Op>::value && std::is_integral<T>::value>
+    {};
+
+    // -------------------------------------------------------------------------
+    // contiguous iterators: pointers, and vector iterators over kernel types
+
+    template <typename It, typename V, bool = is_kernel_type<V>::value>
+    struct is_vector_iterator : std::false_type {};
+
+    template <typename It, typename V>
+    struct is_vector_iterator<It, V, true> : std::integral_constant<
+      bool,
+      std::is_same<It, typename std::vector<V>::iterator>::value
+      || std::is_same<It, typename std::vector<V>::const_iterator>::value>
+    {};
+
+    template <typename It, typename = void>
+    struct is_contiguous : std::false_type {};
+
+    template <typename T>
+    struct is_contiguous<T*> : std::true_type {};
+
+    template <typename It>
+    struct is_contiguous<
+      It, std::enable_if_t<is_vector_iterator<
+            It, typename std::iterator_traits<It>::value_type>::value>>
+      : std::true_type
+    {};
+
+    // only for dereferenceable iterators
+    template <typename It>
+    inline auto to_pointer(It it)
+    {
+      return std::addressof(*it);
+    }
+
+    // -------------------------------------------------------------------------
+    // kernel table: one fold per operation (null where there's no kernel) and
+    // a dot product
+
+    template <typename T>
+    struct kernel_table
+    {
+      using fold_fn = T (*)(const T*, std::size_t);
+      using dot_fn = T (*)(const T*, const T*, std::size_t);
+
+      fold_fn fold[op_count];
+      dot_fn dot;
+    };
+
+#ifdef ACC_SIMD_X86
+
+#define ACC_SIMD_SSE2 __attribute__((target("sse2"), always_inline)) inline
+#define ACC_SIMD_AVX2 __attribute__((target("avx2"), always_inline)) inline
+#define ACC_SIMD_AVX512 __attribute__((target("avx512f"), always_inline)) inline
+
+    // -------------------------------------------------------------------------
+    // packs: one register's worth of T for an instruction set. A pack only
+    // has apply() for the operations the instruction set supports.
+
+    template <typename T>
+    struct sse2_epi32
+    {
+      using value_type = T;
+      using reg = __m128i;
+      static constexpr std::size_t width = 4;
+
+      static ACC_SIMD_SSE2 reg load(const T* p)
+      { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+      static ACC_SIMD_SSE2 void store(T* p, reg a)
+      { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), a); }
+      static ACC_SIMD_SSE2 reg set1(T x)
+      { return _mm_set1_epi32(static_cast<int>(x)); }
+
+      static ACC_SIMD_SSE2 reg apply(op_plus, reg a, reg b)
+      { return _mm_add_epi32(a, b); }
+      static ACC_SIMD_SSE2 reg apply(op_bit_and, reg a, reg b)
+      { return _mm_and_si128(a, b); }
+      static ACC_SIMD_SSE2 reg apply(op_bit_or, reg a, reg b)
+      { return _mm_or_si128(a, b); }
+      static ACC_SIMD_SSE2 reg apply(op_bit_xor, reg a, reg b)
+      { return _mm_xor_si128(a, b); }
+    };
+
+    struct sse2_ps
+    {
+      using value_type = float;
+      using reg = __m128;
+      static constexpr std::size_t width = 4;
+
+      static ACC_SIMD_SSE2 reg load(const float* p) { return _mm_loadu_ps(p); }
+      static ACC_SIMD_SSE2 void store(float* p, reg a) { _mm_storeu_ps(p, a); }
+      static ACC_SIMD_SSE2 reg set1(float x) { return _mm_set1_ps(x); }
+
+      static ACC_SIMD_SSE2 reg apply(op_plus, reg a, reg b)
+      { return _mm_add_ps(a, b); }
+      static ACC_SIMD_SSE2 reg apply(op_multiplies, reg a, reg b)
+      { return _mm_mul_ps(a, b); }
+      static ACC_SIMD_SSE2 reg apply(op_min, reg a, reg b)
+      { return _mm_min_ps(a, b); }
+      static ACC_SIMD_SSE2 reg apply(op_max, reg a, reg b)
+      { return _mm_max_ps(a, b); }
+    };
+
+    struct sse2_pd
+    {
+      using value_type = double;
+      using reg = __m128d;
+      static constexpr std::size_t width = 2;
+
+      static ACC_SIMD_SSE2 reg load(const double* p) { return _mm_loadu_pd(p); }
+      static ACC_SIMD_SSE2 void store(double* p, reg a) { _mm_storeu_pd(p, a); }
+      static ACC_SIMD_SSE2 reg set1(double x) { return _mm_set1_pd(x); }
+
+      static ACC_SIMD_SSE2 reg apply(op_plus, reg a, reg b)
+      { return _mm_add_pd(a, b); }
+      static ACC_SIMD_SSE2 reg apply(op_multiplies, reg a, reg b)
+      { return _mm_mul_pd(a, b); }
+      static ACC_SIMD_SSE2 reg apply(op_min, reg a, reg b)
+      { return _mm_min_pd(a, b); }
+      static ACC_SIMD_SSE2 reg apply(op_max, reg a, reg b)
+      { return _mm_max_pd(a, b); }
+    };
+
+    template <typename T>
+    struct avx2_epi32
+    {
+      using value_type = T;
+      using reg = __m256i;
+      static constexpr std::size_t width = 8;
+      static constexpr bool is_signed = std::is_signed<T>::value;
+
+      static ACC_SIMD_AVX2 reg load(const T* p)
+      { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+      static ACC_SIMD_AVX2 void store(T* p, reg a)
+      { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), a); }
+      static ACC_SIMD_AVX2 reg set1(T x)
+      { return _mm256_set1_epi32(static_cast<int>(x)); }
+
+      static ACC_SIMD_AVX2 reg apply(op_plus, reg a, reg b)
+      { return _mm256_add_epi32(a, b); }
+      static ACC_SIMD_AVX2 reg apply(op_multiplies, reg a, reg b)
+      { return _mm256_mullo_epi32(a, b); }
+      static ACC_SIMD_AVX2 reg apply(op_min, reg a, reg b)
+      { return is_signed ? _mm256_min_epi32(a, b) : _mm256_min_epu32(a, b); }
+      static ACC_SIMD_AVX2 reg apply(op_max, reg a, reg b)
+      { return is_signed ? _mm256_max_epi32(a, b) : _mm256_max_epu32(a, b); }
+      static ACC_SIMD_AVX2 reg apply(op_bit_and, reg a, reg b)
+      { return _mm256_and_si256(a, b); }
+      static ACC_SIMD_AVX2 reg apply(op_bit_or, reg a, reg b)
+      { return _mm256_or_si256(a, b); }
+      static ACC_SIMD_AVX2 reg apply(op_bit_xor, reg a, reg b)
+      { return _mm256_xor_si256(a, b); }
+    };
+
+    struct avx2_ps
+    {
+      using value_type = float;
+      using reg = __m256;
+      static constexpr std::size_t width = 8;
+
+      static ACC_SIMD_AVX2 reg load(const float* p)
+      { return _mm256_loadu_ps(p); }
+      static ACC_SIMD_AVX2 void store(float* p, reg a)
+      { _mm256_storeu_ps(p, a); }
+      static ACC_SIMD_AVX2 reg set1(float x) { return _mm256_set1_ps(x); }
+
+      static ACC_SIMD_AVX2 reg apply(op_plus, reg a, reg b)
+      { return _mm256_add_ps(a, b); }
+      static ACC_SIMD_AVX2 reg apply(op_multiplies, reg a, reg b)
+      { return _mm256_mul_ps(a, b); }
+      static ACC_SIMD_AVX2 reg apply(op_min, reg a, reg b)
+      { return _mm256_min_ps(a, b); }
+      static ACC_SIMD_AVX2 reg apply(op_max, reg a, reg b)
+      { return _mm256_max_ps(a, b); }
+    };
+
+    struct avx2_pd
+    {
+      using value_type = double;
+      using reg = __m256d;
+      static constexpr std::size_t width = 4;
+
+      static ACC_SIMD_AVX2 reg load(const double* p)
+      { return _mm256_loadu_pd(p); }
+      static ACC_SIMD_AVX2 void store(double* p, reg a)
+      { _mm256_storeu_pd(p, a); }
+      static ACC_SIMD_AVX2 reg set1(double x) { return _mm256_set1_pd(x); }
+
+      static ACC_SIMD_AVX2 reg apply(op_plus, reg a, reg b)
+      { return _mm256_add_pd(a, b); }
+      static ACC_SIMD_AVX2 reg apply(op_multiplies, reg a, reg b)
+      { return _mm256_mul_pd(a, b); }
+      static ACC_SIMD_AVX2 reg apply(op_min, reg a, reg b)
+      { return _mm256_min_pd(a, b); }
+      static ACC_SIMD_AVX2 reg apply(op_max, reg a, reg b)
+      { return _mm256_max_pd(a, b); }
+    };
+
+    template <typename T>
+    struct avx512_epi32
+    {
+      using value_type = T;
+      using reg = __m512i;
+      static constexpr std::size_t width = 16;
+      static constexpr bool is_signed = std::is_signed<T>::value;
+      // the unmasked min/max intrinsics trip -Wuninitialized in some GCCs
+      static constexpr __mmask16 all = 0xFFFF;
+
+      static ACC_SIMD_AVX512 reg load(const T* p)
+      { return _mm512_loadu_si512(p); }
+      static ACC_SIMD_AVX512 void store(T* p, reg a)
+      { _mm512_storeu_si512(p, a); }
+      static ACC_SIMD_AVX512 reg set1(T x)
+      { return _mm512_set1_epi32(static_cast<int>(x)); }
+
+      static ACC_SIMD_AVX512 reg apply(op_plus, reg a, reg b)
+      { return _mm512_add_epi32(a, b); }
+      static ACC_SIMD_AVX512 reg apply(op_multiplies, reg a, reg b)
+      { return _mm512_mullo_epi32(a, b); }
+      static ACC_SIMD_AVX512 reg apply(op_min, reg a, reg b)
+      {
+        return is_signed ? _mm512_mask_min_epi32(a, all, a, b)
+                         : _mm512_mask_min_epu32(a, all, a, b);
+      }
+      static ACC_SIMD_AVX512 reg apply(op_max, reg a, reg b)
+      {
+        return is_signed ? _mm512_mask_max_epi32(a, all, a, b)
+                         : _mm512_mask_max_epu32(a, all, a, b);
+      }
+      static ACC_SIMD_AVX512 reg apply(op_bit_and, reg a, reg b)
+      { return _mm512_and_si512(a, b); }
+      static ACC_SIMD_AVX512 reg apply(op_bit_or, reg a, reg b)
+      { return _mm512_or_si512(a, b); }
+      static ACC_SIMD_AVX512 reg apply(op_bit_xor, reg a, reg b)
+      { return _mm512_xor_si512(a, b); }
+    };
+
+    struct avx512_ps
+    {
+      using value_type = float;
+      using reg = __m512;
+      static constexpr std::size_t width = 16;
+      static constexpr __mmask16 all = 0xFFFF;
+
+      static ACC_SIMD_AVX512 reg load(const float* p)
+      { return _mm512_loadu_ps(p); }
+      static ACC_SIMD_AVX512 void store(float* p, reg a)
+      { _mm512_storeu_ps(p, a); }
+      static ACC_SIMD_AVX512 reg set1(float x) { return _mm512_set1_ps(x); }
+
+      static ACC_SIMD_AVX512 reg apply(op_plus, reg a, reg b)
+      { return _mm512_add_ps(a, b); }
+      static ACC_SIMD_AVX512 reg apply(op_multiplies, reg a, reg b)
+      { return _mm512_mul_ps(a, b); }
+      static ACC_SIMD_AVX512 reg apply(op_min, reg a, reg b)
+      { return _mm512_mask_min_ps(a, all, a, b); }
+      static ACC_SIMD_AVX512 reg apply(op_max, reg a, reg b)
+      { return _mm512_mask_max_ps(a, all, a, b); }
+    };
+
+    struct avx512_pd
+    {
+      using value_type = double;
+      using reg = __m512d;
+      static constexpr std::size_t width = 8;
+      static constexpr __mmask8 all = 0xFF;
+
+      static ACC_SIMD_AVX512 reg load(const double* p)
+      { return _mm512_loadu_pd(p); }
+      static ACC_SIMD_AVX512 void store(double* p, reg a)
+      { _mm512_storeu_pd(p, a); }
+      static ACC_SIMD_AVX512 reg set1(double x) { return _mm512_set1_pd(x); }
+
+      static ACC_SIMD_AVX512 reg apply(op_plus, reg a, reg b)
+      { return _mm512_add_pd(a, b); }
+      static ACC_SIMD_AVX512 reg apply(op_multiplies, reg a, reg b)
+      { return _mm512_mul_pd(a, b); }
+      static ACC_SIMD_AVX512 reg apply(op_min, reg a, reg b)
+      { return _mm512_mask_min_pd(a, all, a, b); }
+      static ACC_SIMD_AVX512 reg apply(op_max, reg a, reg b)
+      { return _mm512_mask_max_pd(a, all, a, b); }
+    };
+
+    // -------------------------------------------------------------------------
+    // the kernels, stamped out once per instruction set because each needs
+    // its own target attribute. Four accumulator registers hide the latency of
+    // the vector op; lanes are combined, then the tail is folded in.
+
+#define ACC_SIMD_DEFINE_KERNELS(ISA, TARGET)                                    \
+    struct ISA##_kernels                                                        \
+    {                                                                           \
+      template <typename Pack, typename Tag>                                    \
+      __attribute__((target(TARGET)))                                           \
+      static typename Pack::value_type fold(                                    \
+          const typename Pack::value_type* p, std::size_t n)                    \
+      {                                                                         \
+        using T = typename Pack::value_type;                                    \
+        constexpr std::size_t W = Pack::width;                                  \
+        auto a0 = Pack::set1(simd::identity<T>(Tag{}));                         \
+        auto a1 = a0;                                                           \
+        auto a2 = a0;                                                           \
+        auto a3 = a0;                                                           \
+        std::size_t i = 0;                                                      \
+        for (; i + 4*W <= n; i += 4*W) {                                        \
+          a0 = Pack::apply(Tag{}, a0, Pack::load(p + i));                       \
+          a1 = Pack::apply(Tag{}, a1, Pack::load(p + i + W));                   \
+          a2 = Pack::apply(Tag{}, a2, Pack::load(p + i + 2*W));                 \
+          a3 = Pack::apply(Tag{}, a3, Pack::load(p + i + 3*W));                 \
+        }                                                                       \
+        for (; i + W <= n; i += W) {                                            \
+          a0 = Pack::apply(Tag{}, a0, Pack::load(p + i));                       \
+        }                                                                       \
+        a0 = Pack::apply(Tag{}, Pack::apply(Tag{}, a0, a1),                     \
+                         Pack::apply(Tag{}, a2, a3));                           \
+        T lanes[W];                                                             \
+        Pack::store(lanes, a0);                                                 \
+        T r = simd::identity<T>(Tag{});                                         \
+        for (std::size_t j = 0; j < W; ++j) r = simd::apply(Tag{}, r, lanes[j]); \
+        for (; i < n; ++i) r = simd::apply(Tag{}, r, p[i]);                     \
+        return r;                                                               \
+      }                                                                         \
+                                                                                \
+      template <typename Pack>                                                  \
+      __attribute__((target(TARGET)))                                           \
+      static typename Pack::value_type dot(                                     \
+          const typename Pack::value_type* p,                                   \
+          const typename Pack::value_type* q, std::size_t n)                    \
+      {                                                                         \
+        using T = typename Pack::value_type;                                    \
+        constexpr std::size_t W = Pack::width;                                  \
+        auto a0 = Pack::set1(T{0});                                             \
+        auto a1 = a0;                                                           \
+        std::size_t i = 0;                                                      \
+        for (; i + 2*W <= n; i += 2*W) {                                        \
+          a0 = Pack::apply(op_plus{}, a0,                                       \
+                           Pack::apply(op_multiplies{}, Pack::load(p + i),      \
+                                       Pack::load(q + i)));                     \
+          a1 = Pack::apply(op_plus{}, a1,                                       \
+                           Pack::apply(op_multiplies{}, Pack::load(p + i + W),  \
+                                       Pack::load(q + i + W)));                 \
+        }                                                                       \
+        a0 = Pack::apply(op_plus{}, a0, a1);                                    \
+        T lanes[W];                                                             \
+        Pack::store(lanes, a0);                                                 \
+        T r = T{0};                                                             \
+        for (std::size_t j = 0; j < W; ++j) r = simd::apply(op_plus{}, r, lanes[j]); \
+        for (; i < n; ++i)                                                      \
+          r = simd::apply(op_plus{}, r, simd::apply(op_multiplies{}, p[i], q[i])); \
+        return r;                                                               \
+      }                                                                         \
+    };
+
+    ACC_SIMD_DEFINE_KERNELS(sse2, "sse2")
+    ACC_SIMD_DEFINE_KERNELS(avx2, "avx2")
+    ACC_SIMD_DEFINE_KERNELS(avx512, "avx512f")
+
+#undef ACC_SIMD_DEFINE_KERNELS
+#undef ACC_SIMD_SSE2
+#undef ACC_SIMD_AVX2
+#undef ACC_SIMD_AVX512
+
+    // -------------------------------------------------------------------------
+    // the pack for each instruction set and element type (void if none)
+
+    template <typename Kernels, typename T> struct pack { using type = void; };
+
+    template <> struct pack<sse2_kernels, int> { using type = sse2_epi32<int>; };
+    template <> struct pack<sse2_kernels, unsigned int> { using type = sse2_epi32<unsigned int>; };
+    template <> struct pack<sse2_kernels, float> { using type = sse2_ps; };
+    template <> struct pack<sse2_kernels, double> { using type = sse2_pd; };
+
+    template <> struct pack<avx2_kernels, int> { using type = avx2_epi32<int>; };
+    template <> struct pack<avx2_kernels, unsigned int> { using type = avx2_epi32<unsigned int>; };
+    template <> struct pack<avx2_kernels, float> { using type = avx2_ps; };
+    template <> struct pack<avx2_kernels, double> { using type = avx2_pd; };
+
+    template <> struct pack<avx512_kernels, int> { using type = avx512_epi32<int>; };
+    template <> struct pack<avx512_kernels, unsigned int> { using type = avx512_epi32<unsigned int>; };
+    template <> struct pack<avx512_kernels, float> { using type = avx512_ps; };
+    template <> struct pack<avx512_kernels, double> { using type = avx512_pd; };
+
+    template <typename Pack, typename Tag, typename = void>
+    struct pack_supports : std::false_type {};
+
+    template <typename Pack, typename Tag>
+    struct pack_supports<
+      Pack, Tag,
+      void_t<decltype(static_cast<void>(
+                        Pack::apply(Tag{}, Pack::set1({}), Pack::set1({}))))>>
+      : std::true_type
+    {};
+
+    // -------------------------------------------------------------------------
+    // filling in a table for an instruction set
+
+    template <typename Kernels, typename Pack, typename Tag, typename T>
+    inline void set_fold(kernel_table<T>& t, std::true_type)
+    {
+      t.fold[Tag::index] = &Kernels::template fold<Pack, Tag>;
+    }
+
+    template <typename Kernels, typename Pack, typename Tag, typename T>
+    inline void set_fold(kernel_table<T>&, std::false_type)
+    {}
+
+    template <typename Kernels, typename Pack, typename T>
+    inline void set_dot(kernel_table<T>& t, std::true_type)
+    {
+      t.dot = &Kernels::template dot<Pack>;
+    }
+
+    template <typename Kernels, typename Pack, typename T>
+    inline void set_dot(kernel_table<T>&, std::false_type)
+    {}
+
+    template <typename Kernels, typename Pack, typename T, typename... Tags>
+    inline kernel_table<T> make_table(std::true_type)
+    {
+      kernel_table<T> t{};
+      (void)std::initializer_list<int>{
+        (set_fold<Kernels, Pack, Tags>(t, pack_supports<Pack, Tags>{}), 0)... };
+      set_dot<Kernels, Pack>(t, pack_supports<Pack, op_multiplies>{});
+      return t;
+    }
+
+    template <typename Kernels, typename Pack, typename T, typename... Tags>
+    inline kernel_table<T> make_table(std::false_type)
+    {
+      return kernel_table<T>{};
+    }
+
+    template <typename Kernels, typename T>
+    inline kernel_table<T> make_table()
+    {
+      using Pack = typename pack<Kernels, T>::type;
+      return make_table<Kernels, Pack, T,
+                        op_plus, op_multiplies, op_min, op_max,
+                        op_bit_and, op_bit_or, op_bit_xor>(
+          std::integral_constant<bool, !std::is_void<Pack>::value>{});
+    }
+
+#endif
+
+    // -------------------------------------------------------------------------
+    // the table of kernels for T on a given instruction set (all null for
+    // scalar), and on the best one the host supports
+
+    template <typename T>
+    inline const kernel_table<T>& kernels(isa i)
+    {
+      static const kernel_table<T> tables[isa_count] = {
+        kernel_table<T>{},
+#ifdef ACC_SIMD_X86
+        make_table<sse2_kernels, T>(),
+        make_table<avx2_kernels, T>(),
+        make_table<avx512_kernels, T>(),
+#endif
+      };
+      auto n = static_cast<int>(i);
+      return tables[n <= static_cast<int>(best_isa()) ? n : 0];
+    }
+
+    template <typename T>
+    inline const kernel_table<T>& kernels()
+    {
+      return kernels<T>(best_isa());
+    }
+
+    // -------------------------------------------------------------------------
+    // below this size, a kernel isn't worth the indirect call
+
+    constexpr std::size_t min_kernel_size = 32;
+
+    // -------------------------------------------------------------------------
+    // fold: op(init, p[0] op p[1] op ... op p[n-1]), reassociated
+
+    template <typename T, typename Op>
+    inline T fold(const T* p, std::size_t n, T init, Op)
+    {
+      static_assert(can_fold<T, Op>::value, "no SIMD kernel for T and Op");
+      using Tag = op_tag_t<Op, T>;
+      auto k = n < min_kernel_size ? nullptr : kernels<T>().fold[Tag::index];
+      if (k) return simd::apply(Tag{}, init, k(p, n));
+      for (std::size_t i = 0; i < n; ++i) init = simd::apply(Tag{}, init, p[i]);
+      return init;
+    }
+
+    // -------------------------------------------------------------------------
+    // dot: init + p[0]*q[0] + ... + p[n-1]*q[n-1], reassociated
+
+    template <typename T>
+    inline T dot(const T* p, const T* q, std::size_t n, T init)
+    {
+      static_assert(is_kernel_type<T>::value, "no SIMD kernel for T");
+      auto k = n < min_kernel_size ? nullptr : kernels<T>().dot;
+      if (k) return simd::apply(op_plus{}, init, k(p, q, n));
+      for (std::size_t i = 0; i < n; ++i)
+        init = simd::apply(op_plus{}, init, simd::apply(op_multiplies{}, p[i], q[i]));
+      return init;
+    }
+
+  }
+}
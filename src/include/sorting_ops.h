@@ -1,13 +1,26 @@
 #pragma once
 
 #include "accumulate.h"
+#include "config.h"
+#include "execution.h"
+#include "heap_ops.h"
+#include "minmax_ops.h"
 #include "non_modifying_seq_ops.h"
 #include "partitioning_ops.h"
 #include "set_ops.h"
+#include "thread_pool.h"
 
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <functional>
 #include <iterator>
+#include <limits>
+#include <new>
+#include <type_traits>
 #include <utility>
+#include <vector>
 
 #include <iostream>
 
@@ -22,6 +35,11 @@
 // stable_sort
 // nth_element
 //
+// sort, stable_sort and nth_element also take a parallel policy.
+//
+// radix_sort sorts numbers, or anything by a numeric key, without comparing;
+// sort uses it for numbers in increasing order.
+//
 
 namespace acc
 {
@@ -29,7 +47,7 @@ namespace acc
   // is_sorted and is_sorted_until
 
   template <typename ForwardIt, typename Compare>
-  inline ForwardIt is_sorted_until(
+  ACC_CONSTEXPR17 ForwardIt is_sorted_until(
       ForwardIt first, ForwardIt last, Compare cmp)
   {
     using T = typename std::iterator_traits<ForwardIt>::value_type;
@@ -40,93 +58,1295 @@ namespace acc
   }
 
   template <typename ForwardIt, typename Compare>
-  inline bool is_sorted(ForwardIt first, ForwardIt last, Compare cmp)
+  ACC_CONSTEXPR17 bool is_sorted(ForwardIt first, ForwardIt last, Compare cmp)
   {
     return acc::is_sorted_until(first, last, cmp) == last;
   }
 
   // ---------------------------------------------------------------------------
   // sort
+  //
+  // Over random access iterators, an introsort: quicksort on the median of
+  // three (the ninther above 128 elements); insertion sort below 24 elements;
+  // and heapsort once the depth passes 2 log n, so that no input is
+  // quadratic. When the median ties with a neighbour, a sign of many equal
+  // elements, the partition is a Bentley-McIlroy three-way one, which is done
+  // with all the elements equal to the pivot in one pass; otherwise it's
+  // acc::partition's branchless blocks, with fewer comparisons and no
+  // mispredictions per element. A partition that moved nothing suggests
+  // sorted input, so both sides get an insertion sort that gives up early if
+  // they aren't. Only the smaller side is sorted recursively, so the stack is
+  // O(log n). Numbers in increasing order go to radix_sort (below) instead,
+  // from 1024 elements, which takes a buffer the size of the range; if that
+  // can't be allocated, they get the introsort. A range already in order is
+  // left as it is, and one in reverse order is reversed, since either is
+  // cheaper than a radix pass. The parallel sort and
+  // nth_element choose pivots the same way, under the same depth limit.
+  //
+  // Over forward iterators, quicksort on two passes of acc::partition.
 
-  template <typename ForwardIt, typename Compare>
-  inline void sort(ForwardIt first, ForwardIt last, Compare cmp)
+  namespace detail
   {
-    auto n = std::distance(first, last);
-    if (n <= 1) return;
-    auto pivot = *std::next(first, n/2);
+    constexpr std::ptrdiff_t insertion_sort_limit = 24;
 
-    using T = typename std::iterator_traits<ForwardIt>::value_type;
-    ForwardIt middle1 = acc::partition(
-        first, last,
-        [pivot, &cmp](const T& a){ return cmp(a, pivot); });
-    ForwardIt middle2 = acc::partition(
-        middle1, last,
-        [pivot, &cmp](const T& a){ return !cmp(pivot, a); });
+    // the partitions allowed before the fallback that bounds the worst case:
+    // 2 log n, for sort and nth_element alike, sequential or parallel
+    ACC_CONSTEXPR17 int depth_limit(std::ptrdiff_t n)
+    {
+      int depth = 0;
+      for (; n > 1; n /= 2) depth += 2;
+      return depth;
+    }
+
+    template <typename RandomIt, typename Compare>
+    ACC_CONSTEXPR17 void insertion_sort(
+        RandomIt first, RandomIt last, Compare& cmp)
+    {
+      if (first == last) return;
+      for (auto i = std::next(first); i != last; ++i) {
+        auto v = std::move(*i);
+        auto j = i;
+        if (cmp(v, *first)) {
+          // to the front: no more comparisons needed
+          std::move_backward(first, i, std::next(i));
+          j = first;
+        } else {
+          // *first stops the scan
+          for (auto k = std::prev(j); cmp(v, *k); --k, --j) *j = std::move(*k);
+        }
+        *j = std::move(v);
+      }
+    }
+
+    // insertion sort that gives up after moving 8 elements: false if it gave
+    // up, leaving the range permuted but unsorted
+    template <typename RandomIt, typename Compare>
+    ACC_CONSTEXPR17 bool partial_insertion_sort(
+        RandomIt first, RandomIt last, Compare& cmp)
+    {
+      if (first == last) return true;
+      std::ptrdiff_t moved = 0;
+      for (auto i = std::next(first); i != last; ++i) {
+        if (moved > 8) return false;
+        if (!cmp(*i, *std::prev(i))) continue;
+        auto v = std::move(*i);
+        auto j = i;
+        do {
+          *j = std::move(*std::prev(j));
+          --j;
+        } while (j != first && cmp(v, *std::prev(j)));
+        *j = std::move(v);
+        moved += i - j;
+      }
+      return true;
+    }
+
+    // order *a, *b, *c
+    template <typename RandomIt, typename Compare>
+    ACC_CONSTEXPR17 void sort3(RandomIt a, RandomIt b, RandomIt c, Compare& cmp)
+    {
+      if (cmp(*b, *a)) std::iter_swap(a, b);
+      if (cmp(*c, *b)) {
+        std::iter_swap(b, c);
+        if (cmp(*b, *a)) std::iter_swap(a, b);
+      }
+    }
+
+    // the median of three, or the ninther, to *first, leaving an element no
+    // less than it among the last three; returns whether the median was equal
+    // to a neighbour, a sign of many equal elements
+    template <typename RandomIt, typename Compare>
+    ACC_CONSTEXPR17 bool choose_pivot(RandomIt first, RandomIt last, Compare& cmp)
+    {
+      auto n = last - first;
+      auto mid = first + n/2;
+      auto lo = first + 1, hi = last - 1;
+      if (n > 128) {
+        detail::sort3(first, mid, last - 1, cmp);
+        detail::sort3(first + 1, mid - 1, last - 2, cmp);
+        detail::sort3(first + 2, mid + 1, last - 3, cmp);
+        lo = mid - 1;
+        hi = mid + 1;
+      }
+      detail::sort3(lo, mid, hi, cmp);
+      std::iter_swap(first, mid);
+      return !cmp(*lo, *first) || !cmp(*first, *hi);
+    }
+
+    // partition around the pivot at *first into [less, greater or equal)
+    // with the pivot between; returns the pivot's place, and sets partitioned
+    // if nothing was out of place. What's already in place at each end is
+    // skipped (with no bounds check on the left: choose_pivot left an element
+    // to stop the scan), and the rest goes to acc::partition's branchless
+    // blocks.
+    template <typename RandomIt, typename Compare>
+    ACC_CONSTEXPR17 RandomIt partition2(
+        RandomIt first, RandomIt last, Compare& cmp, bool& partitioned)
+    {
+      using T = typename std::iterator_traits<RandomIt>::value_type;
+      const auto& v = *first;
+      auto l = first;
+      while (cmp(*++l, v)) {}
+      auto r = last;
+      while (l < r && !cmp(*std::prev(r), v)) --r;
+      if (l < r) {
+        partitioned = false;
+        auto less = [&] (const T& a) { return cmp(a, v); };
+        l = detail::partition(l, r, less, std::random_access_iterator_tag{});
+      }
+      std::iter_swap(first, --l);
+      return l;
+    }
+
+    // partition around the pivot at *first into [less, equal, greater) in
+    // one pass: equal elements are swapped to the ends as they're found, and
+    // into the middle at the end; returns the equal range. It costs more
+    // comparisons than partition2, so it's for when there are equal elements
+    // to skip.
+    template <typename RandomIt, typename Compare>
+    ACC_CONSTEXPR17 std::pair<RandomIt, RandomIt> partition3(
+        RandomIt first, RandomIt last, Compare& cmp, bool& partitioned)
+    {
+      const auto& v = *first;
+      auto n = last - first;
+      decltype(n) i = 0, j = n, p = 0, q = n;
+      while (true) {
+        while (cmp(first[++i], v)) {}
+        while (cmp(v, first[--j])) {}
+        if (i >= j) {
+          if (i == j) std::iter_swap(first + ++p, first + i);
+          break;
+        }
+        partitioned = false;
+        std::iter_swap(first + i, first + j);
+        if (!cmp(first[i], v)) std::iter_swap(first + ++p, first + i);
+        if (!cmp(v, first[j])) std::iter_swap(first + --q, first + j);
+      }
+      i = j + 1;
+      for (decltype(n) k = 0; k <= p; ++k) std::iter_swap(first + k, first + j--);
+      for (auto k = n - 1; k >= q; --k) std::iter_swap(first + k, first + i++);
+      return { first + (j + 1), first + i };
+    }
+
+    // choose a pivot and partition around it: returns the range equal to it
+    template <typename RandomIt, typename Compare>
+    ACC_CONSTEXPR17 std::pair<RandomIt, RandomIt> partition_pivot(
+        RandomIt first, RandomIt last, Compare& cmp, bool& partitioned)
+    {
+      if (detail::choose_pivot(first, last, cmp)) {
+        return detail::partition3(first, last, cmp, partitioned);
+      }
+      auto p = detail::partition2(first, last, cmp, partitioned);
+      return { p, std::next(p) };
+    }
+
+    template <typename RandomIt, typename Compare>
+    ACC_CONSTEXPR17 void introsort(
+        RandomIt first, RandomIt last, int depth, Compare& cmp)
+    {
+      while (last - first > insertion_sort_limit) {
+        if (depth-- == 0) {
+          acc::make_heap(first, last, cmp);
+          acc::sort_heap(first, last, cmp);
+          return;
+        }
+        bool partitioned = true;
+        auto m = detail::partition_pivot(first, last, cmp, partitioned);
+        // already partitioned: the input may be (nearly) sorted
+        if (partitioned && detail::partial_insertion_sort(first, m.first, cmp)
+            && detail::partial_insertion_sort(m.second, last, cmp)) {
+          return;
+        }
+        if (m.first - first < last - m.second) {
+          detail::introsort(first, m.first, depth, cmp);
+          first = m.second;
+        } else {
+          detail::introsort(m.second, last, depth, cmp);
+          last = m.first;
+        }
+      }
+      detail::insertion_sort(first, last, cmp);
+    }
+
+  }
+
+  // ---------------------------------------------------------------------------
+  // radix_sort
+  //
+  // A stable LSD radix sort of numbers, or of anything by a numeric key: one
+  // pass counts every byte of every key, and then each byte, least
+  // significant first, is a pass that scatters the values to their places,
+  // back and forth between the range and one scratch buffer. A byte that's
+  // the same in every key takes no pass, so that small keys in a wide type
+  // cost fewer passes. Signed and floating point keys are mapped to unsigned
+  // ones in the same order (floating point by its bits: -0 before 0, and NaNs
+  // at the ends). Short ranges get an insertion sort on the same keys.
+
+  namespace detail
+  {
+    template <typename T>
+    using is_radix_key = std::integral_constant<
+      bool,
+      (std::is_integral<T>::value && !std::is_same<T, bool>::value)
+      || (std::is_floating_point<T>::value && std::numeric_limits<T>::is_iec559
+          && (sizeof(T) == 4 || sizeof(T) == 8))>;
+
+    template <typename T, typename = void>
+    struct radix_key;
+
+    // integers: the sign bit flipped, so that negatives come first
+    template <typename T>
+    struct radix_key<T, std::enable_if_t<std::is_integral<T>::value>>
+    {
+      using type = std::make_unsigned_t<T>;
+
+      static constexpr type get(T x)
+      {
+        constexpr auto sign = std::is_signed<T>::value
+          ? static_cast<type>(type{1} << (8 * sizeof(T) - 1)) : type{0};
+        return static_cast<type>(static_cast<type>(x) ^ sign);
+      }
+    };
+
+    // floating point: positives with the sign bit set, and negatives with all
+    // the bits flipped, so that they count down below the positives
+    template <typename T>
+    struct radix_key<T, std::enable_if_t<std::is_floating_point<T>::value>>
+    {
+      using type = std::conditional_t<sizeof(T) == 4, std::uint32_t, std::uint64_t>;
+
+      static type get(T x)
+      {
+        type bits;
+        std::memcpy(&bits, &x, sizeof(bits));
+        constexpr auto top = type{1} << (8 * sizeof(type) - 1);
+        return bits ^ (static_cast<type>(0 - (bits >> (8 * sizeof(type) - 1))) | top);
+      }
+    };
+
+    constexpr std::ptrdiff_t radix_sort_limit = 64;
+
+    // above this many bytes, the first pass goes by the most significant byte
+    // instead, so that the passes over each of its buckets stay in cache
+    constexpr std::size_t radix_msd_bytes = std::size_t{1} << 20;
+
+    // sort the n values at data (or at buffer, if in_buffer) by the bytes of
+    // their keys below digits, leaving them at data
+    template <typename RandomIt, typename T, typename UKey>
+    inline void radix_lsd(RandomIt data, T* buffer, std::ptrdiff_t n,
+                          std::size_t digits, bool in_buffer, UKey& ukey)
+    {
+      using U = decltype(ukey(*buffer));
+      std::ptrdiff_t counts[sizeof(U)][256] = {};
+      auto count = [&] (auto src) {
+        for (std::ptrdiff_t i = 0; i < n; ++i) {
+          auto k = ukey(src[i]);
+          for (std::size_t d = 0; d < digits; ++d) ++counts[d][(k >> (8*d)) & 0xff];
+        }
+        return ukey(src[0]);
+      };
+      auto scatter = [&] (auto src, auto dst, std::size_t d, std::ptrdiff_t* offsets) {
+        for (std::ptrdiff_t i = 0; i < n; ++i) {
+          auto b = (ukey(src[i]) >> (8*d)) & 0xff;
+          dst[offsets[b]++] = std::move(src[i]);
+        }
+      };
+
+      auto first_key = in_buffer ? count(buffer) : count(data);
+      for (std::size_t d = 0; d < digits; ++d) {
+        auto c = counts[d];
+        // the same byte in every key
+        if (c[(first_key >> (8*d)) & 0xff] == n) continue;
+        std::ptrdiff_t sum = 0;
+        for (std::size_t b = 0; b < 256; ++b) {
+          auto t = c[b];
+          c[b] = sum;
+          sum += t;
+        }
+        if (in_buffer) {
+          scatter(buffer, data, d, c);
+        } else {
+          scatter(data, buffer, d, c);
+        }
+        in_buffer = !in_buffer;
+      }
+      if (in_buffer) std::move(buffer, buffer + n, data);
+    }
+
+    // the same, for more than fits in cache: one pass by the most significant
+    // byte that isn't the same in every key, and then each of its buckets
+    template <typename RandomIt, typename T, typename UKey, typename Compare>
+    inline void radix_msd(RandomIt data, T* buffer, std::ptrdiff_t n,
+                          std::size_t digits, bool in_buffer, UKey& ukey,
+                          Compare& cmp)
+    {
+      auto msd = [&] (auto src, auto dst) {
+        auto first_key = ukey(src[0]);
+        decltype(first_key) diff = 0;
+        for (std::ptrdiff_t i = 0; i < n; ++i) diff |= ukey(src[i]) ^ first_key;
+        auto top = digits;
+        while (top > 0 && ((diff >> (8*(top - 1))) & 0xff) == 0) --top;
+        if (top-- == 0) {
+          if (in_buffer) std::move(buffer, buffer + n, data);
+          return;
+        }
+
+        std::ptrdiff_t bounds[257] = {};
+        for (std::ptrdiff_t i = 0; i < n; ++i) {
+          ++bounds[((ukey(src[i]) >> (8*top)) & 0xff) + 1];
+        }
+        for (std::size_t b = 1; b <= 256; ++b) bounds[b] += bounds[b - 1];
+        std::ptrdiff_t offsets[256];
+        std::copy(bounds, bounds + 256, offsets);
+        for (std::ptrdiff_t i = 0; i < n; ++i) {
+          dst[offsets[(ukey(src[i]) >> (8*top)) & 0xff]++] = std::move(src[i]);
+        }
+
+        for (std::size_t b = 0; b < 256; ++b) {
+          auto m = bounds[b + 1] - bounds[b];
+          auto bucket = data + bounds[b];
+          auto scratch = buffer + bounds[b];
+          if (m <= radix_sort_limit) {
+            if (!in_buffer) std::move(scratch, scratch + m, bucket);
+            detail::insertion_sort(bucket, bucket + m, cmp);
+          } else if (static_cast<std::size_t>(m) * sizeof(T) > radix_msd_bytes) {
+            detail::radix_msd(bucket, scratch, m, top, !in_buffer, ukey, cmp);
+          } else {
+            detail::radix_lsd(bucket, scratch, m, top, !in_buffer, ukey);
+          }
+        }
+      };
+      if (in_buffer) {
+        msd(buffer, data);
+      } else {
+        msd(data, buffer);
+      }
+    }
+
+    template <typename RandomIt, typename KeyFn>
+    inline void radix_sort(RandomIt first, RandomIt last, KeyFn& key)
+    {
+      using T = typename std::iterator_traits<RandomIt>::value_type;
+      using R = std::decay_t<decltype(key(*first))>;
+      static_assert(is_radix_key<R>::value,
+                    "radix_sort keys must be integers, float or double");
+      using K = radix_key<R>;
+      constexpr std::size_t digits = sizeof(typename K::type);
+      auto ukey = [&] (const T& a) { return K::get(key(a)); };
+      auto cmp = [&] (const T& a, const T& b) { return ukey(a) < ukey(b); };
 
-    acc::sort(first, middle1, cmp);
-    acc::sort(middle2, last, cmp);
+      auto n = last - first;
+      if (n <= radix_sort_limit) {
+        detail::insertion_sort(first, last, cmp);
+        return;
+      }
+      std::vector<T> buffer(std::make_move_iterator(first),
+                            std::make_move_iterator(last));
+      if (static_cast<std::size_t>(n) * sizeof(T) > radix_msd_bytes) {
+        detail::radix_msd(first, buffer.data(), n, digits, true, ukey, cmp);
+      } else {
+        detail::radix_lsd(first, buffer.data(), n, digits, true, ukey);
+      }
+    }
+
+    // acc::sort uses radix_sort for numbers in increasing order, from where
+    // it's faster, except on input that's already in order (or in reverse),
+    // which a scan finds before anything is allocated or scattered
+    constexpr std::ptrdiff_t radix_sort_threshold = 1024;
+
+    template <typename RandomIt, typename Compare>
+    using sorts_by_radix = std::integral_constant<
+      bool,
+      is_radix_key<typename std::iterator_traits<RandomIt>::value_type>::value
+      && (std::is_same<Compare, std::less<>>::value
+          || std::is_same<Compare, std::less<
+               typename std::iterator_traits<RandomIt>::value_type>>::value)>;
+
+    template <typename RandomIt, typename Compare>
+    inline bool sort_by_radix(RandomIt, RandomIt, Compare&, std::false_type)
+    {
+      return false;
+    }
+
+    template <typename RandomIt, typename Compare>
+    inline bool sort_by_radix(RandomIt first, RandomIt last, Compare& cmp, std::true_type)
+    {
+      if (last - first < radix_sort_threshold) return false;
+      // on shuffled input the scan stops within a few elements
+      bool ascending = true, descending = true;
+      for (auto i = first + 1; i != last && (ascending || descending); ++i) {
+        ascending = ascending && !cmp(*i, *(i - 1));
+        descending = descending && !cmp(*(i - 1), *i);
+      }
+      if (ascending) return true;
+      if (descending) {
+        std::reverse(first, last);
+        return true;
+      }
+      auto key = [] (const auto& a) { return a; };
+      try {
+        detail::radix_sort(first, last, key);
+      } catch (const std::bad_alloc&) {
+        // no room for the buffer, which is allocated before anything moves:
+        // sort in place instead
+        return false;
+      }
+      return true;
+    }
+  }
+
+  template <typename RandomIt>
+  inline void radix_sort(RandomIt first, RandomIt last)
+  {
+    auto key = [] (const auto& a) { return a; };
+    detail::radix_sort(first, last, key);
+  }
+
+  // sort by key(element), which must be a number
+  template <typename RandomIt, typename KeyFn>
+  inline void radix_sort(RandomIt first, RandomIt last, KeyFn key)
+  {
+    detail::radix_sort(first, last, key);
+  }
+
+  namespace detail
+  {
+    template <typename RandomIt, typename Compare>
+    ACC_CONSTEXPR17 void sort(
+        RandomIt first, RandomIt last, Compare& cmp,
+        std::random_access_iterator_tag)
+    {
+      if (!ACC_IS_CONSTANT_EVALUATED()
+          && detail::sort_by_radix(first, last, cmp,
+                                   sorts_by_radix<RandomIt, Compare>{})) {
+        return;
+      }
+      auto depth = detail::depth_limit(last - first);
+      detail::introsort(first, last, depth, cmp);
+    }
+
+    template <typename ForwardIt, typename Compare>
+    ACC_CONSTEXPR17 void sort(
+        ForwardIt first, ForwardIt last, Compare& cmp,
+        std::forward_iterator_tag)
+    {
+      auto n = std::distance(first, last);
+      if (n <= 1) return;
+      auto pivot = *std::next(first, n/2);
+
+      using T = typename std::iterator_traits<ForwardIt>::value_type;
+      ForwardIt middle1 = acc::partition(
+          first, last,
+          [pivot, &cmp](const T& a){ return cmp(a, pivot); });
+      ForwardIt middle2 = acc::partition(
+          middle1, last,
+          [pivot, &cmp](const T& a){ return !cmp(pivot, a); });
+
+      detail::sort(first, middle1, cmp, std::forward_iterator_tag{});
+      detail::sort(middle2, last, cmp, std::forward_iterator_tag{});
+    }
+  }
+
+  template <typename ForwardIt, typename Compare>
+  ACC_CONSTEXPR17 void sort(ForwardIt first, ForwardIt last, Compare cmp)
+  {
+    detail::sort(first, last, cmp,
+                 typename std::iterator_traits<ForwardIt>::iterator_category{});
   }
 
   template <typename ForwardIt>
-  void sort(ForwardIt first, ForwardIt last)
+  ACC_CONSTEXPR17 void sort(ForwardIt first, ForwardIt last)
   {
     acc::sort(first, last, std::less<>{});
   }
 
+  // parallel: sort's pivot, with both partitions (less than it, then equal)
+  // run in parallel chunks; the smaller side is sorted as a separate task,
+  // and the larger one in the same loop, down to the policy's grain. Past
+  // the same 2 log n depth, what's left is sorted sequentially.
+
+  namespace detail
+  {
+    template <typename RandomIt, typename Compare>
+    void parallel_sort(
+        const execution::parallel_policy& policy,
+        RandomIt first, RandomIt last, int depth, Compare& cmp)
+    {
+      using T = typename std::iterator_traits<RandomIt>::value_type;
+      auto grain = std::max(policy.grain, std::size_t{1});
+      task_group tasks;
+      while (static_cast<std::size_t>(last - first) > grain
+             && last - first > insertion_sort_limit && depth-- > 0) {
+        detail::choose_pivot(first, last, cmp);
+        auto pivot = *first;
+        RandomIt middle1 = acc::partition(
+            policy, first, last,
+            [&pivot, &cmp](const T& a){ return cmp(a, pivot); });
+        RandomIt middle2 = acc::partition(
+            policy, middle1, last,
+            [&pivot, &cmp](const T& a){ return !cmp(pivot, a); });
+        if (middle1 - first < last - middle2) {
+          tasks.spawn([&policy, first, middle1, depth, &cmp] {
+              detail::parallel_sort(policy, first, middle1, depth, cmp);
+            });
+          first = middle2;
+        } else {
+          tasks.spawn([&policy, middle2, last, depth, &cmp] {
+              detail::parallel_sort(policy, middle2, last, depth, cmp);
+            });
+          last = middle1;
+        }
+      }
+      acc::sort(first, last, cmp);
+      tasks.sync();
+    }
+  }
+
+  template <typename RandomIt, typename Compare>
+  inline void sort(
+      const execution::parallel_policy& policy,
+      RandomIt first, RandomIt last, Compare cmp)
+  {
+    auto depth = detail::depth_limit(last - first);
+    detail::parallel_sort(policy, first, last, depth, cmp);
+  }
+
+  template <typename RandomIt>
+  void sort(
+      const execution::parallel_policy& policy,
+      RandomIt first, RandomIt last)
+  {
+    acc::sort(policy, first, last, std::less<>{});
+  }
+
   // ---------------------------------------------------------------------------
   // stable sort
+  //
+  // A natural merge sort: the input is cut into the runs already in it
+  // (strictly descending ones are reversed), and runs shorter than 32
+  // elements are extended by insertion sort. Runs are merged as they're
+  // found, in the order powersort picks from their positions, which keeps the
+  // merges balanced. A merge first skips the elements already in place at
+  // both ends, then moves the shorter run to a scratch buffer and merges back
+  // into the range; when one run wins 7 times in a row, the merge gallops,
+  // finding how far it wins by exponential search and moving that stretch at
+  // once. So sorted input is n - 1 comparisons and no allocation, and input
+  // made of a few runs costs little more than finding them.
+  //
+  // The buffer, half the range, is allocated once, at the first merge. If
+  // that fails, merges are done in place by rotations, at O(n log n) each
+  // rather than O(n). That's also how merges go during constant evaluation.
 
-  template <typename ForwardIt, typename Compare>
-  inline void stable_sort(ForwardIt first, ForwardIt last, Compare cmp)
+  namespace detail
   {
-    auto n = std::distance(first, last);
-    if (n > 1)
+    constexpr std::ptrdiff_t min_run = 32;
+    constexpr std::ptrdiff_t gallop_after = 7;
+
+    // the scratch space for merges: allocated on first use, or a view of part
+    // of another buffer's (with no space if that allocation failed)
+    template <typename T>
+    struct merge_buffer
+    {
+      std::vector<T> v;
+      T* data = nullptr;
+      std::ptrdiff_t capacity = 0;
+      std::ptrdiff_t size;
+      bool tried = false;
+
+      explicit merge_buffer(std::ptrdiff_t n) : size(n) {}
+
+      merge_buffer(T* p, std::ptrdiff_t n)
+        : data(p), capacity(p ? n : 0), size(n), tried(true)
+      {}
+
+      // size elements, moved in from first and back, so that the buffer
+      // holds objects to move to
+      template <typename RandomIt>
+      void allocate(RandomIt first)
+      {
+        if (tried) return;
+        tried = true;
+        try {
+          v.assign(std::make_move_iterator(first),
+                   std::make_move_iterator(first + size));
+        } catch (const std::bad_alloc&) {
+          return;
+        }
+        std::move(v.begin(), v.end(), first);
+        data = v.data();
+        capacity = size;
+      }
+    };
+
+    // the number of elements at the front of [first, first + n) that satisfy
+    // p, where those that do all come first: exponential search from the
+    // front, then binary search
+    template <typename RandomIt, typename Predicate>
+    ACC_CONSTEXPR17 std::ptrdiff_t gallop(
+        RandomIt first, std::ptrdiff_t n, Predicate p)
+    {
+      std::ptrdiff_t lo = 0;
+      std::ptrdiff_t step = 1;
+      while (step <= n && p(first[step - 1])) {
+        lo = step;
+        step = 2 * step + 1;
+      }
+      auto hi = std::min(step - 1, n);
+      while (lo < hi) {
+        auto mid = lo + (hi - lo) / 2;
+        if (p(first[mid])) lo = mid + 1; else hi = mid;
+      }
+      return lo;
+    }
+
+    // the same, with the exponential search from the back
+    template <typename RandomIt, typename Predicate>
+    ACC_CONSTEXPR17 std::ptrdiff_t gallop_back(
+        RandomIt first, std::ptrdiff_t n, Predicate p)
+    {
+      std::ptrdiff_t hi = n;
+      std::ptrdiff_t step = 1;
+      while (step <= n && !p(first[n - step])) {
+        hi = n - step;
+        step = 2 * step + 1;
+      }
+      auto lo = step <= n ? n - step + 1 : 0;
+      while (lo < hi) {
+        auto mid = lo + (hi - lo) / 2;
+        if (p(first[mid])) lo = mid + 1; else hi = mid;
+      }
+      return lo;
+    }
+
+    // merge with [first, middle) in the buffer, front to back
+    template <typename RandomIt, typename Compare, typename T>
+    void merge_low(RandomIt first, RandomIt middle, RandomIt last,
+                   Compare& cmp, T* buffer)
     {
-      auto m = first + n/2;
-      acc::stable_sort(first, m, cmp);
-      acc::stable_sort(m, last, cmp);
-      acc::inplace_merge(first, m, last, cmp);
+      auto end = std::move(first, middle, buffer);
+      auto x = buffer;
+      auto y = middle;
+      auto out = first;
+      std::ptrdiff_t wins_x = 0;
+      std::ptrdiff_t wins_y = 0;
+      while (x != end && y != last) {
+        if (cmp(*y, *x)) {
+          *out++ = std::move(*y++);
+          ++wins_y;
+          wins_x = 0;
+        } else {
+          *out++ = std::move(*x++);
+          ++wins_x;
+          wins_y = 0;
+        }
+        if (wins_x >= gallop_after && y != last) {
+          auto k = detail::gallop(x, end - x,
+                                  [&] (const T& a) { return !cmp(*y, a); });
+          out = std::move(x, x + k, out);
+          x += k;
+          wins_x = 0;
+        } else if (wins_y >= gallop_after && x != end) {
+          auto k = detail::gallop(y, last - y,
+                                  [&] (const T& b) { return cmp(b, *x); });
+          out = std::move(y, y + k, out);
+          y += k;
+          wins_y = 0;
+        }
+      }
+      std::move(x, end, out);
+    }
+
+    // merge with [middle, last) in the buffer, back to front
+    template <typename RandomIt, typename Compare, typename T>
+    void merge_high(RandomIt first, RandomIt middle, RandomIt last,
+                    Compare& cmp, T* buffer)
+    {
+      auto x = middle;
+      auto y = std::move(middle, last, buffer);
+      auto out = last;
+      std::ptrdiff_t wins_x = 0;
+      std::ptrdiff_t wins_y = 0;
+      while (x != first && y != buffer) {
+        if (cmp(*std::prev(y), *std::prev(x))) {
+          *--out = std::move(*--x);
+          ++wins_x;
+          wins_y = 0;
+        } else {
+          *--out = std::move(*--y);
+          ++wins_y;
+          wins_x = 0;
+        }
+        if (wins_x >= gallop_after && y != buffer) {
+          const T& b = *std::prev(y);
+          auto k = (x - first) - detail::gallop_back(
+              first, x - first, [&] (const T& a) { return !cmp(b, a); });
+          out = std::move_backward(x - k, x, out);
+          x -= k;
+          wins_x = 0;
+        } else if (wins_y >= gallop_after && x != first) {
+          auto& a = *std::prev(x);
+          auto n = y - buffer;
+          auto k = n - detail::gallop_back(
+              buffer, n, [&] (const T& b) { return cmp(b, a); });
+          out = std::move_backward(y - k, y, out);
+          y -= k;
+          wins_y = 0;
+        }
+      }
+      std::move_backward(buffer, y, out);
+    }
+
+    // merge without a buffer: split the longer run in half, find where its
+    // middle element goes in the other, rotate the two inner parts past each
+    // other, and merge both sides
+    template <typename RandomIt, typename Compare>
+    ACC_CONSTEXPR17 void merge_rotating(
+        RandomIt first, RandomIt middle, RandomIt last, Compare& cmp)
+    {
+      using T = typename std::iterator_traits<RandomIt>::value_type;
+      while (first != middle && middle != last) {
+        auto n1 = middle - first;
+        auto n2 = last - middle;
+        if (n1 + n2 == 2) {
+          if (cmp(*middle, *first)) std::iter_swap(first, middle);
+          return;
+        }
+        RandomIt cut1 = first;
+        RandomIt cut2 = middle;
+        if (n1 > n2) {
+          cut1 += n1 / 2;
+          cut2 += detail::gallop(middle, n2,
+                                 [&] (const T& b) { return cmp(b, *cut1); });
+        } else {
+          cut2 += n2 / 2;
+          cut1 += detail::gallop(first, n1,
+                                 [&] (const T& a) { return !cmp(*cut2, a); });
+        }
+        auto m = cut1 + (cut2 - middle);
+        if (cut1 != middle && middle != cut2) acc::rotate(cut1, middle, cut2);
+        // recurse on the shorter side
+        if (m - first < last - m) {
+          detail::merge_rotating(first, cut1, m, cmp);
+          first = m;
+          middle = cut2;
+        } else {
+          detail::merge_rotating(m, cut2, last, cmp);
+          last = m;
+          middle = cut1;
+        }
+      }
+    }
+
+    // merge two adjacent sorted runs, in the buffer if there is one and the
+    // shorter run (less the ends already in place) fits
+    template <typename RandomIt, typename Compare, typename T>
+    ACC_CONSTEXPR17 void merge_runs(
+        RandomIt first, RandomIt middle, RandomIt last,
+        Compare& cmp, merge_buffer<T>* buffer)
+    {
+      first += detail::gallop(first, middle - first,
+                              [&] (const T& a) { return !cmp(*middle, a); });
+      if (first == middle) return;
+      last = middle + detail::gallop_back(
+          middle, last - middle,
+          [&] (const T& b) { return cmp(b, *std::prev(middle)); });
+
+      auto n1 = middle - first;
+      auto n2 = last - middle;
+      if (buffer && std::min(n1, n2) <= buffer->capacity) {
+        if (n1 <= n2) {
+          detail::merge_low(first, middle, last, cmp, buffer->data);
+        } else {
+          detail::merge_high(first, middle, last, cmp, buffer->data);
+        }
+      } else {
+        detail::merge_rotating(first, middle, last, cmp);
+      }
+    }
+
+    // the end of the run at first, made ascending; at least min_run long,
+    // unless the range ends first
+    template <typename RandomIt, typename Compare>
+    ACC_CONSTEXPR17 RandomIt next_run(RandomIt first, RandomIt last, Compare& cmp)
+    {
+      auto end = std::next(first);
+      if (end == last) return end;
+      if (cmp(*end, *first)) {
+        // strictly descending, so that reversing it is stable
+        while (++end != last && cmp(*end, *std::prev(end))) {}
+        acc::reverse(first, end);
+      } else {
+        while (++end != last && !cmp(*end, *std::prev(end))) {}
+      }
+      if (end - first < min_run) {
+        end = first + std::min(min_run, last - first);
+        detail::insertion_sort(first, end, cmp);
+      }
+      return end;
+    }
+
+    // powersort's priority for the merge of adjacent runs [b1, b2) and [b2,
+    // e2) of a range of n: the depth of the node between their midpoints in
+    // a perfectly balanced merge tree
+    constexpr int node_power(std::ptrdiff_t b1, std::ptrdiff_t b2,
+                             std::ptrdiff_t e2, std::ptrdiff_t n)
+    {
+      // twice the midpoints, against twice n
+      auto a = static_cast<std::uint64_t>(b1 + b2);
+      auto b = static_cast<std::uint64_t>(b2 + e2);
+      auto m = 2 * static_cast<std::uint64_t>(n);
+      int power = 0;
+      for (;;) {
+        ++power;
+        if (a >= m) {
+          a -= m;
+          b -= m;
+        } else if (b >= m) {
+          break;
+        }
+        a *= 2;
+        b *= 2;
+      }
+      return power;
+    }
+
+    template <typename RandomIt, typename Compare, typename T>
+    ACC_CONSTEXPR17 void stable_sort(
+        RandomIt first, RandomIt last, Compare& cmp, merge_buffer<T>* buffer)
+    {
+      auto n = last - first;
+      if (n <= min_run) {
+        detail::insertion_sort(first, last, cmp);
+        return;
+      }
+      // the pending runs: each one's start, and the power of the merge with
+      // the next; powers increase up the stack, so it's at most log n high
+      std::ptrdiff_t starts[64] = {};
+      int powers[64] = {};
+      int h = 0;
+      for (std::ptrdiff_t begin = 0; begin != n;) {
+        auto end = detail::next_run(first + begin, last, cmp) - first;
+        if (h > 0) {
+          if (buffer) buffer->allocate(first);
+          auto power = detail::node_power(starts[h-1], begin, end, n);
+          while (h > 1 && powers[h-2] > power) {
+            detail::merge_runs(first + starts[h-2], first + starts[h-1],
+                               first + begin, cmp, buffer);
+            --h;
+          }
+          powers[h-1] = power;
+        }
+        starts[h++] = begin;
+        begin = end;
+      }
+      for (; h > 1; --h) {
+        detail::merge_runs(first + starts[h-2], first + starts[h-1], last,
+                           cmp, buffer);
+      }
+    }
+
+    template <typename RandomIt, typename Compare>
+    inline void stable_sort_buffered(RandomIt first, RandomIt last, Compare& cmp)
+    {
+      using T = typename std::iterator_traits<RandomIt>::value_type;
+      detail::merge_buffer<T> buffer{(last - first) / 2};
+      detail::stable_sort(first, last, cmp, &buffer);
     }
   }
 
-  template <typename ForwardIt>
-  void stable_sort(ForwardIt first, ForwardIt last)
+  template <typename RandomIt, typename Compare>
+  ACC_CONSTEXPR17 void stable_sort(RandomIt first, RandomIt last, Compare cmp)
+  {
+    if (ACC_IS_CONSTANT_EVALUATED()) {
+      using T = typename std::iterator_traits<RandomIt>::value_type;
+      detail::stable_sort(first, last, cmp,
+                          static_cast<detail::merge_buffer<T>*>(nullptr));
+    } else {
+      detail::stable_sort_buffered(first, last, cmp);
+    }
+  }
+
+  template <typename RandomIt>
+  ACC_CONSTEXPR17 void stable_sort(RandomIt first, RandomIt last)
   {
     acc::stable_sort(first, last, std::less<>{});
   }
 
+  // parallel: the two halves are sorted as separate tasks, down to the
+  // policy's grain, and merged as the sequential sort merges. There's one
+  // buffer, allocated at the top: each task merges in its own part of it.
+
+  namespace detail
+  {
+    // buffer holds (last - first) / 2 elements, or is null
+    template <typename RandomIt, typename Compare, typename T>
+    void parallel_stable_sort(
+        const execution::parallel_policy& policy,
+        RandomIt first, RandomIt last, Compare& cmp, T* buffer)
+    {
+      auto n = last - first;
+      detail::merge_buffer<T> part{buffer, n / 2};
+      if (static_cast<std::size_t>(n) <= std::max(policy.grain, std::size_t{1})) {
+        return detail::stable_sort(first, last, cmp, &part);
+      }
+      auto n1 = n / 2;
+      auto m = first + n1;
+      acc::fork_join(
+          [&] { detail::parallel_stable_sort(policy, first, m, cmp, buffer); },
+          [&] {
+            detail::parallel_stable_sort(policy, m, last, cmp,
+                                         buffer ? buffer + n1 / 2 : buffer);
+          });
+      detail::merge_runs(first, m, last, cmp, &part);
+    }
+  }
+
+  template <typename RandomIt, typename Compare>
+  inline void stable_sort(
+      const execution::parallel_policy& policy,
+      RandomIt first, RandomIt last, Compare cmp)
+  {
+    auto n = last - first;
+    if (static_cast<std::size_t>(n) <= std::max(policy.grain, std::size_t{1})) {
+      return acc::stable_sort(first, last, cmp);
+    }
+    using T = typename std::iterator_traits<RandomIt>::value_type;
+    detail::merge_buffer<T> buffer{n / 2};
+    buffer.allocate(first);
+    detail::parallel_stable_sort(policy, first, last, cmp, buffer.data);
+  }
+
+  template <typename RandomIt>
+  void stable_sort(
+      const execution::parallel_policy& policy,
+      RandomIt first, RandomIt last)
+  {
+    acc::stable_sort(policy, first, last, std::less<>{});
+  }
+
 
   // ---------------------------------------------------------------------------
   // nth element
 
+  // quickselect, with sort's pivots and partitions, keeping only the side
+  // that holds nth; past 2 log n partitions the rest is sorted, so that no
+  // input is quadratic
+
+  template <typename RandomIt, typename Compare>
+  ACC_CONSTEXPR17 void nth_element(
+      RandomIt first, RandomIt nth, RandomIt last, Compare cmp)
+  {
+    if (first == last || nth == last) return;
+
+    auto depth = detail::depth_limit(last - first);
+    while (last - first > detail::insertion_sort_limit) {
+      if (depth-- == 0) {
+        detail::introsort(first, last, 0, cmp);
+        return;
+      }
+      bool partitioned = true;
+      auto m = detail::partition_pivot(first, last, cmp, partitioned);
+      if (nth < m.first) {
+        last = m.first;
+      } else if (nth < m.second) {
+        return;
+      } else {
+        first = m.second;
+      }
+    }
+    detail::insertion_sort(first, last, cmp);
+  }
+
+  template <typename RandomIt>
+  ACC_CONSTEXPR17 void nth_element(
+      RandomIt first, RandomIt nth, RandomIt last)
+  {
+    return acc::nth_element(first, nth, last, std::less<>{});
+  }
+
+  // parallel: only one side of each partition holds nth, so the partitions
+  // themselves run in parallel chunks, down to the policy's grain; the pivot
+  // and the 2 log n depth limit are the sequential quickselect's, which
+  // finishes what's left
   template <typename RandomIt, typename Compare>
   void nth_element(
+      const execution::parallel_policy& policy,
       RandomIt first, RandomIt nth, RandomIt last, Compare cmp)
   {
     if (first == last || nth == last) return;
 
     using T = typename std::iterator_traits<RandomIt>::value_type;
-    auto i = acc::partition(
-        std::next(first), last,
-        [&] (const T& a) { return cmp(a, *first); });
-    std::iter_swap(--i, first);
-    if (i == nth) return;
+    auto grain = std::max(policy.grain, std::size_t{1});
+    auto depth = detail::depth_limit(last - first);
+    while (static_cast<std::size_t>(last - first) > grain
+           && last - first > detail::insertion_sort_limit && depth-- > 0) {
+      detail::choose_pivot(first, last, cmp);
+      auto pivot = *first;
+      RandomIt middle1 = acc::partition(
+          policy, first, last,
+          [&pivot, &cmp](const T& a){ return cmp(a, pivot); });
+      RandomIt middle2 = acc::partition(
+          policy, middle1, last,
+          [&pivot, &cmp](const T& a){ return !cmp(pivot, a); });
+      if (nth < middle1) {
+        last = middle1;
+      } else if (nth < middle2) {
+        return;
+      } else {
+        first = middle2;
+      }
+    }
+    acc::nth_element(first, nth, last, cmp);
+  }
+
+  template <typename RandomIt>
+  void nth_element(
+      const execution::parallel_policy& policy,
+      RandomIt first, RandomIt nth, RandomIt last)
+  {
+    return acc::nth_element(policy, first, nth, last, std::less<>{});
+  }
+
+  // ---------------------------------------------------------------------------
+  // partial_sort
+  //
+  // Below k = 128, the k smallest elements in a max-heap of k at the front:
+  // each later element is compared with the largest of them and, for most
+  // inputs, rejected by that one comparison, so the scan is about n
+  // comparisons. When the input keeps displacing the top (as decreasing
+  // input does), quickselect takes over: nth_element puts the k smallest at
+  // the front, and they're sorted.
+  //
+  // From k = 128 a displacement costs a sift of log k steps, so instead the
+  // largest of the front is kept as a threshold, and the elements that beat
+  // it are gathered just after the front; once there are k of them,
+  // nth_element keeps the k smallest of the 2k at the front, and their
+  // largest is the new threshold. About k (1 + ln(n/k)) elements of
+  // shuffled input beat the threshold, and each costs a couple of steps of
+  // a select of 2k. Once that's more than n/16, a quickselect of the whole
+  // range is cheaper, and it's used from the start.
+  //
+  // Either way, the scan tests 16 elements at a time without branching,
+  // which vectorizes for numbers, and only looks at them one by one when
+  // some beat the top.
+
+  namespace detail
+  {
+    constexpr std::ptrdiff_t partial_sort_heap_limit = 128;
+    constexpr std::ptrdiff_t partial_sort_block = 16;
+
+    // whether a quickselect of n is cheaper than gathering the elements that
+    // beat the threshold: about k (1 + ln(n/k)) of them, with ln taken as
+    // 7/10 of log2
+    ACC_CONSTEXPR17 bool partial_sort_selects(std::ptrdiff_t k, std::ptrdiff_t n)
+    {
+      if (k < partial_sort_heap_limit) return false;
+      auto gathered = k + k * (detail::depth_limit(n / k) / 2) * 7 / 10;
+      return gathered * 16 > n;
+    }
+
+    template <typename RandomIt, typename Compare>
+    ACC_CONSTEXPR17 void select_and_sort(
+        RandomIt first, RandomIt middle, RandomIt last, Compare& cmp)
+    {
+      acc::nth_element(first, middle, last, cmp);
+      acc::sort(first, middle, cmp);
+    }
 
-    if (nth < i)
+    // whether any of the partial_sort_block elements at i beats the top
+    template <typename RandomIt, typename T, typename Compare>
+    ACC_CONSTEXPR17 bool any_beats(RandomIt i, const T& top, Compare& cmp)
     {
-      acc::nth_element(first, nth, i, cmp);
+      bool any = false;
+      for (std::ptrdiff_t j = 0; j < partial_sort_block; ++j) any = any | cmp(i[j], top);
+      return any;
     }
-    else
+
+    template <typename RandomIt, typename Compare>
+    ACC_CONSTEXPR17 void heap_select(
+        RandomIt first, RandomIt middle, RandomIt last, Compare& cmp)
+    {
+      auto k = middle - first;
+      acc::make_heap(first, middle, cmp);
+      // past this many displacements, the heap is costing more than a select
+      auto budget = 2 * k + (last - middle) / 8;
+      for (auto i = middle; i != last;) {
+        auto block = std::min(partial_sort_block, last - i);
+        if (block == partial_sort_block && !detail::any_beats(i, *first, cmp)) {
+          i += block;
+          continue;
+        }
+        for (auto end = i + block; i != end; ++i) {
+          if (!cmp(*i, *first)) continue;
+          if (--budget == 0) {
+            return detail::select_and_sort(first, middle, last, cmp);
+          }
+          std::iter_swap(first, i);
+          detail::sift_down(first, k, decltype(k){0}, cmp);
+        }
+      }
+      acc::sort_heap(first, middle, cmp);
+    }
+
+    // the k smallest of [first, middle + k) into [first, middle), with
+    // the largest of them last, as the threshold
+    template <typename RandomIt, typename Compare>
+    ACC_CONSTEXPR17 void keep_smallest(
+        RandomIt first, RandomIt middle, RandomIt gathered, Compare& cmp)
+    {
+      acc::nth_element(first, middle - 1, gathered, cmp);
+    }
+
+    template <typename RandomIt, typename Compare>
+    ACC_CONSTEXPR17 void threshold_select(
+        RandomIt first, RandomIt middle, RandomIt last, Compare& cmp)
     {
-      acc::nth_element(++i, nth, last, cmp);
+      auto k = middle - first;
+      auto top = middle - 1;
+      std::iter_swap(top, acc::max_element(first, middle, cmp));
+      auto gathered = middle;
+      for (auto i = middle; i != last;) {
+        auto block = std::min(partial_sort_block, last - i);
+        if (block == partial_sort_block && !detail::any_beats(i, *top, cmp)) {
+          i += block;
+          continue;
+        }
+        for (auto end = i + block; i != end; ++i) {
+          if (!cmp(*i, *top)) continue;
+          std::iter_swap(gathered++, i);
+          if (gathered - middle == k) {
+            detail::keep_smallest(first, middle, gathered, cmp);
+            gathered = middle;
+          }
+        }
+      }
+      if (gathered != middle) detail::keep_smallest(first, middle, gathered, cmp);
+      acc::sort(first, middle, cmp);
+    }
+  }
+
+  template <typename RandomIt, typename Compare>
+  ACC_CONSTEXPR17 void partial_sort(
+      RandomIt first, RandomIt middle, RandomIt last, Compare cmp)
+  {
+    auto k = middle - first;
+    auto n = last - first;
+    if (k == 0) return;
+    if (k < detail::partial_sort_heap_limit) {
+      detail::heap_select(first, middle, last, cmp);
+    } else if (detail::partial_sort_selects(k, n)) {
+      detail::select_and_sort(first, middle, last, cmp);
+    } else {
+      detail::threshold_select(first, middle, last, cmp);
     }
   }
 
   template <typename RandomIt>
-  void nth_element(
-      RandomIt first, RandomIt nth, RandomIt last)
+  ACC_CONSTEXPR17 void partial_sort(
+      RandomIt first, RandomIt middle, RandomIt last)
   {
-    return acc::nth_element(first, nth, last, std::less<>{});
+    acc::partial_sort(first, middle, last, std::less<>{});
+  }
+
+  // ---------------------------------------------------------------------------
+  // partial_sort_copy
+  //
+  // The same two ways, in one pass over the input, read one element at a
+  // time. Below k = 128 (and at compile time) the heap is in the
+  // destination: it fills with the first elements of the input, and each
+  // later one is compared with the largest so far. From k = 128 the
+  // threshold select runs in a buffer of 2k, which holds the k smallest so
+  // far and the elements gathered since; if the buffer can't be allocated,
+  // it's the heap. Without the whole input at hand there's no quickselect.
+
+  namespace detail
+  {
+    template <typename InputIt, typename RandomIt, typename Compare>
+    ACC_CONSTEXPR17 RandomIt heap_select_copy(
+        InputIt first, InputIt last,
+        RandomIt d_first, RandomIt d_last, Compare& cmp)
+    {
+      auto d = d_first;
+      for (; first != last && d != d_last; ++first, ++d) *d = *first;
+      auto k = d - d_first;
+      if (first == last || k == 0) {
+        acc::sort(d_first, d, cmp);
+        return d;
+      }
+
+      acc::make_heap(d_first, d, cmp);
+      for (; first != last; ++first) {
+        if (!cmp(*first, *d_first)) continue;
+        *d_first = *first;
+        detail::sift_down(d_first, k, decltype(k){0}, cmp);
+      }
+      acc::sort_heap(d_first, d, cmp);
+      return d;
+    }
+
+    template <typename InputIt, typename RandomIt, typename Compare>
+    RandomIt threshold_select_copy(
+        InputIt first, InputIt last,
+        RandomIt d_first, RandomIt d_last, Compare& cmp)
+    {
+      using T = typename std::iterator_traits<RandomIt>::value_type;
+      auto k = d_last - d_first;
+      std::vector<T> buffer;
+      try {
+        buffer.reserve(static_cast<std::size_t>(2 * k));
+      } catch (const std::bad_alloc&) {
+        // nothing is read yet
+        return detail::heap_select_copy(first, last, d_first, d_last, cmp);
+      }
+
+      for (; first != last && static_cast<std::ptrdiff_t>(buffer.size()) < k; ++first) {
+        buffer.push_back(*first);
+      }
+      if (first == last) {
+        auto d = std::move(buffer.begin(), buffer.end(), d_first);
+        acc::sort(d_first, d, cmp);
+        return d;
+      }
+
+      // the buffer never grows past the 2k reserved, so the front stays put
+      auto middle = buffer.begin() + k;
+      std::iter_swap(middle - 1, acc::max_element(buffer.begin(), middle, cmp));
+      for (; first != last; ++first) {
+        if (!cmp(*first, middle[-1])) continue;
+        buffer.push_back(*first);
+        if (static_cast<std::ptrdiff_t>(buffer.size()) == 2 * k) {
+          detail::keep_smallest(buffer.begin(), middle, buffer.end(), cmp);
+          buffer.erase(buffer.begin() + k, buffer.end());
+          middle = buffer.begin() + k;
+        }
+      }
+      if (static_cast<std::ptrdiff_t>(buffer.size()) > k) {
+        detail::keep_smallest(buffer.begin(), middle, buffer.end(), cmp);
+      }
+      auto d = std::move(buffer.begin(), middle, d_first);
+      acc::sort(d_first, d, cmp);
+      return d;
+    }
+  }
+
+  template <typename InputIt, typename RandomIt, typename Compare>
+  ACC_CONSTEXPR17 RandomIt partial_sort_copy(
+      InputIt first, InputIt last,
+      RandomIt d_first, RandomIt d_last, Compare cmp)
+  {
+    if (ACC_IS_CONSTANT_EVALUATED()
+        || d_last - d_first < detail::partial_sort_heap_limit) {
+      return detail::heap_select_copy(first, last, d_first, d_last, cmp);
+    }
+    return detail::threshold_select_copy(first, last, d_first, d_last, cmp);
+  }
+
+  template <typename InputIt, typename RandomIt>
+  ACC_CONSTEXPR17 RandomIt partial_sort_copy(
+      InputIt first, InputIt last,
+      RandomIt d_first, RandomIt d_last)
+  {
+    return acc::partial_sort_copy(first, last, d_first, d_last, std::less<>{});
   }
 
 }
@@ -0,0 +1,300 @@
+#pragma once
+
+#include "functional.h"
+#include "monoid.h"
+#include "serialize.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+// ---------------------------------------------------------------------------
+// t_digest
+//
+// An estimate of the quantiles of a stream (the median, the 99th percentile)
+// in memory bounded by the compression Delta, however long the stream. The
+// values are summarized as centroids, each a mean and a weight, kept in
+// order; a centroid may only grow while it covers a small enough range of
+// quantiles, and that range shrinks towards the tails (Dunning's k1 scale
+// function, k(q) = Delta / 2pi * asin(2q - 1)), so that p99 and p999 stay
+// accurate while the middle is summarized coarsely. There are at most about
+// Delta centroids.
+//
+// New values go to a buffer, which is sorted and merged into the centroids
+// when it fills, so that most inserts are an append; insert(first, last)
+// copies into the buffer a block at a time, and compresses what's left at
+// the end. Queries never change the digest: after single inserts that left
+// values in the buffer, they compress a copy.
+//
+// merge pools the centroids of both digests and compresses them, so that the
+// merge of two digests summarizes both streams to the same accuracy; the
+// centroids themselves depend on the order of merges.
+//
+
+namespace acc
+{
+  template <std::size_t Delta = 200>
+  class t_digest
+  {
+    static_assert(Delta >= 10, "t_digest compression must be at least 10");
+
+  public:
+    static constexpr std::size_t compression = Delta;
+
+    t_digest() = default;
+
+    void insert(double x)
+    {
+      add(x);
+      if (buffer_.size() == buffer_limit) compress();
+    }
+
+    template <typename InputIt>
+    void insert(InputIt first, InputIt last)
+    {
+      while (first != last) {
+        buffer_.reserve(buffer_limit);
+        for (auto n = buffer_limit - buffer_.size(); n > 0 && first != last;
+             --n, ++first) {
+          add(static_cast<double>(*first));
+        }
+        if (buffer_.size() == buffer_limit) compress();
+      }
+      compress();
+    }
+
+    void merge(const t_digest& other)
+    {
+      // other's centroids and buffer, as they are, go into this buffer
+      weight_ += other.weight_;
+      min_ = std::min(min_, other.min_);
+      max_ = std::max(max_, other.max_);
+      buffer_.insert(buffer_.end(), other.centroids_.cbegin(), other.centroids_.cend());
+      buffer_.insert(buffer_.end(), other.buffer_.cbegin(), other.buffer_.cend());
+      compress();
+    }
+
+    // the value at quantile q in [0, 1], interpolated between centroids; 0 if
+    // the digest is empty
+    double quantile(double q) const
+    {
+      t_digest scratch;
+      const auto& c = compressed(scratch).centroids_;
+      if (c.empty()) return 0;
+      if (c.size() == 1) return c[0].mean;
+      auto n = weight_;
+      auto index = std::min(std::max(q, 0.0), 1.0) * n;
+      if (index < 1) return min_;
+      if (index > n - 1) return max_;
+
+      // between the minimum and the middle of the first centroid
+      if (c[0].weight > 1 && index < c[0].weight / 2) {
+        return min_ + (index - 1) / (c[0].weight / 2 - 1) * (c[0].mean - min_);
+      }
+      // between the middles of two centroids, where a singleton stands for
+      // exactly its value
+      auto w = c[0].weight / 2;
+      for (std::size_t i = 0; i + 1 < c.size(); ++i) {
+        auto dw = (c[i].weight + c[i+1].weight) / 2;
+        if (w + dw > index) {
+          double left = 0, right = 0;
+          if (c[i].weight == 1) {
+            if (index - w < 0.5) return c[i].mean;
+            left = 0.5;
+          }
+          if (c[i+1].weight == 1) {
+            if (w + dw - index <= 0.5) return c[i+1].mean;
+            right = 0.5;
+          }
+          auto z1 = index - w - left;
+          auto z2 = w + dw - index - right;
+          return (c[i].mean * z2 + c[i+1].mean * z1) / (z1 + z2);
+        }
+        w += dw;
+      }
+      // between the middle of the last centroid and the maximum
+      const auto& b = c.back();
+      if (b.weight > 1 && n - index <= b.weight / 2) {
+        return max_ - (n - index - 1) / (b.weight / 2 - 1) * (max_ - b.mean);
+      }
+      return max_;
+    }
+
+    // the number of values inserted, and the least and greatest of them
+    std::uint64_t count() const { return static_cast<std::uint64_t>(weight_); }
+    double min() const { return min_; }
+    double max() const { return max_; }
+
+    bool empty() const { return centroids_.empty() && buffer_.empty(); }
+
+    // the number of centroids kept
+    std::size_t size() const
+    {
+      t_digest scratch;
+      return compressed(scratch).centroids_.size();
+    }
+
+    friend bool operator==(const t_digest& a, const t_digest& b)
+    {
+      t_digest sa, sb;
+      const auto& ca = a.compressed(sa).centroids_;
+      const auto& cb = b.compressed(sb).centroids_;
+      return a.weight_ == b.weight_ && a.min_ == b.min_ && a.max_ == b.max_
+        && ca == cb;
+    }
+
+    friend bool operator!=(const t_digest& a, const t_digest& b)
+    {
+      return !(a == b);
+    }
+
+  private:
+    friend struct serializer<t_digest>;
+
+    struct centroid
+    {
+      double mean;
+      double weight;
+
+      friend bool operator==(const centroid& a, const centroid& b)
+      {
+        return a.mean == b.mean && a.weight == b.weight;
+      }
+    };
+
+    static constexpr std::size_t buffer_limit = 5 * Delta;
+    static constexpr double pi = 3.14159265358979323846;
+
+    // the scale function and its inverse
+    static double k_of(double q)
+    {
+      return Delta / (2 * pi) * std::asin(2 * q - 1);
+    }
+    static double q_of(double k)
+    {
+      return k >= Delta / 4.0 ? 1 : (std::sin(k * (2 * pi) / Delta) + 1) / 2;
+    }
+
+    // a value into the buffer; the count and the extremes include the buffer
+    void add(double x)
+    {
+      buffer_.push_back(centroid{ x, 1 });
+      weight_ += 1;
+      min_ = std::min(min_, x);
+      max_ = std::max(max_, x);
+    }
+
+    // this digest if its buffer is empty, or else scratch, made a compressed
+    // copy of it
+    const t_digest& compressed(t_digest& scratch) const
+    {
+      if (buffer_.empty()) return *this;
+      scratch = *this;
+      scratch.compress();
+      return scratch;
+    }
+
+    // sort the buffer in with the centroids, and merge neighbours while each
+    // stays within one unit of k
+    void compress()
+    {
+      if (buffer_.empty()) return;
+      auto& c = buffer_;
+      c.insert(c.end(), centroids_.cbegin(), centroids_.cend());
+      std::sort(c.begin(), c.end(),
+                [] (const centroid& a, const centroid& b) { return a.mean < b.mean; });
+
+      centroids_.clear();
+      auto cur = c.front();
+      double w = 0;
+      auto limit = weight_ * q_of(k_of(0) + 1);
+      for (auto it = std::next(c.cbegin()); it != c.cend(); ++it) {
+        if (w + cur.weight + it->weight <= limit) {
+          cur.weight += it->weight;
+          cur.mean += (it->mean - cur.mean) * it->weight / cur.weight;
+        } else {
+          w += cur.weight;
+          centroids_.push_back(cur);
+          limit = weight_ * q_of(k_of(w / weight_) + 1);
+          cur = *it;
+        }
+      }
+      centroids_.push_back(cur);
+      c.clear();
+    }
+
+    std::vector<centroid> centroids_;
+    std::vector<centroid> buffer_;
+    double weight_ = 0;
+    double min_ = std::numeric_limits<double>::max();
+    double max_ = std::numeric_limits<double>::lowest();
+  };
+
+  // ---------------------------------------------------------------------------
+  // the merge monoid
+
+  template <std::size_t Delta>
+  struct monoid<merge_op, t_digest<Delta>>
+    : detail::commutative_monoid<t_digest<Delta>>
+  {
+    static constexpr bool has_absorbing = false;
+    static t_digest<Delta> identity() { return {}; }
+  };
+
+  // ---------------------------------------------------------------------------
+  // serialization: the least and greatest values, then the centroids
+
+  template <std::size_t Delta>
+  struct serializer<t_digest<Delta>>
+  {
+    using S = t_digest<Delta>;
+
+    static void save(std::vector<char>& out, const S& s)
+    {
+      S scratch;
+      const auto& centroids = s.compressed(scratch).centroids_;
+      acc::save(out, s.min_);
+      acc::save(out, s.max_);
+      detail::save_varint(out, centroids.size());
+      for (const auto& c : centroids) {
+        acc::save(out, c.mean);
+        detail::save_varint(out, static_cast<std::uint64_t>(c.weight));
+      }
+    }
+
+    static S load(const char*& p, const char* end)
+    {
+      S s;
+      s.min_ = acc::load<double>(p, end);
+      s.max_ = acc::load<double>(p, end);
+      auto n = detail::load_varint(p, end);
+      if (n > 2 * Delta) bad();
+      for (std::uint64_t i = 0; i < n; ++i) {
+        auto mean = acc::load<double>(p, end);
+        auto weight = detail::load_varint(p, end);
+        if (weight == 0 || !(s.min_ <= mean && mean <= s.max_)
+            || (!s.centroids_.empty() && mean < s.centroids_.back().mean)) {
+          bad();
+        }
+        s.centroids_.push_back({ mean, static_cast<double>(weight) });
+        s.weight_ += static_cast<double>(weight);
+      }
+      if (n == 0) {
+        s.min_ = std::numeric_limits<double>::max();
+        s.max_ = std::numeric_limits<double>::lowest();
+      }
+      return s;
+    }
+
+    [[noreturn]] static void bad()
+    {
+      throw std::runtime_error("acc::load: bad t_digest");
+    }
+  };
+
+}
@@ -0,0 +1,290 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// ---------------------------------------------------------------------------
+// thread_pool, task_group and fork_join
+//
+// A work-stealing pool for the parallel algorithms. Each worker owns a deque
+// of tasks: it pushes and pops at the back, so it works depth-first on what
+// it spawned most recently, and when its deque is empty it steals from the
+// front of the others', taking the oldest (and typically largest) task.
+// Threads outside the pool spawn into a queue of their own, which the
+// workers steal from in the same way.
+//
+// task_group is the fork-join interface: spawn(f) queues f, and sync() waits
+// for everything the group spawned. A thread waiting in sync() runs queued
+// tasks rather than blocking, and a parallel algorithm called from inside a
+// task spawns onto the same pool, so nested parallelism never adds threads.
+//
+
+namespace acc
+{
+  class thread_pool;
+
+  namespace detail
+  {
+    struct task
+    {
+      virtual ~task() = default;
+      virtual void run() = 0;
+    };
+
+    template <typename F>
+    struct task_impl : task
+    {
+      explicit task_impl(F f_) : f(std::move(f_)) {}
+      void run() override { f(); }
+      F f;
+    };
+
+    // -------------------------------------------------------------------------
+    // a worker's deque: guarded by a mutex, which is uncontended except
+    // while a thief is stealing from it
+
+    class task_queue
+    {
+    public:
+      void push(std::unique_ptr<task> t)
+      {
+        std::lock_guard<std::mutex> l(m);
+        q.push_back(std::move(t));
+      }
+
+      std::unique_ptr<task> pop()
+      {
+        std::lock_guard<std::mutex> l(m);
+        if (q.empty()) return nullptr;
+        auto t = std::move(q.back());
+        q.pop_back();
+        return t;
+      }
+
+      std::unique_ptr<task> steal()
+      {
+        std::lock_guard<std::mutex> l(m);
+        if (q.empty()) return nullptr;
+        auto t = std::move(q.front());
+        q.pop_front();
+        return t;
+      }
+
+    private:
+      std::mutex m;
+      std::deque<std::unique_ptr<task>> q;
+    };
+
+    // -------------------------------------------------------------------------
+    // which pool, and which of its deques, the current thread works from
+
+    struct worker_id
+    {
+      const thread_pool* pool;
+      std::size_t index;
+    };
+
+    inline worker_id& this_worker()
+    {
+      static thread_local worker_id w{ nullptr, 0 };
+      return w;
+    }
+  }
+
+  // ---------------------------------------------------------------------------
+  // thread_pool
+
+  class thread_pool
+  {
+  public:
+    // threads == 0 means one worker per hardware thread, less one for the
+    // thread that spawns work and helps with it while it waits
+    explicit thread_pool(std::size_t threads = 0)
+      : queues_(workers(threads) + 1)
+    {
+      auto n = queues_.size() - 1;
+      threads_.reserve(n);
+      for (std::size_t i = 0; i < n; ++i) {
+        threads_.emplace_back([this, i] { work(i); });
+      }
+    }
+
+    ~thread_pool()
+    {
+      {
+        std::lock_guard<std::mutex> l(m_);
+        stop_ = true;
+      }
+      cv_.notify_all();
+      for (auto& t : threads_) t.join();
+    }
+
+    thread_pool(const thread_pool&) = delete;
+    thread_pool& operator=(const thread_pool&) = delete;
+
+    std::size_t size() const { return threads_.size(); }
+
+    // the pool that the parallel algorithms run on
+    static thread_pool& shared()
+    {
+      static thread_pool pool;
+      return pool;
+    }
+
+    // queue f to run on some thread of the pool
+    template <typename F>
+    void submit(F&& f)
+    {
+      using TI = detail::task_impl<std::decay_t<F>>;
+      push(std::make_unique<TI>(std::forward<F>(f)));
+    }
+
+    // run one queued task on the calling thread, if there is one
+    bool run_one()
+    {
+      auto t = take(home());
+      if (!t) return false;
+      t->run();
+      return true;
+    }
+
+  private:
+    static std::size_t workers(std::size_t threads)
+    {
+      if (threads != 0) return threads;
+      auto n = std::thread::hardware_concurrency();
+      return n > 1 ? n - 1 : 1;
+    }
+
+    // a worker's own deque, or the last one, shared by outside threads
+    std::size_t home() const
+    {
+      const auto& w = detail::this_worker();
+      return w.pool == this ? w.index : queues_.size() - 1;
+    }
+
+    void push(std::unique_ptr<detail::task> t)
+    {
+      queues_[home()].push(std::move(t));
+      queued_.fetch_add(1);
+      if (idle_.load() > 0) {
+        std::lock_guard<std::mutex> l(m_);
+        cv_.notify_one();
+      }
+    }
+
+    // the newest task from our own deque, else the oldest from another
+    std::unique_ptr<detail::task> take(std::size_t i)
+    {
+      auto n = queues_.size();
+      auto t = queues_[i].pop();
+      for (std::size_t k = 1; !t && k < n; ++k) {
+        t = queues_[(i + k) % n].steal();
+      }
+      if (t) queued_.fetch_sub(1);
+      return t;
+    }
+
+    void work(std::size_t i)
+    {
+      detail::this_worker() = { this, i };
+      for (;;) {
+        if (auto t = take(i)) {
+          t->run();
+          continue;
+        }
+        std::unique_lock<std::mutex> l(m_);
+        idle_.fetch_add(1);
+        cv_.wait(l, [this] { return stop_ || queued_.load() > 0; });
+        idle_.fetch_sub(1);
+        if (stop_ && queued_.load() == 0) return;
+      }
+    }
+
+    std::vector<detail::task_queue> queues_;
+    std::vector<std::thread> threads_;
+    std::mutex m_;
+    std::condition_variable cv_;
+    std::atomic<std::size_t> queued_{0};
+    std::atomic<std::size_t> idle_{0};
+    bool stop_ = false;
+  };
+
+  // ---------------------------------------------------------------------------
+  // task_group: spawn tasks, then sync to wait for all of them. The first
+  // exception thrown by a task is rethrown from sync.
+
+  class task_group
+  {
+  public:
+    explicit task_group(thread_pool& pool = thread_pool::shared())
+      : pool_(pool)
+    {}
+
+    ~task_group() { wait(); }
+
+    task_group(const task_group&) = delete;
+    task_group& operator=(const task_group&) = delete;
+
+    template <typename F>
+    void spawn(F f)
+    {
+      pending_.fetch_add(1, std::memory_order_relaxed);
+      pool_.submit([this, f = std::move(f)] () mutable {
+          try {
+            f();
+          } catch (...) {
+            std::lock_guard<std::mutex> l(m_);
+            if (!error_) error_ = std::current_exception();
+          }
+          pending_.fetch_sub(1, std::memory_order_release);
+        });
+    }
+
+    void sync()
+    {
+      wait();
+      if (error_) {
+        auto e = std::move(error_);
+        error_ = nullptr;
+        std::rethrow_exception(e);
+      }
+    }
+
+  private:
+    // help with queued work until our own tasks are done
+    void wait()
+    {
+      while (pending_.load(std::memory_order_acquire) != 0) {
+        if (!pool_.run_one()) std::this_thread::yield();
+      }
+    }
+
+    thread_pool& pool_;
+    std::atomic<std::size_t> pending_{0};
+    std::mutex m_;
+    std::exception_ptr error_;
+  };
+
+  // ---------------------------------------------------------------------------
+  // fork_join: run a as a task and b on the calling thread, and wait for both
+
+  template <typename F, typename G>
+  inline void fork_join(F a, G b, thread_pool& pool = thread_pool::shared())
+  {
+    task_group g(pool);
+    g.spawn(std::move(a));
+    b();
+    g.sync();
+  }
+
+}
@@ -0,0 +1,197 @@
+#pragma once
+
+#include "functional.h"
+#include "heap_ops.h"
+#include "monoid.h"
+#include "serialize.h"
+#include "simd.h"
+#include "sorting_ops.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// ---------------------------------------------------------------------------
+// top_n
+//
+// The N greatest values of a stream by Compare (the N least, with
+// std::greater<>), in O(N) memory however long the stream. The values are
+// kept in a heap with the least of them at the front, which is the
+// threshold: once N values are kept, a value that doesn't beat it is
+// rejected with one comparison, and one that does replaces it.
+//
+// insert(first, last) over a contiguous range of arithmetic values, with
+// std::less or std::greater, scans a block at a time for values that beat the
+// threshold, in a loop that vectorizes, and only inserts from blocks that
+// have some. Late in a long stream almost every block is skipped.
+//
+// merge keeps the N greatest of both, in O(N): the two heaps are put
+// together, the N greatest selected with nth_element, and the heap rebuilt.
+// Which of two equivalent values is kept is unspecified.
+//
+
+namespace acc
+{
+  template <typename T, std::size_t N, typename Compare = std::less<>>
+  class top_n
+  {
+    static_assert(N > 0, "top_n keeps at least one value");
+
+  public:
+    using value_type = T;
+    static constexpr std::size_t capacity = N;
+
+    top_n() { heap_.reserve(N); }
+    explicit top_n(Compare cmp) : cmp_(std::move(cmp)) { heap_.reserve(N); }
+
+    template <typename U>
+    void insert(U&& x)
+    {
+      if (heap_.size() < N) {
+        heap_.push_back(std::forward<U>(x));
+        acc::push_heap(heap_.begin(), heap_.end(), heap_cmp());
+      } else if (cmp_(heap_.front(), x)) {
+        heap_.front() = std::forward<U>(x);
+        auto c = heap_cmp();
+        detail::sift_down(heap_.begin(), heap_.end() - heap_.begin(),
+                          std::ptrdiff_t{0}, c);
+      }
+    }
+
+    template <typename InputIt>
+    void insert(InputIt first, InputIt last)
+    {
+      insert_range(first, last, threshold_scan<InputIt>{});
+    }
+
+    void merge(const top_n& other)
+    {
+      heap_.insert(heap_.end(), other.heap_.cbegin(), other.heap_.cend());
+      if (heap_.size() > N) {
+        acc::nth_element(heap_.begin(), heap_.begin() + (N - 1), heap_.end(),
+                         heap_cmp());
+        heap_.resize(N);
+      }
+      acc::make_heap(heap_.begin(), heap_.end(), heap_cmp());
+    }
+
+    // the values kept, greatest first
+    std::vector<T> values() const
+    {
+      auto v = heap_;
+      acc::sort_heap(v.begin(), v.end(), heap_cmp());
+      return v;
+    }
+
+    // the least value kept: once full, only values that beat it get in
+    const T& threshold() const { return heap_.front(); }
+
+    std::size_t size() const { return heap_.size(); }
+    bool empty() const { return heap_.empty(); }
+    bool full() const { return heap_.size() == N; }
+
+    friend bool operator==(const top_n& a, const top_n& b)
+    {
+      return a.values() == b.values();
+    }
+
+    friend bool operator!=(const top_n& a, const top_n& b)
+    {
+      return !(a == b);
+    }
+
+  private:
+    friend struct serializer<top_n>;
+
+    static constexpr std::size_t block = 64;
+
+    // the heap keeps the least value at the front
+    struct inverse
+    {
+      const Compare& cmp;
+      template <typename A, typename B>
+      bool operator()(const A& a, const B& b) const { return cmp(b, a); }
+    };
+
+    inverse heap_cmp() const { return inverse{ cmp_ }; }
+
+    // a contiguous range of arithmetic values, with a comparison the scan
+    // can inline
+    template <typename It>
+    using threshold_scan = std::integral_constant<
+      bool,
+      simd::is_contiguous<It>::value
+      && std::is_arithmetic<T>::value
+      && std::is_same<typename std::iterator_traits<It>::value_type, T>::value
+      && (is_op<std::less, Compare, T>::value
+          || is_op<std::greater, Compare, T>::value)>;
+
+    template <typename InputIt>
+    void insert_range(InputIt first, InputIt last, std::false_type)
+    {
+      for (; first != last; ++first) insert(*first);
+    }
+
+    template <typename ContiguousIt>
+    void insert_range(ContiguousIt first, ContiguousIt last, std::true_type)
+    {
+      auto p = simd::to_pointer(first);
+      auto n = static_cast<std::size_t>(last - first);
+      std::size_t i = 0;
+      for (; i < n && !full(); ++i) insert(p[i]);
+      for (; i < n; i += block) {
+        auto m = std::min(std::size_t{block}, n - i);
+        auto t = heap_.front();
+        std::size_t hits = 0;
+        for (std::size_t k = 0; k < m; ++k) hits += cmp_(t, p[i + k]);
+        if (hits == 0) continue;
+        for (std::size_t k = 0; k < m; ++k) insert(p[i + k]);
+      }
+    }
+
+    std::vector<T> heap_;
+    Compare cmp_;
+  };
+
+  // ---------------------------------------------------------------------------
+  // the merge monoid
+
+  template <typename T, std::size_t N, typename Compare>
+  struct monoid<merge_op, top_n<T, N, Compare>>
+    : detail::commutative_monoid<top_n<T, N, Compare>>
+  {
+    static constexpr bool has_absorbing = false;
+    static top_n<T, N, Compare> identity() { return {}; }
+  };
+
+  // ---------------------------------------------------------------------------
+  // serialization: the values kept
+
+  template <typename T, std::size_t N, typename Compare>
+  struct serializer<top_n<T, N, Compare>>
+  {
+    using S = top_n<T, N, Compare>;
+
+    static void save(std::vector<char>& out, const S& s)
+    {
+      acc::save(out, s.heap_);
+    }
+
+    static S load(const char*& p, const char* end)
+    {
+      S s;
+      s.heap_ = acc::load<std::vector<T>>(p, end);
+      if (s.heap_.size() > N) {
+        throw std::runtime_error("acc::load: bad top_n");
+      }
+      acc::make_heap(s.heap_.begin(), s.heap_.end(), s.heap_cmp());
+      return s;
+    }
+  };
+
+}
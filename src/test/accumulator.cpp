@@ -0,0 +1,67 @@
+#include <all.h>
+
+#include <testinator.h>
+
+#include <functional>
+#include <numeric>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// ---------------------------------------------------------------------------
+// accumulator
+
+DEF_PROPERTY(Push, Accumulator, const vector<unsigned int>& v)
+{
+  acc::accumulator<unsigned int> a;
+  for (auto i : v) a.push(i);
+  return a.value() == accumulate(v.cbegin(), v.cend(), 0u);
+}
+
+DEF_PROPERTY(PushBatches, Accumulator, const vector<unsigned int>& v, unsigned int n)
+{
+  // the same values, in batches of n + 1
+  acc::accumulator<unsigned int, acc::maximum<>> a;
+  auto step = static_cast<ptrdiff_t>(n % 16 + 1);
+  for (auto i = v.cbegin(); i != v.cend(); ) {
+    auto j = v.cend() - i > step ? i + step : v.cend();
+    a.push(i, j);
+    i = j;
+  }
+  auto m = v.empty() ? 0u : *max_element(v.cbegin(), v.cend());
+  return a.value() == m;
+}
+
+DEF_PROPERTY(Merge, Accumulator, const vector<unsigned int>& v)
+{
+  // string concatenation: merge must keep the order
+  auto a = acc::make_accumulator(string{}, plus<>());
+  auto b = acc::make_accumulator(string{}, plus<>());
+  string expected;
+  auto mid = v.cbegin() + static_cast<ptrdiff_t>(v.size() / 2);
+  for (auto i = v.cbegin(); i != v.cend(); ++i) {
+    auto s = to_string(*i) + ',';
+    expected += s;
+    (i < mid ? a : b).push(s);
+  }
+  a.merge(std::move(b));
+  return a.value() == expected;
+}
+
+DEF_PROPERTY(MergeThreads, Accumulator, const vector<unsigned int>& v)
+{
+  vector<acc::accumulator<unsigned int>> parts(4);
+  vector<thread> threads;
+  auto n = v.size();
+  for (size_t t = 0; t < parts.size(); ++t) {
+    threads.emplace_back([&, t] {
+        parts[t].push(v.cbegin() + static_cast<ptrdiff_t>(n * t / 4),
+                      v.cbegin() + static_cast<ptrdiff_t>(n * (t+1) / 4));
+      });
+  }
+  for (auto& t : threads) t.join();
+  for (size_t t = 1; t < parts.size(); ++t) parts[0].merge(parts[t]);
+  return parts[0].value() == accumulate(v.cbegin(), v.cend(), 0u);
+}
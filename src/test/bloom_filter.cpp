@@ -0,0 +1,132 @@
+#include <all.h>
+
+#include <testinator.h>
+
+#include "shards.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <numeric>
+#include <vector>
+
+using namespace std;
+
+// ---------------------------------------------------------------------------
+// bloom_filter
+
+namespace
+{
+  using bloom = acc::bloom_filter<1 << 16>;
+
+  template <typename F = bloom>
+  F filter(const vector<unsigned int>& v)
+  {
+    F f;
+    f.insert(v.cbegin(), v.cend());
+    return f;
+  }
+}
+
+DEF_PROPERTY(NoFalseNegatives, BloomFilter, const vector<unsigned int>& v)
+{
+  auto f = filter(v);
+  return all_of(v.cbegin(), v.cend(),
+                [&] (unsigned int x) { return f.contains(x); });
+}
+
+DEF_PROPERTY(Batch, BloomFilter, const vector<unsigned int>& v)
+{
+  // the batch paths agree with one value at a time
+  auto mid = v.cbegin() + static_cast<ptrdiff_t>(v.size() / 2);
+  bloom f;
+  for (auto i = v.cbegin(); i != mid; ++i) f.insert(*i);
+  auto g = acc::accumulate(v.cbegin(), mid, bloom{}, acc::insert_op{});
+
+  vector<bool> expected, batch;
+  for (auto x : v) expected.push_back(f.contains(x));
+  f.contains(v.cbegin(), v.cend(), back_inserter(batch));
+  return f == g && f == filter(vector<unsigned int>(v.cbegin(), mid))
+    && batch == expected;
+}
+
+DEF_TEST(FalsePositives, BloomFilter)
+{
+  // 10 bits a value
+  vector<unsigned int> v(100000);
+  iota(v.begin(), v.end(), 0u);
+  auto f = filter<acc::bloom_filter<1000192>>(v);
+  vector<unsigned int> w(100000);
+  iota(w.begin(), w.end(), 1u << 30);
+  vector<bool> r;
+  f.contains(w.cbegin(), w.cend(), back_inserter(r));
+  auto fp = count(r.cbegin(), r.cend(), true);
+  return fp < 2000;
+}
+
+DEF_PROPERTY(Merge, BloomFilter, const vector<unsigned int>& v)
+{
+  auto mid = v.cbegin() + static_cast<ptrdiff_t>(v.size() / 3);
+  bloom a, b;
+  a.insert(v.cbegin(), mid);
+  b.insert(mid, v.cend());
+  auto c = a;
+  c.merge(b);
+  auto m = test::merge(test::sharded(v.cbegin(), v.cend(), 3, bloom{}));
+  return c == filter(v) && m.reduced == c && m.accumulated == c;
+}
+
+DEF_PROPERTY(Copy, BloomFilter, const vector<unsigned int>& v)
+{
+  // copies are independent, whatever their alignment
+  auto f = filter(v);
+  vector<bloom> copies(3, f);
+  copies[1].insert(12345u);
+  bloom g;
+  g = copies[1];
+  return copies[0] == f && copies[2] == f && g == copies[1] && g.contains(12345u);
+}
+
+DEF_PROPERTY(AssignMovedFrom, BloomFilter, const vector<unsigned int>& v)
+{
+  // a moved-from filter can be assigned to, by copy or by move
+  auto f = filter(v);
+  auto g = f;
+  bloom h{std::move(g)};
+  g = f;
+  bloom i{std::move(h)};
+  h = filter(v);
+  return g == f && h == f && i == f;
+}
+
+DEF_PROPERTY(SaveLoad, BloomFilter, const vector<unsigned int>& v)
+{
+  auto f = filter(v);
+  vector<char> out;
+  acc::save(out, f);
+  const char* p = out.data();
+  auto g = acc::load<bloom>(p, p + out.size());
+  return g == f && out.size() == bloom::bits / 8;
+}
+
+DEF_PROPERTY(JoinPrefilter, BloomFilter, const vector<unsigned int>& u, const vector<unsigned int>& w)
+{
+  // filter one side by the other's keys before intersecting
+  vector<unsigned int> a(u), b(w);
+  for (auto& x : b) x %= 64;
+  sort(a.begin(), a.end());
+  sort(b.begin(), b.end());
+
+  auto f = filter(b);
+  vector<unsigned int> candidates;
+  acc::copy_if(a.cbegin(), a.cend(), back_inserter(candidates),
+               [&] (unsigned int x) { return f.contains(x); });
+
+  vector<unsigned int> x, y;
+  acc::set_intersection(a.cbegin(), a.cend(), b.cbegin(), b.cend(),
+                        back_inserter(x), less<>());
+  acc::set_intersection(candidates.cbegin(), candidates.cend(),
+                        b.cbegin(), b.cend(), back_inserter(y), less<>());
+  return x == y;
+}
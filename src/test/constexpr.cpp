@@ -0,0 +1,148 @@
+#include <all.h>
+
+#include <testinator.h>
+
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <numeric>
+#include <vector>
+
+using namespace std;
+
+// ---------------------------------------------------------------------------
+// constant evaluation
+//
+// Under C++17 the folds and the algorithms that neither swap nor carry a
+// std::pair are constant expressions; under C++20 the rest are too. Each
+// check is a static_assert, so a regression fails the build.
+
+namespace
+{
+  template <typename T, size_t N>
+  constexpr bool array_equal(const array<T, N>& a, const array<T, N>& b)
+  {
+    for (size_t i = 0; i < N; ++i) {
+      if (!(a[i] == b[i])) return false;
+    }
+    return true;
+  }
+
+#if __cplusplus >= 201703L
+  constexpr array<int, 8> squares()
+  {
+    array<int, 8> a{};
+    acc::iota(a.begin(), a.end(), 0);
+    acc::transform(a.cbegin(), a.cend(), a.begin(),
+                   [] (int x) { return x * x; });
+    return a;
+  }
+
+  constexpr array<int, 8> prefix_sums()
+  {
+    auto a = squares();
+    array<int, 8> s{};
+    acc::partial_sum(a.cbegin(), a.cend(), s.begin(), plus<>{});
+    return s;
+  }
+
+  // fnv-1a, e.g. for a perfect hash seed
+  constexpr unsigned int fnv1a(const char* s, size_t n)
+  {
+    return acc::accumulate(s, s + n, 2166136261u,
+                           [] (unsigned int h, char c) {
+                             return (h ^ static_cast<unsigned char>(c)) * 16777619u;
+                           });
+  }
+
+  constexpr array<int, 8> sq = squares();
+
+  static_assert(acc::accumulate(sq.cbegin(), sq.cend(), 0, plus<>{}) == 140, "");
+  static_assert(acc::accumulate(sq.cbegin(), sq.cend(), 1, multiplies<>{}) == 0, "");
+  static_assert(acc::reduce(sq.cbegin(), sq.cend(), 0, plus<>{}) == 140, "");
+  static_assert(acc::inner_product(sq.cbegin(), sq.cend(), sq.cbegin(), 0,
+                                    plus<>{}, multiplies<>{}) == 4676, "");
+  static_assert(array_equal(prefix_sums(),
+                            array<int, 8>{{0, 1, 5, 14, 30, 55, 91, 140}}), "");
+  static_assert(fnv1a("acc", 3) == 0x424a669au, "");
+
+  static_assert(*acc::find(sq.cbegin(), sq.cend(), 25) == 25, "");
+  static_assert(acc::count_if(sq.cbegin(), sq.cend(),
+                              [] (int x) { return x % 2 == 0; }) == 4, "");
+  static_assert(acc::all_of(sq.cbegin(), sq.cend(),
+                            [] (int x) { return x >= 0; }), "");
+  static_assert(*acc::max_element(sq.cbegin(), sq.cend(), less<>{}) == 49, "");
+  static_assert(acc::is_partitioned(sq.cbegin(), sq.cend(),
+                                    [] (int x) { return x < 10; }), "");
+#endif
+
+#if __cplusplus >= 202002L
+  constexpr array<int, 8> sorted(array<int, 8> a)
+  {
+    acc::sort(a.begin(), a.end());
+    return a;
+  }
+
+  constexpr array<int, 8> reversed(array<int, 8> a)
+  {
+    acc::reverse(a.begin(), a.end());
+    return a;
+  }
+
+  constexpr int median(array<int, 8> a)
+  {
+    acc::nth_element(a.begin(), a.begin() + 4, a.end());
+    return a[4];
+  }
+
+  constexpr array<int, 3> smallest3(array<int, 8> a)
+  {
+    acc::partial_sort(a.begin(), a.begin() + 3, a.end());
+    return {{a[0], a[1], a[2]}};
+  }
+
+  // longer than one run, so that it merges (by rotation, at compile time)
+  constexpr bool stable_sorts()
+  {
+    array<int, 80> a{};
+    for (size_t i = 0; i < a.size(); ++i) a[i] = static_cast<int>(i * 37 % 80);
+    acc::stable_sort(a.begin(), a.end());
+    for (size_t i = 0; i < a.size(); ++i) {
+      if (a[i] != static_cast<int>(i)) return false;
+    }
+    return true;
+  }
+
+  constexpr array<int, 8> shuffled{{3, 7, 0, 5, 1, 6, 2, 4}};
+
+  static_assert(array_equal(sorted(shuffled),
+                            array<int, 8>{{0, 1, 2, 3, 4, 5, 6, 7}}), "");
+  static_assert(array_equal(reversed(sorted(shuffled)),
+                            array<int, 8>{{7, 6, 5, 4, 3, 2, 1, 0}}), "");
+  static_assert(median(shuffled) == 4, "");
+  static_assert(stable_sorts(), "");
+  static_assert(array_equal(smallest3(shuffled), array<int, 3>{{0, 1, 2}}), "");
+  static_assert(acc::is_sorted(sq.cbegin(), sq.cend(), less<>{}), "");
+  static_assert(acc::equal(sq.cbegin(), sq.cend(), squares().cbegin(),
+                           equal_to<>{}), "");
+  static_assert(*acc::mismatch(sq.cbegin(), sq.cend(), shuffled.cbegin(),
+                               equal_to<>{}).first == 0, "");
+#endif
+}
+
+DEF_TEST(Tables, Constexpr)
+{
+  // the same computations at run time agree with the standard library
+  array<int, 8> a{};
+  iota(a.begin(), a.end(), 0);
+  for (auto& x : a) x *= x;
+  array<int, 8> s{};
+  partial_sum(a.cbegin(), a.cend(), s.begin());
+
+  array<int, 8> b{};
+  acc::iota(b.begin(), b.end(), 0);
+  acc::transform(b.cbegin(), b.cend(), b.begin(), [] (int x) { return x * x; });
+  array<int, 8> t{};
+  acc::partial_sum(b.cbegin(), b.cend(), t.begin(), plus<>{});
+  return array_equal(a, b) && array_equal(s, t);
+}
@@ -0,0 +1,150 @@
+#include <all.h>
+
+#include <testinator.h>
+
+#include "shards.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <stdexcept>
+#include <vector>
+
+using namespace std;
+
+// ---------------------------------------------------------------------------
+// count_min_sketch
+
+namespace
+{
+  using cms = acc::count_min_sketch<256, 4>;
+  using conservative = acc::conservative_count_min_sketch<256, 4>;
+
+  template <typename S>
+  S sketch(const vector<unsigned int>& v)
+  {
+    S s;
+    s.insert(v.cbegin(), v.cend());
+    return s;
+  }
+
+  map<unsigned int, size_t> counts(const vector<unsigned int>& v)
+  {
+    map<unsigned int, size_t> m;
+    for (auto x : v) ++m[x];
+    return m;
+  }
+
+  // a skewed stream: key k appears about n / (k + 1) times
+  vector<unsigned int> skewed(unsigned int keys, unsigned int n)
+  {
+    vector<unsigned int> v;
+    for (unsigned int k = 0; k < keys; ++k) {
+      v.insert(v.end(), n / (k + 1) + 1, k);
+    }
+    return v;
+  }
+}
+
+DEF_PROPERTY(NeverUnder, CountMinSketch, const vector<unsigned int>& v)
+{
+  auto s = sketch<cms>(v);
+  auto c = sketch<conservative>(v);
+  for (const auto& kv : counts(v)) {
+    auto e = s.estimate(kv.first);
+    auto f = c.estimate(kv.first);
+    if (f < kv.second || e < f) return false;
+  }
+  return s.total() == v.size() && c.total() == v.size();
+}
+
+DEF_PROPERTY(Batch, CountMinSketch, const vector<unsigned int>& v)
+{
+  cms a;
+  conservative b;
+  for (auto x : v) {
+    a.insert(x);
+    b.insert(x);
+  }
+  auto c = acc::accumulate(v.cbegin(), v.cend(), cms{}, acc::insert_op{});
+  return a == sketch<cms>(v) && b == sketch<conservative>(v) && a == c;
+}
+
+DEF_PROPERTY(InsertCount, CountMinSketch, const vector<unsigned int>& v)
+{
+  // keys and counts of the same type are a weighted insert, not a range
+  acc::count_min_sketch<1024, 4> s;
+  std::uint64_t total = 0;
+  for (auto x : v) {
+    auto n = std::uint64_t{x % 8 + 1};
+    s.insert(std::uint64_t{x}, n);
+    total += n;
+  }
+  for (auto x : v) {
+    if (s.estimate(std::uint64_t{x}) < x % 8 + 1) return false;
+  }
+  return s.total() == total;
+}
+
+DEF_TEST(ErrorBound, CountMinSketch)
+{
+  acc::count_min_sketch<1024, 5> s;
+  auto v = skewed(5000, 100000);
+  s.insert(v.cbegin(), v.cend());
+  auto m = counts(v);
+  size_t over = 0;
+  for (const auto& kv : m) {
+    if (s.estimate(kv.first) - kv.second > s.error() * double(s.total())) ++over;
+  }
+  // each estimate may exceed the bound with probability e^-5
+  return over <= m.size() / 50 && s.estimate(0u) >= m[0];
+}
+
+DEF_TEST(Conservative, CountMinSketch)
+{
+  // conservative update overestimates less on a skewed stream
+  auto v = skewed(500, 100000);
+  auto s = sketch<cms>(v);
+  auto c = sketch<conservative>(v);
+  size_t es = 0, ec = 0;
+  for (const auto& kv : counts(v)) {
+    es += s.estimate(kv.first) - kv.second;
+    ec += c.estimate(kv.first) - kv.second;
+  }
+  return 4 * ec < 3 * es;
+}
+
+DEF_PROPERTY(Merge, CountMinSketch, const vector<unsigned int>& v)
+{
+  auto mid = v.cbegin() + static_cast<ptrdiff_t>(v.size() / 2);
+  cms a, b;
+  a.insert(v.cbegin(), mid);
+  b.insert(mid, v.cend());
+  a.merge(b);
+  return a == sketch<cms>(v);
+}
+
+DEF_TEST(ParallelReduce, CountMinSketch)
+{
+  auto v = skewed(1000, 20000);
+  auto m = test::merge(test::sharded(v.cbegin(), v.cend(), 8, cms{}));
+  return m.reduced == sketch<cms>(v) && m.accumulated == m.reduced;
+}
+
+DEF_PROPERTY(SaveLoad, CountMinSketch, const vector<unsigned int>& v)
+{
+  auto s = sketch<conservative>(v);
+  vector<char> out;
+  acc::save(out, s);
+  const char* p = out.data();
+  auto t = acc::load<conservative>(p, p + out.size());
+  bool truncated = false;
+  try {
+    p = out.data();
+    acc::load<conservative>(p, p + out.size() - 1);
+  } catch (const runtime_error&) {
+    truncated = true;
+  }
+  return s == t && truncated;
+}
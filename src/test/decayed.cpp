@@ -0,0 +1,159 @@
+#include <all.h>
+
+#include <testinator.h>
+
+#include "shards.h"
+
+#include <cmath>
+#include <cstddef>
+#include <list>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+// ---------------------------------------------------------------------------
+// decayed
+
+namespace
+{
+  using event = pair<double, double>;
+
+  // timestamps jittered around a rising clock, so that some arrive late
+  vector<event> events(const vector<unsigned int>& v)
+  {
+    vector<event> e;
+    for (size_t i = 0; i < v.size(); ++i) {
+      e.emplace_back(static_cast<double>(i) + static_cast<double>(v[i] % 50) - 25.0,
+                     static_cast<double>(v[i] % 1000));
+    }
+    return e;
+  }
+
+  bool close(double a, double b)
+  {
+    return fabs(a - b) <= 1e-9 * (fabs(a) + fabs(b)) + 1e-300;
+  }
+
+  // the decayed count, sum and average, one exp per event
+  bool matches(const acc::decayed& d, const vector<event>& e, double half_life)
+  {
+    if (e.empty()) return d.empty() && d.count(0) == 0 && d.average() == 0;
+    double now = e[0].first;
+    for (const auto& x : e) now = max(now, x.first);
+    double c = 0, s = 0;
+    for (const auto& x : e) {
+      auto w = exp2(-(now - x.first) / half_life);
+      c += w;
+      s += w * x.second;
+    }
+    return d.size() == e.size() && d.time() == now
+      && close(d.count(now), c) && close(d.sum(now), s)
+      && close(d.average(), s / c)
+      && close(d.count(now + half_life), c / 2);
+  }
+}
+
+DEF_TEST(HalfLife, Decayed)
+{
+  acc::decayed d(10);
+  d.insert({ 100, 4 });
+  d.insert({ 90, 2 });
+  return d.count(100) == 1.5 && d.sum(100) == 5 && close(d.count(110), 0.75)
+    && close(d.average(), 5 / 1.5) && close(d.half_life(), 10);
+}
+
+DEF_TEST(MergeIdentity, Decayed)
+{
+  // an empty aggregate keeps its half-life when the identity is merged in
+  acc::decayed d(10);
+  d.merge(acc::decayed{});
+  d.insert({ 0, 1 });
+  d.insert({ 10, 1 });
+  acc::decayed e;
+  e.merge(acc::decayed(10));
+  return d.count(10) == 1.5 && close(d.half_life(), 10)
+    && close(e.half_life(), 10);
+}
+
+DEF_PROPERTY(Insert, Decayed, const vector<unsigned int>& v)
+{
+  auto e = events(v);
+  acc::decayed d(100);
+  for (const auto& x : e) d.insert(x);
+  auto f = acc::accumulate(e.cbegin(), e.cend(), acc::decayed(100), acc::insert_op{});
+  return matches(d, e, 100) && f == d;
+}
+
+DEF_PROPERTY(Batch, Decayed, const vector<unsigned int>& v)
+{
+  // pairs, contiguous arrays (the vectorized exp), and other iterators
+  auto e = events(v);
+  acc::decayed a(100);
+  a.insert(e.cbegin(), e.cend());
+  vector<double> t, x;
+  for (const auto& p : e) {
+    t.push_back(p.first);
+    x.push_back(p.second);
+  }
+  acc::decayed b(100);
+  b.insert(t.cbegin(), t.cend(), x.cbegin());
+  list<double> lt(t.cbegin(), t.cend());
+  acc::decayed c(100);
+  c.insert(lt.cbegin(), lt.cend(), x.cbegin());
+  return matches(a, e, 100) && matches(b, e, 100) && matches(c, e, 100);
+}
+
+DEF_TEST(Exp, Decayed)
+{
+  bool ok = acc::detail::exp_nonpositive(0) == 1
+    && acc::detail::exp_nonpositive(-1000) == 0;
+  // (the release build has fast math, which costs some precision)
+  for (double x = -700; x <= 0; x += 0.0137) {
+    ok = ok && fabs(acc::detail::exp_nonpositive(x) / exp(x) - 1) < 1e-13;
+  }
+  return ok;
+}
+
+DEF_PROPERTY(Merge, Decayed, const vector<unsigned int>& v)
+{
+  // out of order: the later shard is merged into the earlier, and vice versa
+  auto e = events(v);
+  auto mid = e.cbegin() + static_cast<ptrdiff_t>(e.size() / 3);
+  acc::decayed a(50), b(50);
+  a.insert(e.cbegin(), mid);
+  b.insert(mid, e.cend());
+  auto ab = a, ba = b;
+  ab.merge(b);
+  ba.merge(a);
+  acc::decayed i;
+  i.merge(ab);
+  return matches(ab, e, 50) && matches(ba, e, 50) && i == ab;
+}
+
+DEF_TEST(ParallelReduce, Decayed)
+{
+  vector<event> e;
+  for (size_t i = 0; i < 100000; ++i) {
+    e.emplace_back(static_cast<double>(i) * 0.01, static_cast<double>(i % 7));
+  }
+  auto shards = test::sharded(e.cbegin(), e.cend(), 8, acc::decayed(60));
+  auto m = test::merge(shards);
+  // and newest first, so that each merge is of an older aggregate
+  acc::execution::parallel_policy par{ shards.size(), 1 };
+  auto r = acc::reduce(par, shards.crbegin(), shards.crend(),
+                       acc::decayed{}, acc::merge_op{});
+  return matches(m.reduced, e, 60) && matches(m.accumulated, e, 60)
+    && matches(r, e, 60);
+}
+
+DEF_PROPERTY(SaveLoad, Decayed, const vector<unsigned int>& v)
+{
+  auto e = events(v);
+  acc::decayed d(100);
+  d.insert(e.cbegin(), e.cend());
+  vector<char> out;
+  acc::save(out, d);
+  const char* p = out.data();
+  return acc::load<acc::decayed>(p, p + out.size()) == d;
+}
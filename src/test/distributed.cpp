@@ -0,0 +1,136 @@
+#include <all.h>
+
+#include <testinator.h>
+
+#include <functional>
+#include <map>
+#include <numeric>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+// ---------------------------------------------------------------------------
+// serialization
+
+DEF_PROPERTY(SaveLoad, Serialize, const vector<unsigned int>& v)
+{
+  map<string, vector<unsigned int>> m;
+  for (auto i : v) m[to_string(i % 7)].push_back(i);
+  auto x = make_pair(m, string{"tail"});
+
+  vector<char> out;
+  acc::save(out, x);
+  const char* p = out.data();
+  auto y = acc::load<decltype(x)>(p, p + out.size());
+  return x == y && p == out.data() + out.size();
+}
+
+DEF_TEST(LoadTruncated, Serialize)
+{
+  vector<char> out;
+  acc::save(out, string{"truncated"});
+  const char* p = out.data();
+  try {
+    acc::load<string>(p, p + out.size() - 1);
+  } catch (const runtime_error&) {
+    return true;
+  }
+  return false;
+}
+
+// ---------------------------------------------------------------------------
+// fork_reduce
+
+DEF_PROPERTY(ForkReduce, Distributed, const vector<unsigned int>& v)
+{
+  auto x = accumulate(v.cbegin(), v.cend(), 0u);
+  auto y = acc::fork_reduce(4, v.cbegin(), v.cend(), 0u, plus<>());
+  return x == y;
+}
+
+DEF_PROPERTY(ForkReduceOrdered, Distributed, const vector<unsigned int>& v)
+{
+  vector<string> s;
+  for (auto i : v) s.push_back(to_string(i) + ',');
+  auto x = accumulate(s.cbegin(), s.cend(), string{"<"});
+  auto y = acc::fork_reduce(3, s.cbegin(), s.cend(), string{"<"}, plus<>());
+  return x == y;
+}
+
+DEF_PROPERTY(ForkAverage, Distributed, const vector<unsigned int>& v)
+{
+  // partial (sum, count) pairs, as in distributed_average.svg
+  using P = pair<unsigned long, unsigned long>;
+  auto add = [] (const P& a, const P& b) {
+    return P{ a.first + b.first, a.second + b.second };
+  };
+  auto y = acc::fork_transform_reduce(
+      4, v.cbegin(), v.cend(), P{0, 0}, add,
+      [] (unsigned int i) { return P{ i, 1 }; });
+  return y.first == accumulate(v.cbegin(), v.cend(), 0ul)
+    && y.second == v.size();
+}
+
+DEF_PROPERTY(ForkMapMerge, Distributed, const vector<unsigned int>& v)
+{
+  using M = map<unsigned int, unsigned int>;
+  M x;
+  for (auto i : v) ++x[i % 16];
+  auto y = acc::fork_transform_reduce(
+      4, v.cbegin(), v.cend(), M{}, acc::map_merge<>(),
+      [] (unsigned int i) { return M{ {i % 16, 1u} }; });
+  return x == y;
+}
+
+DEF_TEST(ForkWorkerFails, Distributed)
+{
+  vector<int> v(100, 1);
+  try {
+    acc::fork_transform_reduce(
+        4, v.cbegin(), v.cend(), 0, plus<>(),
+        [] (int i) -> int { if (i) throw runtime_error("worker"); return i; });
+  } catch (const runtime_error&) {
+    return true;
+  }
+  return false;
+}
+
+namespace
+{
+  // a sum whose serialized form has a byte more than load reads
+  struct padded { int sum; };
+}
+
+namespace acc
+{
+  template <>
+  struct serializer<padded>
+  {
+    static void save(std::vector<char>& out, const padded& x)
+    {
+      acc::save(out, x.sum);
+      out.push_back('!');
+    }
+
+    static padded load(const char*& p, const char* end)
+    {
+      return padded{ acc::load<int>(p, end) };
+    }
+  };
+}
+
+DEF_TEST(ForkTrailingBytes, Distributed)
+{
+  vector<int> v(100, 1);
+  try {
+    acc::fork_transform_reduce(
+        4, v.cbegin(), v.cend(), padded{ 0 },
+        [] (padded a, padded b) { return padded{ a.sum + b.sum }; },
+        [] (int i) { return padded{ i }; });
+  } catch (const runtime_error&) {
+    return true;
+  }
+  return false;
+}
@@ -40,3 +40,31 @@ DEF_PROPERTY(SortHeap, HeapOps, vector<unsigned int> v)
   acc::sort_heap(v.begin(), v.end());
   return is_sorted(v.cbegin(), v.cend());
 }
+
+DEF_PROPERTY(MakeHeap, HeapOps, vector<unsigned int> v)
+{
+  acc::make_heap(v.begin(), v.end());
+  auto w = v;
+  acc::make_heap(w.begin(), w.end(), greater<>{});
+  return is_heap(v.cbegin(), v.cend()) && is_heap(w.cbegin(), w.cend(), greater<>{});
+}
+
+DEF_PROPERTY(PushPopHeap, HeapOps, const vector<unsigned int>& v)
+{
+  // push everything, then pop everything: out comes the sorted range
+  vector<unsigned int> h;
+  for (auto x : v) {
+    h.push_back(x);
+    acc::push_heap(h.begin(), h.end());
+    if (!is_heap(h.cbegin(), h.cend())) return false;
+  }
+  vector<unsigned int> out;
+  for (auto last = h.end(); last != h.begin(); --last) {
+    acc::pop_heap(h.begin(), last);
+    out.push_back(*(last - 1));
+    if (!is_heap(h.begin(), last - 1)) return false;
+  }
+  auto w = v;
+  sort(w.begin(), w.end(), greater<>{});
+  return out == w;
+}
@@ -0,0 +1,178 @@
+#include <all.h>
+
+#include <testinator.h>
+
+#include "shards.h"
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <stdexcept>
+#include <vector>
+
+using namespace std;
+
+// ---------------------------------------------------------------------------
+// histogram
+
+namespace
+{
+  // doubles spread over [-10, 110), so that some underflow and some overflow
+  vector<double> doubles(const vector<unsigned int>& v)
+  {
+    vector<double> w;
+    for (auto x : v) w.push_back(static_cast<double>(x % 120000) / 1000.0 - 10.0);
+    return w;
+  }
+
+  // the counts of h, underflow first and overflow last
+  template <typename H>
+  vector<uint64_t> counts(const H& h)
+  {
+    vector<uint64_t> c{ h.underflow() };
+    for (size_t i = 0; i < h.size(); ++i) c.push_back(h[i]);
+    c.push_back(h.overflow());
+    return c;
+  }
+}
+
+DEF_PROPERTY(Uniform, Histogram, const vector<unsigned int>& v)
+{
+  auto w = doubles(v);
+  acc::histogram<> h(acc::uniform_bins(0, 100, 10));
+  for (auto x : w) h.insert(x);
+
+  vector<uint64_t> c(12);
+  for (auto x : w) ++c[x < 0 ? 0 : x >= 100 ? 11 : static_cast<size_t>(x / 10) + 1];
+  return counts(h) == c && h.total() == w.size();
+}
+
+DEF_PROPERTY(Edges, Histogram, const vector<unsigned int>& v)
+{
+  acc::histogram<acc::edge_bins<unsigned int>> h(
+      acc::edge_bins<unsigned int>({ 10, 100, 1000, 1000000 }));
+  for (auto x : v) h.insert(x);
+
+  vector<uint64_t> c(5);
+  for (auto x : v) ++c[x < 10 ? 0 : x < 100 ? 1 : x < 1000 ? 2 : x < 1000000 ? 3 : 4];
+  return counts(h) == c;
+}
+
+DEF_TEST(Bounds, Histogram)
+{
+  acc::histogram<> h(acc::uniform_bins(0, 1, 3));
+  // (no NaN or infinities, since the release build has fast math)
+  double xs[] = { 0, 1.0 / 3, 2.0 / 3, nextafter(1.0, 0.0), 1,
+                  -0.0, -1e-300, 1e300, -1e300 };
+  for (auto x : xs) h.insert(x);
+  acc::histogram<> b(acc::uniform_bins(0, 1, 3));
+  b.insert(begin(xs), end(xs));
+
+  acc::edge_bins<int> e({ 0, 5 });
+  return h.underflow() == 2 && h.overflow() == 2 && h[0] == 2 && h[2] == 2
+    && b == h && h.bins().edge(3) == 1
+    && e.index(-1) == 0 && e.index(0) == 1 && e.index(4) == 1 && e.index(5) == 2;
+}
+
+DEF_PROPERTY(Batch, Histogram, const vector<unsigned int>& v)
+{
+  // the AVX2 kernel, the scalar bins, the generic batch, and a fold with
+  // insert_op agree with inserting one at a time
+  auto w = doubles(v);
+  acc::uniform_bins bins(-5, 105, 37);
+  acc::histogram<> h(bins);
+  for (auto x : w) h.insert(x);
+
+  acc::histogram<> a(bins);
+  a.insert(w.cbegin(), w.cend());
+  vector<float> f(w.cbegin(), w.cend());
+  acc::histogram<> b(bins), fb(bins);
+  b.insert(f.cbegin(), f.cend());
+  for (auto x : f) fb.insert(x);
+  vector<int> n(w.cbegin(), w.cend());
+  acc::histogram<> c(bins), nc(bins);
+  c.insert(n.cbegin(), n.cend());
+  for (auto x : n) nc.insert(x);
+  list<double> l(w.cbegin(), w.cend());
+  acc::histogram<> d(bins);
+  d.insert(l.cbegin(), l.cend());
+  auto e = acc::accumulate(w.cbegin(), w.cend(), acc::histogram<>(bins),
+                           acc::insert_op{});
+
+  acc::edge_bins<double> edges({ -5, 0, 0.5, 1, 2, 50, 99 });
+  acc::histogram<acc::edge_bins<double>> g(edges), gb(edges);
+  for (auto x : w) g.insert(x);
+  gb.insert(w.cbegin(), w.cend());
+  return a == h && b == fb && c == nc && d == h && e == h && gb == g;
+}
+
+DEF_PROPERTY(Merge, Histogram, const vector<unsigned int>& v)
+{
+  auto w = doubles(v);
+  auto mid = w.cbegin() + static_cast<ptrdiff_t>(w.size() / 3);
+  acc::uniform_bins bins(0, 100, 20);
+  acc::histogram<> a(bins), b(bins), all(bins);
+  a.insert(w.cbegin(), mid);
+  b.insert(mid, w.cend());
+  all.insert(w.cbegin(), w.cend());
+  auto ab = a, ba = b;
+  ab.merge(b);
+  ba.merge(a);
+
+  // the empty histogram adopts the bins of what it's merged with
+  acc::histogram<> i;
+  i.merge(all);
+  auto j = all;
+  j.merge(acc::histogram<>{});
+  return ab == all && ba == all && (w.empty() || i == all) && j == all;
+}
+
+DEF_TEST(ParallelReduce, Histogram)
+{
+  vector<double> v(100000);
+  for (size_t i = 0; i < v.size(); ++i) v[i] = static_cast<double>(i % 1000) / 10.0;
+  using H = acc::histogram<>;
+  auto m = test::merge(test::sharded(v.cbegin(), v.cend(), 8,
+                                     H(acc::uniform_bins(0, 100, 100))));
+  const auto& x = m.reduced;
+  bool flat = true;
+  for (size_t i = 0; i < x.size(); ++i) flat = flat && x[i] == 1000;
+  return flat && x.total() == v.size() && m.accumulated == x;
+}
+
+DEF_PROPERTY(SaveLoad, Histogram, const vector<unsigned int>& v)
+{
+  auto w = doubles(v);
+  acc::histogram<> h(acc::uniform_bins(0, 100, 16));
+  h.insert(w.cbegin(), w.cend());
+  acc::histogram<acc::edge_bins<unsigned int>> e(
+      acc::edge_bins<unsigned int>({ 1, 2, 3, 1u << 31 }));
+  e.insert(v.cbegin(), v.cend());
+
+  vector<char> out;
+  acc::save(out, h);
+  acc::save(out, e);
+  acc::save(out, acc::histogram<>{});
+  const char* p = out.data();
+  auto end = p + out.size();
+  auto h2 = acc::load<acc::histogram<>>(p, end);
+  auto e2 = acc::load<acc::histogram<acc::edge_bins<unsigned int>>>(p, end);
+  auto i2 = acc::load<acc::histogram<>>(p, end);
+  return h2 == h && e2 == e && i2 == acc::histogram<>{} && p == end;
+}
+
+DEF_TEST(LoadTruncated, Histogram)
+{
+  // the most bins there may be, and no counts: refused before the counts
+  // are allocated
+  vector<char> out;
+  acc::save(out, acc::uniform_bins(0, 1, acc::detail::max_bins));
+  const char* p = out.data();
+  try {
+    acc::load<acc::histogram<>>(p, p + out.size());
+  } catch (const runtime_error&) {
+    return true;
+  }
+  return false;
+}
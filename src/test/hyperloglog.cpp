@@ -0,0 +1,149 @@
+#include <all.h>
+
+#include <testinator.h>
+
+#include "shards.h"
+
+#include <cmath>
+#include <cstddef>
+#include <functional>
+#include <numeric>
+#include <set>
+#include <stdexcept>
+#include <vector>
+
+using namespace std;
+
+// ---------------------------------------------------------------------------
+// hyperloglog
+
+namespace
+{
+  using hll = acc::hyperloglog<12>;
+
+  hll sketch(const vector<unsigned int>& v)
+  {
+    hll h;
+    h.insert(v.cbegin(), v.cend());
+    return h;
+  }
+
+  vector<unsigned int> range(unsigned int first, unsigned int last)
+  {
+    vector<unsigned int> v(last - first);
+    iota(v.begin(), v.end(), first);
+    return v;
+  }
+
+  // within four standard errors
+  bool close_to(double estimate, double n, size_t registers)
+  {
+    return abs(estimate - n) <= 4 * 1.04 / sqrt(double(registers)) * n + 1;
+  }
+}
+
+DEF_TEST(Empty, HyperLogLog)
+{
+  hll h;
+  return h.empty() && h.is_sparse() && h.estimate() == 0.0;
+}
+
+DEF_PROPERTY(Batch, HyperLogLog, const vector<unsigned int>& v)
+{
+  // the batch path, element by element, and a fold with insert_op all agree
+  hll a = sketch(v);
+  hll b;
+  for (auto x : v) b.insert(x);
+  auto c = acc::accumulate(v.cbegin(), v.cend(), hll{}, acc::insert_op{});
+  set<unsigned int> s(v.cbegin(), v.cend());
+  hll d;
+  d.insert(s.cbegin(), s.cend());
+  return a == b && a == c && a == d;
+}
+
+DEF_PROPERTY(MergeIsUnion, HyperLogLog, const vector<unsigned int>& v)
+{
+  auto mid = v.cbegin() + static_cast<ptrdiff_t>(v.size() / 3);
+  hll a, b;
+  a.insert(v.cbegin(), mid);
+  b.insert(mid, v.cend());
+  auto ab = a, ba = b;
+  ab.merge(b);
+  ba.merge(a);
+  return ab == sketch(v) && ba == ab;
+}
+
+DEF_TEST(Accuracy, HyperLogLog)
+{
+  for (unsigned int n : { 10u, 1000u, 100000u, 1000000u }) {
+    acc::hyperloglog<14> h;
+    auto v = range(0, n);
+    h.insert(v.cbegin(), v.cend());
+    h.insert(v.cbegin(), v.cend());
+    if (!close_to(h.estimate(), n, h.registers)) return false;
+  }
+  return true;
+}
+
+DEF_TEST(Promote, HyperLogLog)
+{
+  // a sparse sketch merges into a dense one, and the other way around
+  auto small = sketch(range(0, 100));
+  auto large = sketch(range(50, 50000));
+  auto a = small, b = large;
+  a.merge(large);
+  b.merge(small);
+  return small.is_sparse() && !large.is_sparse()
+    && !a.is_sparse() && a == b && a == sketch(range(0, 50000))
+    && close_to(small.estimate(), 100, hll::registers)
+    && close_to(a.estimate(), 50000, hll::registers);
+}
+
+DEF_TEST(ParallelReduce, HyperLogLog)
+{
+  // merged by reduce and accumulator, and by a sequential reduce, it's the
+  // same sketch as of the whole
+  auto v = range(0, 200000);
+  auto shards = test::sharded(v.cbegin(), v.cend(), 16, hll{});
+  auto m = test::merge(shards);
+  auto y = acc::reduce(shards.cbegin(), shards.cend(), hll{}, acc::merge_op{});
+  auto expected = sketch(v);
+  return m.reduced == expected && m.accumulated == expected && y == expected;
+}
+
+DEF_PROPERTY(SaveLoad, HyperLogLog, const vector<unsigned int>& v)
+{
+  auto round_trip = [] (const hll& h) {
+    vector<char> out;
+    acc::save(out, h);
+    const char* p = out.data();
+    auto g = acc::load<hll>(p, p + out.size());
+    return g == h && g.is_sparse() == h.is_sparse() && p == out.data() + out.size();
+  };
+  auto dense = sketch(range(0, 10000));
+  dense.insert(v.cbegin(), v.cend());
+  return round_trip(sketch(v)) && round_trip(dense);
+}
+
+DEF_TEST(SaveCompact, HyperLogLog)
+{
+  // six bits a register, and a few bytes a sparse entry
+  vector<char> d, s;
+  acc::save(d, sketch(range(0, 100000)));
+  acc::save(s, sketch(range(0, 100)));
+  return d.size() == 1 + hll::registers * 3 / 4 && s.size() < 100 * 3;
+}
+
+DEF_TEST(LoadBad, HyperLogLog)
+{
+  vector<char> out;
+  acc::save(out, sketch(range(0, 100000)));
+  out.back() = char(0xff);
+  const char* p = out.data();
+  try {
+    acc::load<hll>(p, p + out.size());
+  } catch (const runtime_error&) {
+    return true;
+  }
+  return false;
+}
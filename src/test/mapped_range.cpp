@@ -0,0 +1,122 @@
+#include <all.h>
+
+#include <testinator.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <numeric>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace std;
+
+// ---------------------------------------------------------------------------
+// mapped_range
+
+namespace
+{
+  struct record
+  {
+    unsigned int key;
+    float value;
+  };
+
+  // a temporary file holding v's bytes, removed when it goes out of scope
+  struct temp_file
+  {
+    template <typename T>
+    explicit temp_file(const vector<T>& v)
+    {
+      char name[] = "/tmp/acc_mapped_XXXXXX";
+      int fd = mkstemp(name);
+      path = name;
+      auto bytes = v.size() * sizeof(T);
+      auto p = reinterpret_cast<const char*>(v.data());
+      while (bytes > 0) {
+        auto w = write(fd, p, bytes);
+        if (w <= 0) break;
+        p += w;
+        bytes -= static_cast<size_t>(w);
+      }
+      close(fd);
+    }
+    ~temp_file() { remove(path.c_str()); }
+
+    string path;
+  };
+
+  vector<record> records(const vector<unsigned int>& v)
+  {
+    vector<record> r;
+    for (auto i : v) r.push_back(record{ i, static_cast<float>(i % 100) });
+    return r;
+  }
+}
+
+DEF_PROPERTY(Accumulate, MappedRange, const vector<unsigned int>& v)
+{
+  temp_file f(v);
+  acc::mapped_range<unsigned int> m(f.path);
+  return m.size() == v.size()
+    && acc::accumulate(m.begin(), m.end(), 0u, plus<>())
+       == accumulate(v.cbegin(), v.cend(), 0u);
+}
+
+DEF_PROPERTY(Records, MappedRange, const vector<unsigned int>& v)
+{
+  auto r = records(v);
+  temp_file f(r);
+  acc::mapped_range<record> m(f.path, acc::advice::random);
+
+  auto odd = [] (const record& a) { return (a.key & 1) != 0; };
+  auto by_key = [] (const record& a, const record& b) { return a.key < b.key; };
+  auto x = acc::minmax_element(m.begin(), m.end(), by_key);
+  auto y = minmax_element(r.cbegin(), r.cend(), by_key);
+  return acc::count_if(m.begin(), m.end(), odd)
+         == count_if(r.cbegin(), r.cend(), odd)
+    && (r.empty() || (x.first->key == y.first->key
+                      && x.second->key == y.second->key));
+}
+
+DEF_PROPERTY(ReducePar, MappedRange, const vector<unsigned int>& v)
+{
+  temp_file f(v);
+  acc::mapped_range<unsigned int> m(f.path);
+  constexpr acc::execution::parallel_policy par4{4, 1};
+  return acc::reduce(par4, m.begin(), m.end(), 0u, plus<>())
+    == accumulate(v.cbegin(), v.cend(), 0u);
+}
+
+DEF_PROPERTY(ForkReduce, MappedRange, const vector<unsigned int>& v)
+{
+  temp_file f(v);
+  acc::mapped_range<unsigned int> m(f.path);
+  return acc::fork_reduce(4, m, 0u, plus<>())
+    == accumulate(v.cbegin(), v.cend(), 0u);
+}
+
+DEF_TEST(Missing, MappedRange)
+{
+  try {
+    acc::mapped_range<int> m("/nonexistent/acc_mapped");
+  } catch (const system_error&) {
+    return true;
+  }
+  return false;
+}
+
+DEF_TEST(PartialRecord, MappedRange)
+{
+  temp_file f(vector<char>(7));
+  try {
+    acc::mapped_range<int> m(f.path);
+  } catch (const runtime_error&) {
+    return true;
+  }
+  return false;
+}
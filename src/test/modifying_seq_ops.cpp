@@ -3,7 +3,10 @@
 #include <testinator.h>
 
 #include <algorithm>
+#include <forward_list>
 #include <functional>
+#include <iterator>
+#include <sstream>
 #include <vector>
 
 using namespace std;
@@ -257,6 +260,27 @@ DEF_PROPERTY(ReverseCopyFwdIt, ModifyingSeqOps, const vector<unsigned int>& v)
   return outx == v;
 }
 
+DEF_PROPERTY(ReverseCopyInputIt, ModifyingSeqOps, const vector<unsigned int>& v)
+{
+  stringstream ss;
+  for (auto i : v) ss << i << ' ';
+
+  vector<unsigned int> outx(v.size(), 0);
+  acc::reverse_copy(istream_iterator<unsigned int>(ss),
+                    istream_iterator<unsigned int>(), outx.data());
+
+  return equal(outx.crbegin(), outx.crend(), v.cbegin(), v.cend());
+}
+
+DEF_TEST(ReverseLarge, ModifyingSeqOps)
+{
+  // deep enough that one stack frame per element would overflow
+  forward_list<int> l(1 << 22);
+  acc::iota(l.begin(), l.end(), 0);
+  acc::reverse(l.begin(), l.end());
+  return l.front() == (1 << 22) - 1 && is_sorted(l.cbegin(), l.cend(), greater<>());
+}
+
 DEF_TEST(RotateEmpty, ModifyingSeqOps)
 {
   vector<int> v;
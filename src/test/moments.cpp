@@ -0,0 +1,149 @@
+#include <all.h>
+
+#include <testinator.h>
+
+#include "shards.h"
+
+#include <cmath>
+#include <cstddef>
+#include <list>
+#include <vector>
+
+using namespace std;
+
+// ---------------------------------------------------------------------------
+// moments
+
+namespace
+{
+  // the moments by the two-pass formulas, in long double
+  struct reference
+  {
+    explicit reference(const vector<double>& v)
+    {
+      long double n = v.size();
+      long double s = 0;
+      for (auto x : v) s += x;
+      mean = s / n;
+      long double m2 = 0, m3 = 0;
+      for (auto x : v) {
+        auto d = x - mean;
+        m2 += d * d;
+        m3 += d * d * d;
+      }
+      variance = m2 / n;
+      skewness = m2 > 0 ? sqrt(n) * m3 / pow(m2, 1.5L) : 0;
+    }
+
+    long double mean, variance, skewness;
+  };
+
+  bool close(long double a, long double b, long double scale)
+  {
+    return fabs(a - b) <= 1e-9L * scale;
+  }
+
+  template <typename M>
+  bool matches(const M& m, const vector<double>& v)
+  {
+    if (v.empty()) return m.count() == 0 && m.mean() == 0 && m.variance() == 0;
+    reference r(v);
+    auto sd = sqrt(r.variance);
+    return m.count() == v.size()
+      && close(m.mean(), r.mean, fabs(r.mean) + sd)
+      && close(m.variance(), r.variance, r.variance + 1)
+      && (sd < 1e-3L || close(m.skewness(), r.skewness, 1));
+  }
+
+  // skewed values, some way from zero
+  vector<double> doubles(const vector<unsigned int>& v)
+  {
+    vector<double> w;
+    for (auto x : v) {
+      auto y = static_cast<double>(x % 1000);
+      w.push_back(1000.0 + y * y / 1000.0);
+    }
+    return w;
+  }
+}
+
+DEF_PROPERTY(Insert, Moments, const vector<unsigned int>& v)
+{
+  auto w = doubles(v);
+  acc::moments<> m;
+  for (auto x : w) m.insert(x);
+  auto f = acc::accumulate(w.cbegin(), w.cend(), acc::moments<>{}, acc::insert_op{});
+  return matches(m, w) && f == m
+    && (w.size() < 2
+        || close(m.sample_variance(), m.variance() * w.size() / (w.size() - 1),
+                 m.variance()));
+}
+
+DEF_PROPERTY(Batch, Moments, const vector<unsigned int>& v)
+{
+  // the SIMD blocks over doubles, and the copied blocks of anything else
+  auto w = doubles(v);
+  acc::moments<> a;
+  a.insert(w.cbegin(), w.cend());
+  list<double> l(w.cbegin(), w.cend());
+  acc::moments<> b;
+  b.insert(l.cbegin(), l.cend());
+  vector<unsigned int> u(v.cbegin(), v.cend());
+  for (auto& x : u) x %= 1000000;
+  acc::moments<> c;
+  c.insert(u.cbegin(), u.cend());
+  return matches(a, w) && matches(b, w)
+    && matches(c, vector<double>(u.cbegin(), u.cend()));
+}
+
+DEF_PROPERTY(Merge, Moments, const vector<unsigned int>& v)
+{
+  auto w = doubles(v);
+  auto mid = w.cbegin() + static_cast<ptrdiff_t>(w.size() / 3);
+  acc::moments<> a, b;
+  for (auto it = w.cbegin(); it != mid; ++it) a.insert(*it);
+  b.insert(mid, w.cend());
+  auto ab = a, ba = b;
+  ab.merge(b);
+  ba.merge(a);
+  auto i = acc::moments<>{};
+  i.merge(ab);
+  return matches(ab, w) && matches(ba, w) && i == ab;
+}
+
+DEF_TEST(Stable, Moments)
+{
+  // a large offset defeats the sum-of-squares formula, but not these
+  vector<double> v;
+  for (int i = 0; i < 100000; ++i) v.push_back(1e9 + (i % 2 ? 1.0 : -1.0));
+  acc::moments<> a, b;
+  for (auto x : v) a.insert(x);
+  b.insert(v.cbegin(), v.cend());
+  return fabs(a.variance() - 1) < 1e-6 && fabs(b.variance() - 1) < 1e-6
+    && fabs(a.skewness()) < 1e-6 && fabs(b.skewness()) < 1e-6
+    && a.mean() == 1e9 && b.mean() == 1e9;
+}
+
+DEF_TEST(ParallelReduce, Moments)
+{
+  vector<double> v(100000);
+  for (size_t i = 0; i < v.size(); ++i) v[i] = static_cast<double>(i % 997) * 0.5;
+  using M = acc::moments<>;
+  auto m = test::merge(test::sharded(v.cbegin(), v.cend(), 8, M{}));
+  // and one sketch per value, merged
+  auto y = acc::transform_reduce(v.cbegin(), v.cend(),
+                                 M{}, acc::merge_op{},
+                                 [] (double d) { M s; s.insert(d); return s; });
+  return matches(m.reduced, v) && matches(m.accumulated, v) && matches(y, v);
+}
+
+DEF_PROPERTY(SaveLoad, Moments, const vector<unsigned int>& v)
+{
+  auto w = doubles(v);
+  acc::moments<> m;
+  m.insert(w.cbegin(), w.cend());
+  vector<char> out;
+  acc::save(out, m);
+  const char* p = out.data();
+  return acc::load<acc::moments<>>(p, p + out.size()) == m;
+}
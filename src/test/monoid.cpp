@@ -0,0 +1,130 @@
+#include <all.h>
+
+#include <testinator.h>
+
+#include <functional>
+#include <map>
+#include <numeric>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// ---------------------------------------------------------------------------
+// monoid
+
+static_assert(acc::is_associative<plus<>, int>::value, "");
+static_assert(acc::is_commutative<plus<int>, int>::value, "");
+static_assert(!acc::is_associative<plus<>, double>::value, "");
+static_assert(acc::is_associative<plus<>, string>::value, "");
+static_assert(!acc::is_commutative<plus<>, string>::value, "");
+static_assert(acc::has_absorbing<logical_and<>, bool>::value, "");
+static_assert(!acc::has_absorbing<plus<>, unsigned>::value, "");
+static_assert(acc::is_commutative<acc::map_merge<>, map<int, int>>::value, "");
+static_assert(!acc::has_identity<minus<>, int>::value, "");
+
+namespace
+{
+  template <typename Op, typename T>
+  bool monoid_laws(Op op, T x)
+  {
+    using M = acc::monoid<Op, T>;
+    return op(M::identity(), x) == x && op(x, M::identity()) == x;
+  }
+
+  template <typename Op, typename T>
+  bool absorbing_laws(Op op, T x)
+  {
+    using M = acc::monoid<Op, T>;
+    return op(M::absorbing(), x) == M::absorbing()
+      && op(x, M::absorbing()) == M::absorbing();
+  }
+}
+
+DEF_PROPERTY(Identity, Monoid, int x)
+{
+  return monoid_laws(plus<>(), x)
+    && monoid_laws(multiplies<>(), x)
+    && monoid_laws(acc::minimum<>(), x)
+    && monoid_laws(acc::maximum<>(), x)
+    && monoid_laws(bit_and<>(), x)
+    && monoid_laws(bit_or<>(), x)
+    && monoid_laws(bit_xor<>(), x)
+    && monoid_laws(acc::minimum<>(), static_cast<double>(x))
+    && monoid_laws(plus<>(), to_string(x))
+    && monoid_laws(logical_and<>(), x % 2 == 0)
+    && monoid_laws(logical_or<>(), x % 2 == 0);
+}
+
+DEF_PROPERTY(Absorbing, Monoid, int x)
+{
+  return absorbing_laws(multiplies<>(), x)
+    && absorbing_laws(acc::minimum<>(), x)
+    && absorbing_laws(acc::maximum<>(), x)
+    && absorbing_laws(bit_and<>(), x)
+    && absorbing_laws(bit_or<>(), x)
+    && absorbing_laws(acc::maximum<>(), static_cast<float>(x))
+    && absorbing_laws(logical_and<>(), x % 2 == 0)
+    && absorbing_laws(logical_or<>(), x % 2 == 0);
+}
+
+DEF_TEST(LogicalAndStops, Monoid)
+{
+  // false absorbs under &&, so the fold stops at the first false
+  vector<int> v(100, 1);
+  v[10] = 0;
+  int calls = 0;
+  auto r = acc::transform_reduce(v.cbegin(), v.cend(), true, logical_and<>(),
+                                 [&] (int i) { ++calls; return i != 0; });
+  return !r && calls == 11;
+}
+
+DEF_TEST(LogicalOrStops, Monoid)
+{
+  // true absorbs under ||, so the fold stops at the first true
+  vector<int> v(100, 0);
+  v[20] = 1;
+  int calls = 0;
+  auto r = acc::transform_reduce(v.cbegin(), v.cend(), false, logical_or<>(),
+                                 [&] (int i) { ++calls; return i != 0; });
+  return r && calls == 21;
+}
+
+DEF_PROPERTY(ReduceReorders, Monoid, const vector<unsigned int>& v)
+{
+  auto x = accumulate(v.cbegin(), v.cend(), 0u, plus<>());
+  auto y = acc::reduce(v.cbegin(), v.cend(), 0u, plus<>());
+  return x == y;
+}
+
+DEF_PROPERTY(ReduceInOrder, Monoid, const vector<unsigned int>& v)
+{
+  vector<string> s;
+  for (auto i : v) s.push_back(to_string(i) + ',');
+  auto x = accumulate(s.cbegin(), s.cend(), string{}, plus<>());
+  auto y = acc::reduce(s.cbegin(), s.cend(), string{}, plus<>());
+  return x == y;
+}
+
+DEF_PROPERTY(MapMerge, Monoid, const vector<unsigned int>& v)
+{
+  // word counts, one map per element, merged
+  vector<map<unsigned int, int>> maps;
+  map<unsigned int, int> expected;
+  for (auto i : v) {
+    maps.push_back({{i % 16, 1}});
+    ++expected[i % 16];
+  }
+  constexpr acc::execution::parallel_policy par4{4, 1};
+  auto m = acc::reduce(par4, maps.cbegin(), maps.cend(),
+                       map<unsigned int, int>{}, acc::map_merge<>());
+  return m == expected;
+}
+
+DEF_PROPERTY(TransformReduce, Monoid, const vector<unsigned int>& v)
+{
+  auto sq = [] (unsigned int i) { return i * i; };
+  auto x = inner_product(v.cbegin(), v.cend(), v.cbegin(), 0u);
+  auto y = acc::transform_reduce(v.cbegin(), v.cend(), 0u, plus<>(), sq);
+  return x == y;
+}
@@ -5,6 +5,7 @@
 #include <algorithm>
 #include <functional>
 #include <numeric>
+#include <string>
 #include <vector>
 
 using namespace std;
@@ -67,3 +68,73 @@ DEF_PROPERTY(PartialSum, Numeric, const vector<int>& v)
 
   return sx == sy && outx == outy;
 }
+
+DEF_PROPERTY(AccumulateUntil, Numeric, const vector<unsigned int>& v, unsigned int i)
+{
+  // sum until the total would pass i
+  unsigned long x = 0;
+  for (auto a : v) {
+    if (x + a > i) break;
+    x += a;
+  }
+
+  auto y = acc::accumulate_until(
+      v.cbegin(), v.cend(), 0ul,
+      [&] (unsigned long s, unsigned int a) {
+        return s + a > i ? acc::done(s) : acc::cont(s + a);
+      });
+  return x == y;
+}
+
+DEF_PROPERTY(AccumulateIterUntil, Numeric, const vector<unsigned int>& v)
+{
+  if (v.empty()) return true;
+  auto i = v[v.size()/2];
+
+  auto x = find(v.cbegin(), v.cend(), i);
+  auto y = acc::accumulate_iter_until(
+      v.cbegin(), v.cend(), v.cend(),
+      [&] (auto r, auto it) {
+        return *it == i ? acc::done(it) : acc::cont(r);
+      });
+  return x == y;
+}
+
+namespace
+{
+  // counts the copies made of it
+  struct copy_counter
+  {
+    int* copies;
+    explicit copy_counter(int* c) : copies(c) {}
+    copy_counter(const copy_counter& c) : copies(c.copies) { ++*copies; }
+    copy_counter(copy_counter&&) = default;
+    copy_counter& operator=(const copy_counter& c)
+    {
+      copies = c.copies;
+      ++*copies;
+      return *this;
+    }
+    copy_counter& operator=(copy_counter&&) = default;
+  };
+}
+
+DEF_PROPERTY(AccumulateMoves, Numeric, const vector<unsigned int>& v)
+{
+  int copies = 0;
+  acc::accumulate(
+      v.cbegin(), v.cend(), copy_counter{&copies},
+      [] (copy_counter c, unsigned int) { return c; });
+  return copies == 0;
+}
+
+DEF_PROPERTY(AccumulateInplace, Numeric, const vector<unsigned int>& v)
+{
+  string x;
+  for (auto a : v) x += to_string(a);
+
+  auto y = acc::accumulate_inplace(
+      v.cbegin(), v.cend(), string{},
+      [] (string& s, unsigned int a) { s += to_string(a); });
+  return x == y;
+}
@@ -26,6 +26,25 @@ DEF_PROPERTY(Partition, PartitioningOps, vector<unsigned int> v)
   return is_partitioned(v.begin(), v.end(), even) && x == y;
 }
 
+DEF_PROPERTY(PartitionBlocks, PartitioningOps, const vector<unsigned int>& v,
+             unsigned int bias)
+{
+  // long enough for blocks from both ends, with the trues anywhere from
+  // rare to nearly all
+  auto below = [bias] (unsigned int i) { return i % 16 < bias % 17; };
+  vector<unsigned int> w;
+  for (unsigned int i = 0; w.size() < 1000 + 37 * v.size(); ++i) {
+    w.push_back(v.empty() ? i * 2654435761u : v[i % v.size()] ^ (i * 2654435761u));
+  }
+  auto sorted = w;
+  sort(sorted.begin(), sorted.end());
+  auto x = acc::partition(w.begin(), w.end(), below);
+  auto y = partition_point(w.begin(), w.end(), below);
+  auto ok = is_partitioned(w.begin(), w.end(), below) && x == y;
+  sort(w.begin(), w.end());
+  return ok && w == sorted;
+}
+
 DEF_PROPERTY(PartitionCopy, PartitioningOps, const vector<unsigned int>& v)
 {
   auto even = [] (unsigned int i) { return (i&1) == 0; };
@@ -48,3 +67,30 @@ DEF_PROPERTY(StablePartition, PartitioningOps, vector<unsigned int> v)
   return is_partitioned(v.begin(), v.end(), even) && x == y;
 }
 
+
+namespace
+{
+  // a small grain forces chunking even for short test vectors
+  constexpr acc::execution::parallel_policy par4{4, 1};
+}
+
+DEF_PROPERTY(PartitionPar, PartitioningOps, vector<unsigned int> v)
+{
+  auto even = [] (unsigned int i) { return (i&1) == 0; };
+  vector<unsigned int> w{v};
+  auto x = acc::partition(par4, v.begin(), v.end(), even);
+  auto y = partition_point(v.begin(), v.end(), even);
+  auto ok = is_partitioned(v.begin(), v.end(), even) && x == y;
+  sort(v.begin(), v.end());
+  sort(w.begin(), w.end());
+  return ok && v == w;
+}
+
+DEF_PROPERTY(StablePartitionPar, PartitioningOps, vector<unsigned int> v)
+{
+  auto even = [] (unsigned int i) { return (i&1) == 0; };
+  vector<unsigned int> w{v};
+  stable_partition(v.begin(), v.end(), even);
+  acc::stable_partition(par4, w.begin(), w.end(), even);
+  return v == w;
+}
@@ -0,0 +1,78 @@
+#include <all.h>
+
+#include <testinator.h>
+
+#include <forward_list>
+#include <functional>
+#include <numeric>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// ---------------------------------------------------------------------------
+// reduce
+
+namespace
+{
+  // a small grain forces chunking even for short test vectors
+  constexpr acc::execution::parallel_policy par4{4, 1};
+  constexpr acc::execution::parallel_unsequenced_policy par_unseq4{4, 1};
+}
+
+DEF_PROPERTY(ReduceSeq, Reduce, const vector<unsigned int>& v)
+{
+  auto x = accumulate(v.cbegin(), v.cend(), 0u, plus<>());
+  auto y = acc::reduce(acc::execution::seq, v.cbegin(), v.cend(), 0u, plus<>());
+  return x == y;
+}
+
+DEF_PROPERTY(ReducePar, Reduce, const vector<unsigned int>& v)
+{
+  auto x = accumulate(v.cbegin(), v.cend(), 0u, plus<>());
+  auto y = acc::reduce(par4, v.cbegin(), v.cend(), 0u, plus<>());
+  return x == y;
+}
+
+DEF_PROPERTY(ReduceParUnseq, Reduce, const vector<unsigned int>& v)
+{
+  auto x = accumulate(v.cbegin(), v.cend(), 0u, plus<>());
+  auto y = acc::reduce(par_unseq4, v.cbegin(), v.cend(), 0u, plus<>());
+  return x == y;
+}
+
+DEF_PROPERTY(ReduceParOrdered, Reduce, const vector<unsigned int>& v)
+{
+  // string concatenation is associative but not commutative
+  vector<string> s;
+  for (auto i : v) s.push_back(to_string(i) + ',');
+  auto x = accumulate(s.cbegin(), s.cend(), string{"<"}, plus<>());
+  auto y = acc::reduce(par4, s.cbegin(), s.cend(), string{"<"}, plus<>());
+  return x == y;
+}
+
+DEF_PROPERTY(ReduceParFwdIt, Reduce, const vector<unsigned int>& v)
+{
+  forward_list<unsigned int> l(v.cbegin(), v.cend());
+  auto x = accumulate(v.cbegin(), v.cend(), 0u, plus<>());
+  auto y = acc::reduce(par4, l.cbegin(), l.cend(), 0u, plus<>());
+  return x == y;
+}
+
+DEF_PROPERTY(ReduceUnseq, Reduce, const vector<unsigned int>& v)
+{
+  auto x = accumulate(v.cbegin(), v.cend(), 0u, plus<>());
+  auto y = acc::reduce(acc::execution::unseq, v.cbegin(), v.cend(), 0u, plus<>());
+  return x == y;
+}
+
+DEF_PROPERTY(ReduceUnseqOrdered, Reduce, const vector<unsigned int>& v)
+{
+  // the accumulators cover contiguous lanes, so order is preserved
+  vector<string> s;
+  for (auto i : v) s.push_back(to_string(i) + ',');
+  auto x = accumulate(s.cbegin(), s.cend(), string{"<"}, plus<>());
+  auto y = acc::reduce(acc::execution::unseq, s.cbegin(), s.cend(), string{"<"}, plus<>());
+  auto z = acc::reduce(par_unseq4, s.cbegin(), s.cend(), string{"<"}, plus<>());
+  return x == y && x == z;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <all.h>
+
+#include <cstddef>
+#include <vector>
+
+// ---------------------------------------------------------------------------
+// sketches of shards, merged
+//
+// The mergeable sketches are all checked the same way: the input is cut into
+// shards, each shard is sketched separately, and the sketches are merged by a
+// parallel reduce and by an accumulator. What the merged sketch should then
+// be is up to each type's tests.
+
+namespace test
+{
+  // n sketches, each a copy of empty with a slice of [first, last) inserted
+  template <typename S, typename RandomIt>
+  std::vector<S> sharded(RandomIt first, RandomIt last, std::size_t n,
+                         const S& empty)
+  {
+    std::vector<S> shards(n, empty);
+    auto size = static_cast<std::size_t>(last - first);
+    for (std::size_t s = 0; s < n; ++s) {
+      shards[s].insert(first + static_cast<std::ptrdiff_t>(size * s / n),
+                       first + static_cast<std::ptrdiff_t>(size * (s+1) / n));
+    }
+    return shards;
+  }
+
+  template <typename S>
+  struct merged
+  {
+    S reduced;      // by acc::reduce(par, ...)
+    S accumulated;  // by acc::accumulator
+  };
+
+  template <typename S>
+  merged<S> merge(const std::vector<S>& shards)
+  {
+    acc::accumulator<S, acc::merge_op> a;
+    for (const auto& s : shards) a.push(s);
+    // a grain of one, so that every shard is a task of its own rather than
+    // the whole reduce falling under the default grain and running in line
+    acc::execution::parallel_policy par{ shards.size(), 1 };
+    return { acc::reduce(par, shards.cbegin(), shards.cend(), S{}, acc::merge_op{}),
+             a.value() };
+  }
+}
@@ -0,0 +1,98 @@
+#include <all.h>
+
+#include <testinator.h>
+
+#include <cmath>
+#include <functional>
+#include <numeric>
+#include <vector>
+
+using namespace std;
+
+// ---------------------------------------------------------------------------
+// SIMD kernels
+
+namespace
+{
+  // every kernel present on every instruction set the host has must agree
+  // with the scalar fold
+  template <typename T, typename Tag, typename Eq>
+  bool all_kernels_agree(const vector<T>& v, Eq eq)
+  {
+    T expected = acc::simd::identity<T>(Tag{});
+    for (auto x : v) expected = acc::simd::apply(Tag{}, expected, x);
+
+    for (int i = 0; i < acc::simd::isa_count; ++i)
+    {
+      auto k = acc::simd::kernels<T>(static_cast<acc::simd::isa>(i)).fold[Tag::index];
+      if (k && !eq(k(v.data(), v.size()), expected)) return false;
+    }
+    return true;
+  }
+
+  bool close_to(double a, double b)
+  {
+    return abs(a - b) <= 1e-9 * max(1.0, abs(b));
+  }
+}
+
+DEF_PROPERTY(FoldInt, Simd, const vector<unsigned int>& u)
+{
+  vector<int> v(u.cbegin(), u.cend());
+  auto eq = equal_to<>{};
+  using namespace acc::simd;
+  return all_kernels_agree<int, op_plus>(v, eq)
+    && all_kernels_agree<int, op_multiplies>(v, eq)
+    && all_kernels_agree<int, op_min>(v, eq)
+    && all_kernels_agree<int, op_max>(v, eq)
+    && all_kernels_agree<int, op_bit_and>(v, eq)
+    && all_kernels_agree<int, op_bit_or>(v, eq)
+    && all_kernels_agree<int, op_bit_xor>(v, eq)
+    && all_kernels_agree<unsigned int, op_min>(u, eq)
+    && all_kernels_agree<unsigned int, op_max>(u, eq);
+}
+
+DEF_PROPERTY(FoldDouble, Simd, const vector<unsigned int>& u)
+{
+  vector<double> v(u.cbegin(), u.cend());
+  vector<float> w(u.cbegin(), u.cend());
+  using namespace acc::simd;
+  return all_kernels_agree<double, op_plus>(v, close_to)
+    && all_kernels_agree<double, op_min>(v, equal_to<>{})
+    && all_kernels_agree<double, op_max>(v, equal_to<>{})
+    && all_kernels_agree<float, op_min>(w, equal_to<>{})
+    && all_kernels_agree<float, op_max>(w, equal_to<>{});
+}
+
+DEF_PROPERTY(AccumulateDispatch, Simd, const vector<unsigned int>& v)
+{
+  return std::accumulate(v.cbegin(), v.cend(), 0u, plus<>())
+    == acc::accumulate(v.cbegin(), v.cend(), 0u, plus<>())
+    && std::accumulate(v.cbegin(), v.cend(), 1u, multiplies<unsigned int>())
+    == acc::accumulate(v.cbegin(), v.cend(), 1u, multiplies<unsigned int>())
+    && std::accumulate(v.cbegin(), v.cend(), 0u, bit_xor<>())
+    == acc::accumulate(v.cbegin(), v.cend(), 0u, bit_xor<>())
+    && std::accumulate(v.cbegin(), v.cend(), ~0u, acc::minimum<>())
+    == acc::accumulate(v.cbegin(), v.cend(), ~0u, acc::minimum<>());
+}
+
+DEF_PROPERTY(InnerProductDispatch, Simd, const vector<unsigned int>& v)
+{
+  vector<double> w(v.cbegin(), v.cend());
+  auto x = inner_product(v.cbegin(), v.cend(), v.cbegin(), 0u);
+  auto y = acc::inner_product(v.cbegin(), v.cend(), v.cbegin(), 0u,
+                              plus<>(), multiplies<>());
+  auto dx = inner_product(w.cbegin(), w.cend(), w.cbegin(), 0.0);
+  auto dy = acc::inner_product(acc::execution::unseq,
+                               w.cbegin(), w.cend(), w.cbegin(), 0.0,
+                               plus<>(), multiplies<>());
+  return x == y && close_to(dx, dy);
+}
+
+DEF_PROPERTY(ReduceUnseqDouble, Simd, const vector<unsigned int>& v)
+{
+  vector<double> w(v.cbegin(), v.cend());
+  auto x = accumulate(w.cbegin(), w.cend(), 1.0, plus<>());
+  auto y = acc::reduce(acc::execution::unseq, w.cbegin(), w.cend(), 1.0, plus<>());
+  return close_to(x, y);
+}
@@ -3,6 +3,9 @@
 #include <testinator.h>
 
 #include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <forward_list>
 #include <functional>
 #include <vector>
 
@@ -40,6 +43,195 @@ DEF_PROPERTY(Sort, SortingOps, vector<unsigned int> v)
   return w == v;
 }
 
+DEF_PROPERTY(SortForward, SortingOps, const vector<unsigned int>& v)
+{
+  forward_list<unsigned int> l(v.cbegin(), v.cend());
+  acc::sort(l.begin(), l.end());
+  vector<unsigned int> w{v};
+  sort(w.begin(), w.end());
+  return equal(l.cbegin(), l.cend(), w.cbegin(), w.cend());
+}
+
+namespace
+{
+  // the inputs that make quicksorts quadratic, or that they can take
+  // shortcuts on
+  constexpr int shapes = 7;
+
+  vector<unsigned int> shaped(int shape, size_t n)
+  {
+    vector<unsigned int> v(n);
+    for (size_t i = 0; i < n; ++i) {
+      auto x = static_cast<unsigned int>(i);
+      switch (shape) {
+        case 0: v[i] = x * 2654435761u; break;
+        case 1: v[i] = x; break;
+        case 2: v[i] = static_cast<unsigned int>(n - i); break;
+        case 3: v[i] = static_cast<unsigned int>(min(i, n - i)); break;
+        case 4: v[i] = (x * 2654435761u) >> 30; break;
+        case 5: v[i] = 7; break;
+        default: v[i] = x % 100; break;
+      }
+    }
+    return v;
+  }
+}
+
+DEF_TEST(SortShapes, SortingOps)
+{
+  // within a budget of comparisons
+  const size_t n = 20000;
+  bool ok = true;
+  for (int shape = 0; shape < shapes; ++shape) {
+    auto v = shaped(shape, n);
+    vector<unsigned int> w{v};
+    sort(w.begin(), w.end());
+    size_t comparisons = 0;
+    acc::sort(v.begin(), v.end(),
+              [&] (unsigned int a, unsigned int b) { ++comparisons; return a < b; });
+    ok = ok && v == w && comparisons < 4 * n * static_cast<size_t>(log2(n));
+  }
+  return ok;
+}
+
+DEF_TEST(SortNumbersShapes, SortingOps)
+{
+  // with std::less, by radix, or not at all for sorted and reversed input
+  const size_t n = 20000;
+  bool ok = true;
+  for (int shape = 0; shape < shapes; ++shape) {
+    auto v = shaped(shape, n);
+    vector<unsigned int> w{v};
+    sort(w.begin(), w.end());
+    acc::sort(v.begin(), v.end());
+    ok = ok && v == w;
+  }
+  return ok;
+}
+
+DEF_PROPERTY(RadixSort, SortingOps, const vector<unsigned int>& v)
+{
+  // unsigned, signed and floating point keys, repeated to past the point
+  // where sort goes by radix
+  vector<unsigned int> u;
+  vector<int> i;
+  vector<double> d;
+  for (size_t k = 0; !v.empty() && u.size() < 3000; ++k) {
+    auto x = v[k % v.size()] ^ static_cast<unsigned int>(k * 2654435761u);
+    u.push_back(x);
+    i.push_back(static_cast<int>(x));
+    d.push_back(static_cast<int>(x) / 1024.0);
+  }
+  auto su = u;
+  auto si = i;
+  auto sd = d;
+  sort(su.begin(), su.end());
+  sort(si.begin(), si.end());
+  sort(sd.begin(), sd.end());
+  auto ru = u;
+  auto ri = i;
+  auto rd = d;
+  acc::radix_sort(ru.begin(), ru.end());
+  acc::radix_sort(ri.begin(), ri.end());
+  acc::radix_sort(rd.begin(), rd.end());
+  acc::sort(u.begin(), u.end());
+  acc::sort(i.begin(), i.end(), less<int>{});
+  acc::sort(d.begin(), d.end());
+  return ru == su && ri == si && rd == sd && u == su && i == si && d == sd;
+}
+
+DEF_PROPERTY(RadixSortKey, SortingOps, const vector<unsigned int>& v)
+{
+  // by a key, and stable
+  struct event { int key; size_t order; };
+  vector<event> e;
+  for (size_t k = 0; k < v.size(); ++k) {
+    e.push_back({ static_cast<int>(v[k] % 64) - 32, k });
+  }
+  acc::radix_sort(e.begin(), e.end(), [] (const event& x) { return x.key; });
+  return is_sorted(e.cbegin(), e.cend(),
+                   [] (const event& a, const event& b) {
+                     return a.key < b.key || (a.key == b.key && a.order < b.order);
+                   });
+}
+
+DEF_TEST(RadixSortLarge, SortingOps)
+{
+  // past the point where the first pass is by the most significant byte,
+  // with keys that differ only in their low bytes
+  vector<unsigned long long> v(500000);
+  for (size_t k = 0; k < v.size(); ++k) {
+    v[k] = acc::hash_mix(k) % (k % 2 ? 1000ull : 1ull << 40);
+  }
+  auto w = v;
+  sort(w.begin(), w.end());
+  acc::radix_sort(v.begin(), v.end());
+  return v == w;
+}
+
+DEF_PROPERTY(PartialSort, SortingOps, vector<unsigned int> v, unsigned long int i)
+{
+  auto k = v.empty() ? 0 : static_cast<ptrdiff_t>(i % (v.size() + 1));
+  auto w = v;
+  sort(v.begin(), v.end());
+  acc::partial_sort(w.begin(), w.begin() + k, w.end());
+  return equal(w.begin(), w.begin() + k, v.begin())
+    && is_permutation(w.begin(), w.end(), v.begin());
+}
+
+DEF_TEST(PartialSortShapes, SortingOps)
+{
+  // small k, which the heap takes, or input that keeps displacing the
+  // heap's top, which goes to quickselect; middling k, which the threshold
+  // takes; and large k, which goes to quickselect from the start
+  bool ok = true;
+  for (int shape = 0; shape < shapes; ++shape) {
+    for (size_t k : { size_t{1}, size_t{10}, size_t{128}, size_t{300},
+                      size_t{1000}, size_t{10000} }) {
+      auto v = shaped(shape, 20000);
+      auto w = v;
+      sort(v.begin(), v.end());
+      acc::partial_sort(w.begin(), w.begin() + static_cast<ptrdiff_t>(k), w.end(),
+                        less<>{});
+      ok = ok && equal(w.begin(), w.begin() + static_cast<ptrdiff_t>(k), v.begin());
+      sort(w.begin(), w.end());
+      ok = ok && w == v;
+    }
+  }
+  return ok;
+}
+
+DEF_PROPERTY(PartialSortCopy, SortingOps, const vector<unsigned int>& v, unsigned long int i)
+{
+  // from input that's read once, to fewer places than elements and to more
+  forward_list<unsigned int> l(v.cbegin(), v.cend());
+  auto k = static_cast<size_t>(i % (v.size() + 2));
+  vector<unsigned int> d(k);
+  auto e = acc::partial_sort_copy(l.cbegin(), l.cend(), d.begin(), d.end());
+  vector<unsigned int> s(k);
+  auto f = partial_sort_copy(v.cbegin(), v.cend(), s.begin(), s.end());
+  return e - d.begin() == f - s.begin() && d == s;
+}
+
+DEF_TEST(PartialSortCopyShapes, SortingOps)
+{
+  // the heap in the destination, and the threshold in a buffer of 2k
+  bool ok = true;
+  for (int shape = 0; shape < shapes; ++shape) {
+    auto v = shaped(shape, 20000);
+    forward_list<unsigned int> l(v.cbegin(), v.cend());
+    for (size_t k : { size_t{10}, size_t{128}, size_t{1000}, size_t{10000},
+                      size_t{30000} }) {
+      vector<unsigned int> d(k);
+      auto e = acc::partial_sort_copy(l.cbegin(), l.cend(), d.begin(), d.end());
+      vector<unsigned int> s(k);
+      auto f = partial_sort_copy(v.cbegin(), v.cend(), s.begin(), s.end());
+      ok = ok && e - d.begin() == f - s.begin() && d == s;
+    }
+  }
+  return ok;
+}
+
 DEF_PROPERTY(StableSort, SortingOps, vector<unsigned int> v)
 {
   vector<unsigned int> w{v};
@@ -48,6 +240,134 @@ DEF_PROPERTY(StableSort, SortingOps, vector<unsigned int> v)
   return w == v;
 }
 
+namespace
+{
+  // records sorted on their low bits, so that stability shows, in the shapes
+  // that sorts see: random, sorted, reversed, a few runs, sorted with a few
+  // out of place, and sorted runs each followed by a descending one
+  constexpr int stable_shapes = 6;
+
+  struct record { unsigned int key; size_t order; };
+
+  vector<record> stable_shaped(int shape, size_t n)
+  {
+    vector<record> v(n);
+    for (size_t i = 0; i < n; ++i) {
+      auto x = static_cast<unsigned int>(i);
+      switch (shape) {
+        case 0: x = static_cast<unsigned int>(acc::hash_mix(i)); break;
+        case 1: break;
+        case 2: x = static_cast<unsigned int>(n - i); break;
+        case 3: x = static_cast<unsigned int>(i % (n / 5 + 1)); break;
+        case 4: if (i % 1000 == 0) x = static_cast<unsigned int>(acc::hash_mix(i)); break;
+        default: x = static_cast<unsigned int>(i % 500 < 250 ? i : n - i); break;
+      }
+      v[i] = { x << 1, i };
+    }
+    // some equal keys, where they don't cut descending runs short
+    if (shape != 2 && shape != 5) {
+      for (size_t i = 0; i + 1 < n; i += 7) v[i + 1].key = v[i].key;
+    }
+    return v;
+  }
+
+  bool stably_sorted(const vector<record>& v)
+  {
+    return is_sorted(v.cbegin(), v.cend(),
+                     [] (const record& a, const record& b) {
+                       return a.key < b.key || (a.key == b.key && a.order < b.order);
+                     });
+  }
+}
+
+DEF_TEST(StableSortShapes, SortingOps)
+{
+  // presorted input costs near n comparisons
+  const size_t n = 20000;
+  const size_t budget[stable_shapes] = {
+    2 * n * static_cast<size_t>(log2(n)), n, n, 4 * n, 2 * n, 3 * n };
+  bool ok = true;
+  for (int shape = 0; shape < stable_shapes; ++shape) {
+    auto v = stable_shaped(shape, n);
+    size_t comparisons = 0;
+    acc::stable_sort(v.begin(), v.end(),
+                     [&] (const record& a, const record& b) {
+                       ++comparisons;
+                       return a.key < b.key;
+                     });
+    ok = ok && stably_sorted(v) && comparisons < budget[shape];
+  }
+  return ok;
+}
+
+DEF_PROPERTY(StableSortRotating, SortingOps, const vector<unsigned int>& v)
+{
+  // without a buffer, as when it can't be allocated: merges by rotation
+  vector<record> r;
+  for (size_t i = 0; i < v.size(); ++i) r.push_back({ v[i] % 16, i });
+  auto cmp = [] (const record& a, const record& b) { return a.key < b.key; };
+  acc::detail::stable_sort(r.begin(), r.end(), cmp,
+                           static_cast<acc::detail::merge_buffer<record>*>(nullptr));
+  auto s = stable_shaped(5, 5000);
+  acc::detail::stable_sort(s.begin(), s.end(), cmp,
+                           static_cast<acc::detail::merge_buffer<record>*>(nullptr));
+  return stably_sorted(r) && stably_sorted(s);
+}
+
+namespace
+{
+  // a small grain forces tasks even for short test vectors
+  constexpr acc::execution::parallel_policy par4{4, 1};
+}
+
+DEF_PROPERTY(SortPar, SortingOps, vector<unsigned int> v)
+{
+  vector<unsigned int> w{v};
+  sort(v.begin(), v.end());
+  acc::sort(par4, w.begin(), w.end());
+  return w == v;
+}
+
+DEF_TEST(SortParShapes, SortingOps)
+{
+  // organ pipe, sorted, all equal and the rest: no quadratic partitions or
+  // deep recursion, with a grain small enough to reach the bottom in tasks
+  constexpr acc::execution::parallel_policy par{4, 16};
+  bool ok = true;
+  for (int shape = 0; shape < shapes; ++shape) {
+    auto v = shaped(shape, 100000);
+    auto w = v;
+    sort(v.begin(), v.end());
+    acc::sort(par, w.begin(), w.end(), less<>{});
+    ok = ok && w == v;
+  }
+  return ok;
+}
+
+DEF_PROPERTY(StableSortPar, SortingOps, vector<unsigned int> v)
+{
+  // compare on the low bits only, so that stability shows
+  auto cmp = [] (unsigned int a, unsigned int b) { return (a&7) < (b&7); };
+  vector<unsigned int> w{v};
+  stable_sort(v.begin(), v.end(), cmp);
+  acc::stable_sort(par4, w.begin(), w.end(), cmp);
+  return w == v;
+}
+
+DEF_TEST(StableSortParShapes, SortingOps)
+{
+  // tasks down to a small grain, all merging in parts of the one buffer
+  constexpr acc::execution::parallel_policy par{4, 256};
+  bool ok = true;
+  for (int shape = 0; shape < stable_shapes; ++shape) {
+    auto v = stable_shaped(shape, 20000);
+    acc::stable_sort(par, v.begin(), v.end(),
+                     [] (const record& a, const record& b) { return a.key < b.key; });
+    ok = ok && stably_sorted(v);
+  }
+  return ok;
+}
+
 DEF_PROPERTY(NthElement, SortingOps, vector<unsigned int> v, unsigned long int i)
 {
   if (v.empty()) return true;
@@ -67,3 +387,55 @@ DEF_PROPERTY(NthElement, SortingOps, vector<unsigned int> v, unsigned long int i
 
   return wnth - w.begin() == vnth - v.begin() && *wnth == *vnth;
 }
+
+DEF_TEST(NthElementShapes, SortingOps)
+{
+  bool ok = true;
+  for (int shape = 0; shape < shapes; ++shape) {
+    for (size_t k : { size_t{0}, size_t{3}, size_t{10000}, size_t{19999} }) {
+      auto v = shaped(shape, 20000);
+      auto w = v;
+      nth_element(v.begin(), v.begin() + k, v.end());
+      acc::nth_element(w.begin(), w.begin() + k, w.end());
+      auto nth = w[k];
+      ok = ok && nth == v[k]
+        && all_of(w.begin(), w.begin() + k, [&] (unsigned int a) { return a <= nth; })
+        && all_of(w.begin() + k, w.end(), [&] (unsigned int a) { return nth <= a; });
+    }
+  }
+  return ok;
+}
+
+DEF_PROPERTY(NthElementPar, SortingOps, vector<unsigned int> v, unsigned long int i)
+{
+  if (v.empty()) return true;
+  auto n = static_cast<vector<unsigned int>::difference_type>(i % v.size());
+
+  vector<unsigned int> w(v);
+  nth_element(v.begin(), v.begin() + n, v.end());
+  acc::nth_element(par4, w.begin(), w.begin() + n, w.end());
+
+  auto wnth = w.begin() + n;
+  return *wnth == v[static_cast<size_t>(n)]
+    && all_of(w.begin(), wnth, [&] (unsigned int a) { return a <= *wnth; })
+    && all_of(wnth, w.end(), [&] (unsigned int a) { return *wnth <= a; });
+}
+
+DEF_TEST(NthElementParShapes, SortingOps)
+{
+  constexpr acc::execution::parallel_policy par{4, 16};
+  bool ok = true;
+  for (int shape = 0; shape < shapes; ++shape) {
+    for (size_t k : { size_t{0}, size_t{3}, size_t{50000}, size_t{99999} }) {
+      auto v = shaped(shape, 100000);
+      auto w = v;
+      nth_element(v.begin(), v.begin() + k, v.end());
+      acc::nth_element(par, w.begin(), w.begin() + k, w.end(), less<>{});
+      auto nth = w[k];
+      ok = ok && nth == v[k]
+        && all_of(w.begin(), w.begin() + k, [&] (unsigned int a) { return a <= nth; })
+        && all_of(w.begin() + k, w.end(), [&] (unsigned int a) { return nth <= a; });
+    }
+  }
+  return ok;
+}
@@ -0,0 +1,146 @@
+#include <all.h>
+
+#include <testinator.h>
+
+#include "shards.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <list>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// ---------------------------------------------------------------------------
+// t_digest
+
+namespace
+{
+  // the distance, as a fraction of the values, between q and the quantiles
+  // that x could be
+  double rank_error(const vector<double>& sorted, double q, double x)
+  {
+    auto n = static_cast<double>(sorted.size());
+    auto lo = static_cast<double>(
+        lower_bound(sorted.cbegin(), sorted.cend(), x) - sorted.cbegin()) / n;
+    auto hi = static_cast<double>(
+        upper_bound(sorted.cbegin(), sorted.cend(), x) - sorted.cbegin()) / n;
+    return q < lo ? lo - q : q > hi ? q - hi : 0.0;
+  }
+
+  template <typename D>
+  bool accurate(const D& d, vector<double> v, double tolerance)
+  {
+    if (v.empty()) return d.empty() && d.count() == 0 && d.quantile(0.5) == 0;
+    sort(v.begin(), v.end());
+    bool ok = d.count() == v.size() && d.min() == v.front() && d.max() == v.back()
+      && d.quantile(0) == v.front() && d.quantile(1) == v.back();
+    double prev = v.front();
+    for (double q : { 0.001, 0.01, 0.1, 0.25, 0.5, 0.75, 0.9, 0.99, 0.999 }) {
+      auto x = d.quantile(q);
+      // the tolerance is tighter in the tails, as the scale function is
+      ok = ok && x >= prev && rank_error(v, q, x) <= tolerance * sqrt(q * (1 - q)) * 2;
+      prev = x;
+    }
+    return ok;
+  }
+
+  vector<double> doubles(const vector<unsigned int>& v)
+  {
+    return vector<double>(v.cbegin(), v.cend());
+  }
+}
+
+DEF_PROPERTY(Insert, TDigest, const vector<unsigned int>& v)
+{
+  auto w = doubles(v);
+  acc::t_digest<> d;
+  for (auto x : w) d.insert(x);
+  acc::t_digest<> b;
+  b.insert(w.cbegin(), w.cend());
+  list<unsigned int> l(v.cbegin(), v.cend());
+  acc::t_digest<> c;
+  c.insert(l.cbegin(), l.cend());
+  auto f = acc::accumulate(v.cbegin(), v.cend(), acc::t_digest<>{}, acc::insert_op{});
+  return accurate(d, w, 0.01) && b == d && c == d && f == d;
+}
+
+DEF_TEST(ConstQueries, TDigest)
+{
+  // values left in the buffer by single inserts: threads query a const
+  // digest without a lock, and agree with a compressed one
+  acc::t_digest<> d;
+  vector<double> v;
+  for (size_t i = 0; i < 700; ++i) {
+    v.push_back(static_cast<double>(i * 7919 % 1000));
+    d.insert(v.back());
+  }
+  acc::t_digest<> c;
+  c.insert(v.cbegin(), v.cend());
+  const auto& cd = d;
+  vector<double> medians(4);
+  vector<thread> threads;
+  for (size_t t = 0; t < medians.size(); ++t) {
+    threads.emplace_back([&, t] { medians[t] = cd.quantile(0.5) + cd.size(); });
+  }
+  for (auto& t : threads) t.join();
+  auto expected = c.quantile(0.5) + c.size();
+  return all_of(medians.cbegin(), medians.cend(),
+                [&] (double m) { return m == expected; })
+    && accurate(cd, v, 0.01) && cd == c;
+}
+
+DEF_TEST(Large, TDigest)
+{
+  vector<double> v(200000);
+  for (size_t i = 0; i < v.size(); ++i) {
+    // long-tailed, like latencies
+    auto u = static_cast<double>(i * 2654435761u % 1000003) / 1000003.0;
+    v[i] = -log1p(-u) * 10.0;
+  }
+  acc::t_digest<100> a;
+  acc::t_digest<500> b;
+  a.insert(v.cbegin(), v.cend());
+  b.insert(v.cbegin(), v.cend());
+  return accurate(a, v, 0.005) && accurate(b, v, 0.001)
+    && a.size() <= 101 && b.size() <= 501 && a.size() < b.size();
+}
+
+DEF_PROPERTY(Merge, TDigest, const vector<unsigned int>& v)
+{
+  auto w = doubles(v);
+  auto mid = w.cbegin() + static_cast<ptrdiff_t>(w.size() / 3);
+  acc::t_digest<> a, b;
+  a.insert(w.cbegin(), mid);
+  b.insert(mid, w.cend());
+  auto ab = a, ba = b;
+  ab.merge(b);
+  ba.merge(a);
+  acc::t_digest<> i;
+  i.merge(ab);
+  return accurate(ab, w, 0.01) && accurate(ba, w, 0.01) && i == ab;
+}
+
+DEF_TEST(ParallelReduce, TDigest)
+{
+  vector<double> v(100000);
+  for (size_t i = 0; i < v.size(); ++i) v[i] = static_cast<double>(i * 7919 % 100000);
+  auto m = test::merge(test::sharded(v.cbegin(), v.cend(), 8, acc::t_digest<>{}));
+  return accurate(m.reduced, v, 0.005) && accurate(m.accumulated, v, 0.005);
+}
+
+DEF_PROPERTY(SaveLoad, TDigest, const vector<unsigned int>& v)
+{
+  acc::t_digest<50> d;
+  d.insert(v.cbegin(), v.cend());
+  vector<char> out;
+  acc::save(out, d);
+  acc::save(out, acc::t_digest<50>{});
+  const char* p = out.data();
+  auto end = p + out.size();
+  auto e = acc::load<acc::t_digest<50>>(p, end);
+  auto f = acc::load<acc::t_digest<50>>(p, end);
+  return e == d && f == acc::t_digest<50>{} && p == end;
+}
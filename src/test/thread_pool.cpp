@@ -0,0 +1,67 @@
+#include <all.h>
+
+#include <testinator.h>
+
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+using namespace std;
+
+// ---------------------------------------------------------------------------
+// thread_pool
+
+namespace
+{
+  unsigned int fib(unsigned int n)
+  {
+    if (n < 2) return n;
+    unsigned int a = 0;
+    unsigned int b = 0;
+    acc::fork_join([&] { a = fib(n-1); }, [&] { b = fib(n-2); });
+    return a + b;
+  }
+}
+
+DEF_TEST(Spawn, ThreadPool)
+{
+  atomic<int> n{0};
+  acc::task_group g;
+  for (int i = 0; i < 1000; ++i) g.spawn([&] { ++n; });
+  g.sync();
+  return n == 1000;
+}
+
+DEF_TEST(Nested, ThreadPool)
+{
+  return fib(20) == 6765;
+}
+
+DEF_TEST(OwnPool, ThreadPool)
+{
+  acc::thread_pool pool(3);
+  vector<int> v(64, 0);
+  acc::task_group g(pool);
+  for (size_t i = 0; i < v.size(); ++i) {
+    g.spawn([&v, i] { v[i] = static_cast<int>(i); });
+  }
+  g.sync();
+  for (size_t i = 0; i < v.size(); ++i) {
+    if (v[i] != static_cast<int>(i)) return false;
+  }
+  return pool.size() == 3;
+}
+
+DEF_TEST(Exception, ThreadPool)
+{
+  atomic<int> n{0};
+  acc::task_group g;
+  g.spawn([] { throw runtime_error("task"); });
+  g.spawn([&] { ++n; });
+  try {
+    g.sync();
+  } catch (const runtime_error&) {
+    return n == 1;
+  }
+  return false;
+}
@@ -0,0 +1,102 @@
+#include <all.h>
+
+#include <testinator.h>
+
+#include "shards.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+// ---------------------------------------------------------------------------
+// top_n
+
+namespace
+{
+  // the n greatest of v by cmp, greatest first
+  template <typename T, typename Compare = less<>>
+  vector<T> expected(vector<T> v, size_t n, Compare cmp = Compare{})
+  {
+    sort(v.begin(), v.end(), [&] (const T& a, const T& b) { return cmp(b, a); });
+    v.resize(min(n, v.size()));
+    return v;
+  }
+}
+
+DEF_PROPERTY(Insert, TopN, const vector<unsigned int>& v)
+{
+  acc::top_n<unsigned int, 10> t;
+  for (auto x : v) t.insert(x);
+  acc::top_n<unsigned int, 10, greater<>> b;
+  for (auto x : v) b.insert(x);
+  return t.values() == expected(v, 10)
+    && b.values() == expected(v, 10, greater<>{})
+    && t.size() == min<size_t>(v.size(), 10);
+}
+
+DEF_PROPERTY(Batch, TopN, const vector<unsigned int>& v)
+{
+  // the threshold scan, the generic batch and a fold with insert_op agree
+  acc::top_n<unsigned int, 5> a;
+  a.insert(v.cbegin(), v.cend());
+  acc::top_n<unsigned int, 5, greater<>> b;
+  b.insert(v.cbegin(), v.cend());
+
+  vector<double> w(v.cbegin(), v.cend());
+  acc::top_n<double, 5> c;
+  c.insert(w.cbegin(), w.cend());
+
+  auto d = acc::accumulate(v.cbegin(), v.cend(),
+                           acc::top_n<unsigned int, 5>{}, acc::insert_op{});
+  return a.values() == expected(v, 5)
+    && b.values() == expected(v, 5, greater<>{})
+    && c.values() == expected(w, 5)
+    && d == a;
+}
+
+DEF_PROPERTY(Strings, TopN, const vector<unsigned int>& v)
+{
+  vector<pair<unsigned int, string>> w;
+  for (auto x : v) w.emplace_back(x, to_string(x));
+  acc::top_n<pair<unsigned int, string>, 3> t;
+  t.insert(w.cbegin(), w.cend());
+  return t.values() == expected(w, 3);
+}
+
+DEF_PROPERTY(Merge, TopN, const vector<unsigned int>& v)
+{
+  auto mid = v.cbegin() + static_cast<ptrdiff_t>(v.size() / 3);
+  acc::top_n<unsigned int, 8> a, b;
+  a.insert(v.cbegin(), mid);
+  b.insert(mid, v.cend());
+  auto ab = a, ba = b;
+  ab.merge(b);
+  ba.merge(a);
+  return ab.values() == expected(v, 8) && ab == ba;
+}
+
+DEF_TEST(ParallelReduce, TopN)
+{
+  vector<unsigned int> v(100000);
+  for (size_t i = 0; i < v.size(); ++i) v[i] = static_cast<unsigned int>(i * 2654435761u);
+  using T = acc::top_n<unsigned int, 100>;
+  auto m = test::merge(test::sharded(v.cbegin(), v.cend(), 8, T{}));
+  return m.reduced.values() == expected(v, 100) && m.accumulated == m.reduced
+    && m.reduced.threshold() == expected(v, 100).back();
+}
+
+DEF_PROPERTY(SaveLoad, TopN, const vector<unsigned int>& v)
+{
+  acc::top_n<unsigned int, 7> t;
+  t.insert(v.cbegin(), v.cend());
+  vector<char> out;
+  acc::save(out, t);
+  const char* p = out.data();
+  auto u = acc::load<acc::top_n<unsigned int, 7>>(p, p + out.size());
+  return u == t;
+}